@@ -0,0 +1,286 @@
+#include "BatchHighlighter.h"
+#include "StyleCache.h"
+
+#include <QRunnable>
+#include <QTextStream>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+
+#include <cstdio>
+
+// Подсветка одного файла общим движком; разметка участков подготовлена заранее.
+class BatchHighlightTask : public QRunnable {
+public:
+    BatchHighlightTask(BatchHighlighter *owner, int index)
+        : owner(owner), index(index), fileName(owner->files.at(index)) {}
+
+    void run() override {
+        QByteArray output;
+        qint64 inputSize = -1;
+
+        QFile file(fileName);
+        if (file.open(QFile::ReadOnly | QFile::Text)) {
+            inputSize = file.size();
+            QTextStream in(&file);
+            output = render(in.readAll());
+        }
+
+        BatchHighlighter *receiver = owner;
+        const int fileIndex = index;
+        QMetaObject::invokeMethod(receiver, [receiver, fileIndex, output, inputSize]() {
+            receiver->fileHighlighted(fileIndex, output, inputSize);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QByteArray render(const QString &text) const {
+        const bool isHtml = owner->format == BatchHighlighter::Html;
+        QString out;
+        out.reserve(text.size() * 2);
+
+        QVector<HighlightEngine::Span> spans;
+        QVector<qint8> kinds;
+        int state = 0;
+        int lineStart = 0;
+        while (lineStart <= text.size()) {
+            int lineEnd = text.indexOf('\n', lineStart);
+            if (lineEnd < 0)
+                lineEnd = text.size();
+            const QString line = text.mid(lineStart, lineEnd - lineStart);
+
+            // Вид каждого символа; более поздний участок перекрывает более ранние, как в редакторе.
+            spans.clear();
+            state = owner->engine.highlightLine(line, state, spans);
+            kinds.fill(-1, line.size());
+            for (const HighlightEngine::Span &span : spans) {
+                for (int i = span.start; i < qMin(span.start + span.length, line.size()); ++i)
+                    kinds[i] = qint8(span.kind);
+            }
+
+            int start = 0;
+            while (start < line.size()) {
+                int end = start + 1;
+                while (end < line.size() && kinds.at(end) == kinds.at(start))
+                    ++end;
+                const QString part = line.mid(start, end - start);
+                const int kind = kinds.at(start);
+                if (kind >= 0)
+                    out += owner->markupOpen[kind];
+                out += isHtml ? part.toHtmlEscaped() : part;
+                if (kind >= 0)
+                    out += owner->markupClose[kind];
+                start = end;
+            }
+
+            if (lineEnd == text.size())
+                break;
+            out += '\n';
+            lineStart = lineEnd + 1;
+        }
+
+        // Перевод строки в конце текста уже выведен; недостающий добавляется, чтобы вывод им заканчивался.
+        if (!text.isEmpty() && !text.endsWith('\n'))
+            out += '\n';
+        return out.toUtf8();
+    }
+
+private:
+    BatchHighlighter *owner;
+    int index;
+    QString fileName;
+};
+
+BatchHighlighter::BatchHighlighter(QObject *parent) : QObject(parent) {
+    format = Html;
+    languageVersion = LanguageVersion::C89;
+    nextFile = 0;
+    nextOutput = 0;
+    exitCode = 0;
+    inputBytes = 0;
+    setStyle("Default");
+}
+
+BatchHighlighter::~BatchHighlighter() {
+    pool.waitForDone();
+}
+
+void BatchHighlighter::setFormat(Format newFormat) {
+    format = newFormat;
+}
+
+bool BatchHighlighter::setStyle(const QString &styleName, QString *errorMessage) {
+    if (QFileInfo::exists(styleName))
+        return StyleCache::instance()->load(styleName, &style, errorMessage);
+
+    QFile file(":Styles/" + styleName + ".json");
+    if (!file.open(QFile::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = file.errorString();
+        return false;
+    }
+    return StyleJson::read(file.readAll(), &style, errorMessage);
+}
+
+void BatchHighlighter::setLanguageVersion(LanguageVersion version) {
+    languageVersion = version;
+}
+
+void BatchHighlighter::setOutputDirectory(const QString &directory) {
+    outputDirectory = directory;
+}
+
+void BatchHighlighter::setThreadCount(int count) {
+    pool.setMaxThreadCount(qMax(1, count));
+}
+
+void BatchHighlighter::start(const QStringList &newFiles) {
+    files = newFiles;
+    nextFile = 0;
+    nextOutput = 0;
+    exitCode = 0;
+    inputBytes = 0;
+    timer.start();
+
+    engine = HighlightEngine(style, languageVersion);
+    updateMarkup();
+
+    if (outputDirectory.isEmpty()) {
+        standardOutput.open(stdout, QIODevice::WriteOnly);
+        standardOutput.write(header());
+    } else {
+        QDir().mkpath(outputDirectory);
+    }
+
+    submitFiles();
+    writeReady();
+}
+
+void BatchHighlighter::updateMarkup() {
+    for (int kind = 0; kind < HighlightEngine::TokenKindCount; ++kind) {
+        const QTextCharFormat charFormat = engine.format(HighlightEngine::TokenKind(kind));
+        const bool hasForeground = charFormat.foreground().style() != Qt::NoBrush;
+        const bool hasBackground = charFormat.background().style() != Qt::NoBrush;
+        const QColor foreground = charFormat.foreground().color();
+        const QColor background = charFormat.background().color();
+
+        if (format == Html) {
+            QString css;
+            if (hasForeground)
+                css += "color:" + foreground.name() + ";";
+            if (hasBackground)
+                css += "background-color:" + background.name() + ";";
+            if (charFormat.fontWeight() > QFont::Normal)
+                css += "font-weight:bold;";
+            if (charFormat.fontItalic())
+                css += "font-style:italic;";
+            if (charFormat.fontUnderline())
+                css += "text-decoration:underline;";
+            markupOpen[kind] = css.isEmpty() ? QString() : "<span style=\"" + css + "\">";
+            markupClose[kind] = css.isEmpty() ? QString() : "</span>";
+        } else {
+            QStringList codes;
+            if (hasForeground)
+                codes << QString("38;2;%1;%2;%3").arg(foreground.red()).arg(foreground.green()).arg(foreground.blue());
+            if (hasBackground)
+                codes << QString("48;2;%1;%2;%3").arg(background.red()).arg(background.green()).arg(background.blue());
+            if (charFormat.fontWeight() > QFont::Normal)
+                codes << "1";
+            if (charFormat.fontItalic())
+                codes << "3";
+            if (charFormat.fontUnderline())
+                codes << "4";
+            markupOpen[kind] = codes.isEmpty() ? QString() : "\x1b[" + codes.join(';') + "m";
+            markupClose[kind] = codes.isEmpty() ? QString() : "\x1b[0m";
+        }
+    }
+}
+
+void BatchHighlighter::submitFiles() {
+    const int maxInFlight = 2 * pool.maxThreadCount();
+    while (nextFile < files.size() && nextFile - nextOutput < maxInFlight) {
+        pool.start(new BatchHighlightTask(this, nextFile));
+        ++nextFile;
+    }
+}
+
+void BatchHighlighter::fileHighlighted(int index, const QByteArray &output, qint64 inputSize) {
+    if (inputSize < 0) {
+        qWarning("Cannot read file %s", qPrintable(QDir::toNativeSeparators(files.at(index))));
+        failed.insert(index);
+        exitCode = 1;
+    } else {
+        inputBytes += inputSize;
+    }
+    ready.insert(index, output);
+
+    writeReady();
+    submitFiles();
+}
+
+void BatchHighlighter::writeReady() {
+    while (ready.contains(nextOutput)) {
+        const QByteArray output = ready.take(nextOutput);
+        if (!failed.remove(nextOutput) && !writeOutput(nextOutput, output))
+            exitCode = 1;
+        ++nextOutput;
+    }
+
+    if (nextOutput < files.size())
+        return;
+
+    if (outputDirectory.isEmpty()) {
+        standardOutput.write(footer());
+        standardOutput.flush();
+    }
+
+    // Сводка пишется в stderr: stdout занят результатом, а qDebug отключается в сборках с QT_NO_DEBUG_OUTPUT.
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    fprintf(stderr, "Batch: %d files, %.2f MB in %.3f s (%.2f MB/s, %d threads)\n",
+            files.size(), inputBytes / 1e6, seconds,
+            seconds > 0 ? inputBytes / 1e6 / seconds : 0.0, pool.maxThreadCount());
+    fflush(stderr);
+    emit finished(exitCode);
+}
+
+QByteArray BatchHighlighter::header() const {
+    if (format == Ansi)
+        return QByteArray();
+    return "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n</head>\n<body>\n";
+}
+
+QByteArray BatchHighlighter::footer() const {
+    if (format == Ansi)
+        return QByteArray();
+    return "</body>\n</html>\n";
+}
+
+bool BatchHighlighter::writeOutput(int index, const QByteArray &output) {
+    const QString fileName = files.at(index);
+
+    if (outputDirectory.isEmpty()) {
+        // В общем выводе каждый файл начинается с заголовка с его именем.
+        QByteArray title;
+        if (format == Html) {
+            title = "<h4>" + fileName.toHtmlEscaped().toUtf8() + "</h4>\n<pre>\n";
+        } else if (files.size() > 1) {
+            title = "==> " + fileName.toUtf8() + " <==\n";
+        }
+        const QByteArray end = format == Html ? "</pre>\n" : "";
+        return standardOutput.write(title) >= 0 && standardOutput.write(output) >= 0
+                && standardOutput.write(end) >= 0;
+    }
+
+    const QString suffix = format == Html ? ".html" : ".ansi";
+    QFile file(QDir(outputDirectory).filePath(QFileInfo(fileName).fileName() + suffix));
+    if (!file.open(QFile::WriteOnly)) {
+        qWarning("Cannot write file %s", qPrintable(QDir::toNativeSeparators(file.fileName())));
+        return false;
+    }
+    if (format == Html)
+        file.write(header() + "<pre>\n");
+    file.write(output);
+    if (format == Html)
+        file.write("</pre>\n" + footer());
+    return file.error() == QFile::NoError;
+}
@@ -0,0 +1,92 @@
+#ifndef BATCHHIGHLIGHTER_H
+#define BATCHHIGHLIGHTER_H
+
+#include "HighlightEngine.h"
+
+#include <QObject>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QStringList>
+#include <QString>
+#include <QMap>
+#include <QSet>
+#include <QFile>
+
+// Подсветка файлов без окна редактора (ключ --batch): файлы подсвечиваются общим HighlightEngine
+// в пуле потоков и выводятся в HTML или в терминал (ANSI).
+// Результаты выводятся по мере готовности в порядке файлов; одновременно в работе не больше
+// двух файлов на поток, поэтому память не растет с числом файлов.
+class BatchHighlighter : public QObject {
+    Q_OBJECT
+
+public:
+    enum Format {
+        Html,
+        Ansi
+    };
+
+    BatchHighlighter(QObject *parent = nullptr);
+
+    ~BatchHighlighter();
+
+    void setFormat(Format format);
+
+    // Встроенный стиль (Default, ATB) или путь к JSON-файлу стиля; false, если стиль не прочитан.
+    bool setStyle(const QString &style, QString *errorMessage = nullptr);
+
+    void setLanguageVersion(LanguageVersion version);
+
+    // Каталог для файлов <имя>.html / <имя>.ansi; без каталога все файлы выводятся в stdout.
+    void setOutputDirectory(const QString &directory);
+
+    void setThreadCount(int count);
+
+    void start(const QStringList &files);
+
+signals:
+    // Все файлы выведены; exitCode не равен 0, если какой-то файл не прочитан или не записан.
+    void finished(int exitCode);
+
+private:
+    friend class BatchHighlightTask;
+
+    void updateMarkup();
+
+    void submitFiles();
+
+    void fileHighlighted(int index, const QByteArray &output, qint64 inputSize);
+
+    QByteArray header() const;
+
+    QByteArray footer() const;
+
+    void writeReady();
+
+    bool writeOutput(int index, const QByteArray &output);
+
+private:
+    QThreadPool pool;
+    Format format;
+    LanguageVersion languageVersion;
+    Style style;
+    HighlightEngine engine;
+    // Разметка начала и конца участка каждого вида в формате вывода.
+    QString markupOpen[HighlightEngine::TokenKindCount];
+    QString markupClose[HighlightEngine::TokenKindCount];
+    QString outputDirectory;
+
+    QStringList files;
+    int nextFile;
+    int nextOutput;
+    // Готовые файлы, ожидающие вывода предыдущих.
+    QMap<int, QByteArray> ready;
+    QSet<int> failed;
+
+    QFile standardOutput;
+    int exitCode;
+    qint64 inputBytes;
+    QElapsedTimer timer;
+};
+
+#endif // BATCHHIGHLIGHTER_H
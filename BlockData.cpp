@@ -0,0 +1,45 @@
+#include "BlockData.h"
+#include "DocumentStatistics.h"
+#include "SymbolIndex.h"
+#include "IdentifierIndex.h"
+#include "LayoutBudget.h"
+
+BlockData::BlockData() {
+    wordCount = -1;
+    isAsciiText = false;
+    textRevision = -1;
+    for (int kind = 0; kind < BracketKindCount; ++kind) {
+        bracketOpen[kind] = 0;
+        bracketClose[kind] = 0;
+    }
+    isFolded = false;
+    isFoldHidden = false;
+    isFilteredOut = false;
+    modifiedEpoch = 0;
+    isHighlightSkipped = false;
+    tokenRevision = 0;
+    isLayoutResident = false;
+    isRecentlyShown = false;
+    residentBytes = 0;
+}
+
+BlockData::~BlockData() {
+    // Удаленная строка больше не учитывается в статистике документа.
+    if (statistics)
+        statistics->blockDataDestroyed(this);
+    if (symbolIndex)
+        symbolIndex->blockDataDestroyed(this);
+    if (identifierIndex)
+        identifierIndex->blockDataDestroyed(this);
+    if (layoutBudget)
+        layoutBudget->blockDataDestroyed(this);
+}
+
+BlockData* BlockData::get(QTextBlock block) {
+    BlockData *data = static_cast<BlockData*>(block.userData());
+    if (!data) {
+        data = new BlockData;
+        block.setUserData(data);
+    }
+    return data;
+}
@@ -0,0 +1,112 @@
+#ifndef BLOCKDATA_H
+#define BLOCKDATA_H
+
+#include <QTextBlockUserData>
+#include <QTextBlock>
+#include <QPointer>
+#include <QVector>
+#include <QByteArray>
+
+class DocumentStatistics;
+class SymbolIndex;
+class IdentifierIndex;
+class LayoutBudget;
+
+// Данные, вычисляемые для отдельного блока (строки) документа и хранящиеся вместе с ним.
+// Блок владеет своими данными: при удалении блока данные удаляются документом.
+class BlockData : public QTextBlockUserData {
+public:
+    // Класс лексемы для миникарты.
+    enum TokenClass {
+        NoToken,        // пробел
+        PlainToken,
+        KeywordToken,
+        ClassToken,
+        QuotationToken,
+        IncludeToken,
+        FunctionToken,
+        CommentToken,
+        SearchToken,
+        TokenClassCount
+    };
+
+    // Классы лексем записываются только для первых TokenColumns символов строки.
+    static const int TokenColumns = 120;
+
+    enum BracketKind {
+        Brace,      // { }
+        Paren,      // ( )
+        Square,     // [ ]
+        BracketKindCount
+    };
+
+    BlockData();
+
+    ~BlockData() override;
+
+    // Данные блока; создаются при первом обращении.
+    static BlockData* get(QTextBlock block);
+
+public:
+    // Символ строки (функция или класс), найденный подсветкой.
+    struct Symbol {
+        int nameId;     // номер имени в SymbolIndex
+        int kind;       // SymbolIndex::Kind
+        int column;
+
+        bool operator==(const Symbol &other) const {
+            return nameId == other.nameId && kind == other.kind && column == other.column;
+        }
+    };
+
+    // Количество слов в строке; -1 - еще не подсчитано.
+    int wordCount;
+
+    // Строка состоит только из печатных символов ASCII (проверено для ревизии textRevision).
+    bool isAsciiText;
+    int textRevision;
+
+    // Незакрытые открывающие и непарные закрывающие скобки строки (вне комментариев и строк)
+    // для каждого вида скобок BracketKind.
+    int bracketOpen[BracketKindCount];
+    int bracketClose[BracketKindCount];
+
+    // Строка начинает свернутый фрагмент.
+    bool isFolded;
+
+    // Строка скрыта: внутри свернутого фрагмента или отброшена фильтром строк.
+    bool isFoldHidden;
+    bool isFilteredOut;
+
+    // Строка изменена с открытия или сохранения, если номер совпадает с текущим номером ModifiedLines.
+    int modifiedEpoch;
+
+    // Строка была скрыта при подсветке и подсвечена не полностью
+    // или ее форматы выгружены LayoutBudget.
+    bool isHighlightSkipped;
+
+    // Символы строки и индекс, в который они внесены (при удалении блока они удаляются из индекса).
+    QVector<Symbol> symbols;
+    QPointer<SymbolIndex> symbolIndex;
+
+    // Классы лексем строки тройками байт (начало, длина, класс), пробелы не записываются.
+    // tokenRevision меняется при каждом изменении tokenRuns.
+    QByteArray tokenRuns;
+    int tokenRevision;
+
+    // Идентификаторы строки (номера слов IdentifierIndex) и индекс, в котором они учтены.
+    QVector<int> identifiers;
+    QPointer<IdentifierIndex> identifierIndex;
+
+    // Статистика, в которую учтены счетчики блока (при удалении блока они вычитаются).
+    QPointer<DocumentStatistics> statistics;
+
+    // Разметка и форматы строки учтены в бюджете памяти (residentBytes - их оценка);
+    // isRecentlyShown - строка показана после прошлого обхода бюджета.
+    bool isLayoutResident;
+    bool isRecentlyShown;
+    int residentBytes;
+    QPointer<LayoutBudget> layoutBudget;
+};
+
+#endif // BLOCKDATA_H
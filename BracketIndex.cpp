@@ -0,0 +1,424 @@
+#include "BracketIndex.h"
+
+#include <algorithm>
+
+BracketIndex::BracketIndex(QTextDocument *document) : QObject(document), document(document) {
+    indexedBlockCount = -1;
+    bucketCount = 0;
+    leafCount = 0;
+}
+
+BracketIndex* BracketIndex::forDocument(QTextDocument *document) {
+    BracketIndex *index = document->findChild<BracketIndex*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!index)
+        index = new BracketIndex(document);
+    return index;
+}
+
+void BracketIndex::blockChanged(int blockNumber) {
+    if (bucketCount == 0)
+        return;
+
+    // Первая строка, подсвеченная после правки, - строка, с которой правка началась:
+    // добавленные или удаленные правкой строки относятся к ее корзине и следующим за ней.
+    const int blockCount = document->blockCount();
+    if (blockCount != indexedBlockCount) {
+        moveBlocks(blockNumber, blockCount - indexedBlockCount);
+        if (bucketCount == 0)
+            return;
+        indexedBlockCount = blockCount;
+    }
+    markDirty(bucketOf(blockNumber));
+}
+
+int BracketIndex::matchingBracket(int position) {
+    QTextBlock block = document->findBlock(position);
+    if (!block.isValid())
+        return -1;
+
+    const int offset = position - block.position();
+    for (const CodeFolding::Bracket &bracket : blockBrackets(block)) {
+        if (bracket.position == offset)
+            return bracket.isOpen ? matchForward(block, bracket) : matchBackward(block, bracket);
+    }
+    return -1;
+}
+
+qint64 BracketIndex::memoryUsage() const {
+    qint64 bytes = sizeof(BracketIndex) + dirty.size() / 8 + (dirtyBuckets.capacity() + counts.capacity()) * sizeof(int);
+    for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+        bytes += tree[kind].capacity() * sizeof(Summary);
+    return bytes;
+}
+
+BracketIndex::Summary BracketIndex::combine(const Summary &left, const Summary &right) {
+    // Закрывающие скобки правой части сначала закрывают открытые скобки левой.
+    Summary result;
+    result.close = left.close + qMax(0, right.close - left.open);
+    result.open = right.open + qMax(0, left.open - right.close);
+    return result;
+}
+
+BracketIndex::Summary BracketIndex::blockSummary(const QTextBlock &block, int kind) {
+    const BlockData *data = static_cast<const BlockData*>(block.userData());
+    if (!data)
+        return { 0, 0 };
+    return { data->bracketClose[kind], data->bracketOpen[kind] };
+}
+
+void BracketIndex::update() {
+    // Корзин, опустевших после удаления строк, стало слишком много: индекс строится заново.
+    const int blockCount = document->blockCount();
+    if (blockCount != indexedBlockCount || bucketCount > 2 * (blockCount / BucketSize + 1)) {
+        rebuild();
+        return;
+    }
+
+    for (int bucket : dirtyBuckets) {
+        updateBucket(bucket);
+        dirty.clearBit(bucket);
+    }
+    dirtyBuckets.clear();
+}
+
+void BracketIndex::rebuild() {
+    indexedBlockCount = document->blockCount();
+    bucketCount = (indexedBlockCount + BucketSize - 1) / BucketSize;
+    leafCount = 1;
+    while (leafCount < bucketCount)
+        leafCount *= 2;
+
+    dirty.fill(false, leafCount);
+    dirtyBuckets.clear();
+
+    QTextBlock block = document->firstBlock();
+    for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+        tree[kind].fill({ 0, 0 }, 2 * leafCount);
+    counts.fill(0, 2 * leafCount);
+
+    for (int bucket = 0; bucket < bucketCount; ++bucket) {
+        Summary sums[BlockData::BracketKindCount] = {};
+        int size = 0;
+        for (; size < BucketSize && block.isValid(); ++size, block = block.next()) {
+            for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+                sums[kind] = combine(sums[kind], blockSummary(block, kind));
+        }
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+            tree[kind][leafCount + bucket] = sums[kind];
+        counts[leafCount + bucket] = size;
+    }
+    buildNodes();
+}
+
+void BracketIndex::buildNodes() {
+    for (int node = leafCount - 1; node >= 1; --node) {
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+            tree[kind][node] = combine(tree[kind].at(2 * node), tree[kind].at(2 * node + 1));
+        counts[node] = counts.at(2 * node) + counts.at(2 * node + 1);
+    }
+}
+
+void BracketIndex::updateBucket(int bucket) {
+    Summary sums[BlockData::BracketKindCount] = {};
+    QTextBlock block = document->findBlockByNumber(bucketStart(bucket));
+    const int size = bucketSize(bucket);
+    for (int i = 0; i < size && block.isValid(); ++i, block = block.next()) {
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+            sums[kind] = combine(sums[kind], blockSummary(block, kind));
+    }
+
+    for (int kind = 0; kind < BlockData::BracketKindCount; ++kind) {
+        int node = leafCount + bucket;
+        tree[kind][node] = sums[kind];
+        for (node /= 2; node >= 1; node /= 2)
+            tree[kind][node] = combine(tree[kind].at(2 * node), tree[kind].at(2 * node + 1));
+    }
+}
+
+void BracketIndex::markDirty(int bucket) {
+    if (!dirty.testBit(bucket)) {
+        dirty.setBit(bucket);
+        dirtyBuckets.append(bucket);
+    }
+}
+
+void BracketIndex::moveBlocks(int blockNumber, int delta) {
+    // Вставка большого фрагмента (например, загрузка текста) дешевле построения заново.
+    if (delta > BucketSize) {
+        bucketCount = 0;
+        indexedBlockCount = -1;
+        return;
+    }
+
+    int bucket = bucketOf(blockNumber);
+    if (delta > 0) {
+        setBucketSize(bucket, bucketSize(bucket) + delta);
+        markDirty(bucket);
+        if (bucketSize(bucket) > 2 * BucketSize)
+            splitBucket(bucket);
+        return;
+    }
+
+    // Удаляются строки, следующие за blockNumber: сначала из его корзины, затем из следующих.
+    int removed = -delta;
+    int available = qMax(0, bucketStart(bucket) + bucketSize(bucket) - 1 - blockNumber);
+    while (removed > 0 && bucket < bucketCount) {
+        const int count = qMin(removed, available);
+        setBucketSize(bucket, bucketSize(bucket) - count);
+        markDirty(bucket);
+        removed -= count;
+        if (++bucket < bucketCount)
+            available = bucketSize(bucket);
+    }
+    if (removed > 0) {
+        bucketCount = 0;
+        indexedBlockCount = -1;
+    }
+}
+
+void BracketIndex::splitBucket(int bucket) {
+    if (bucketCount == leafCount) {
+        // Листьев не хватает: дерево удваивается, итоги корзин переносятся без пересчета.
+        const int newLeafCount = 2 * leafCount;
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind) {
+            QVector<Summary> leaves = tree[kind].mid(leafCount, leafCount);
+            tree[kind].fill({ 0, 0 }, 2 * newLeafCount);
+            std::copy(leaves.begin(), leaves.end(), tree[kind].begin() + newLeafCount);
+        }
+        QVector<int> sizes = counts.mid(leafCount, leafCount);
+        counts.fill(0, 2 * newLeafCount);
+        std::copy(sizes.begin(), sizes.end(), counts.begin() + newLeafCount);
+        dirty.resize(newLeafCount);
+        leafCount = newLeafCount;
+    }
+
+    // Корзины после разделяемой сдвигаются на одну; их итоги не меняются.
+    for (int i = bucketCount; i > bucket + 1; --i) {
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind)
+            tree[kind][leafCount + i] = tree[kind].at(leafCount + i - 1);
+        counts[leafCount + i] = counts.at(leafCount + i - 1);
+    }
+    ++bucketCount;
+
+    dirty.fill(false);
+    for (int &dirtyBucket : dirtyBuckets) {
+        if (dirtyBucket > bucket)
+            ++dirtyBucket;
+        dirty.setBit(dirtyBucket);
+    }
+
+    const int size = counts.at(leafCount + bucket);
+    counts[leafCount + bucket] = size / 2;
+    counts[leafCount + bucket + 1] = size - size / 2;
+    buildNodes();
+    markDirty(bucket + 1);
+}
+
+int BracketIndex::bucketSize(int bucket) const {
+    return counts.at(leafCount + bucket);
+}
+
+void BracketIndex::setBucketSize(int bucket, int size) {
+    int node = leafCount + bucket;
+    counts[node] = size;
+    for (node /= 2; node >= 1; node /= 2)
+        counts[node] = counts.at(2 * node) + counts.at(2 * node + 1);
+}
+
+int BracketIndex::bucketOf(int blockNumber) const {
+    if (blockNumber >= counts.at(1))
+        return bucketCount - 1;
+
+    int node = 1;
+    while (node < leafCount) {
+        if (blockNumber < counts.at(2 * node)) {
+            node = 2 * node;
+        } else {
+            blockNumber -= counts.at(2 * node);
+            node = 2 * node + 1;
+        }
+    }
+    return node - leafCount;
+}
+
+int BracketIndex::bucketStart(int bucket) const {
+    // Сумма размеров корзин левее: левые братья узлов на пути от листа к корню.
+    int start = 0;
+    for (int node = leafCount + bucket; node > 1; node /= 2) {
+        if (node % 2 == 1)
+            start += counts.at(node - 1);
+    }
+    return start;
+}
+
+int BracketIndex::findForward(int kind, int node, int nodeFrom, int nodeTo, int from, Summary &acc) const {
+    if (nodeTo <= from)
+        return -1;
+
+    if (nodeFrom >= from) {
+        // Поддерево, закрывающее меньше acc.open скобок, пропускается целиком.
+        const Summary &sums = tree[kind].at(node);
+        if (sums.close < acc.open) {
+            acc = combine(acc, sums);
+            return -1;
+        }
+        if (nodeTo - nodeFrom == 1)
+            return nodeFrom;
+    }
+
+    const int middle = (nodeFrom + nodeTo) / 2;
+    int bucket = findForward(kind, 2 * node, nodeFrom, middle, from, acc);
+    if (bucket < 0)
+        bucket = findForward(kind, 2 * node + 1, middle, nodeTo, from, acc);
+    return bucket;
+}
+
+int BracketIndex::findBackward(int kind, int node, int nodeFrom, int nodeTo, int to, Summary &acc) const {
+    if (nodeFrom > to)
+        return -1;
+
+    if (nodeTo - 1 <= to) {
+        const Summary &sums = tree[kind].at(node);
+        if (sums.open < acc.close) {
+            acc = combine(sums, acc);
+            return -1;
+        }
+        if (nodeTo - nodeFrom == 1)
+            return nodeFrom;
+    }
+
+    const int middle = (nodeFrom + nodeTo) / 2;
+    int bucket = findBackward(kind, 2 * node + 1, middle, nodeTo, to, acc);
+    if (bucket < 0)
+        bucket = findBackward(kind, 2 * node, nodeFrom, middle, to, acc);
+    return bucket;
+}
+
+int BracketIndex::matchForward(const QTextBlock &block, const CodeFolding::Bracket &bracket) {
+    const int kind = bracket.kind;
+
+    // Сначала пара ищется в той же строке.
+    int depth = 0;
+    for (const CodeFolding::Bracket &other : blockBrackets(block)) {
+        if (other.kind != kind || other.position < bracket.position)
+            continue;
+        depth += other.isOpen ? 1 : -1;
+        if (depth == 0)
+            return block.position() + other.position;
+    }
+
+    update();
+
+    // acc - итог от начальной скобки до текущего места: acc.open скобок еще не закрыто.
+    // Пара находится в первой строке, закрывающей не меньше acc.open скобок.
+    Summary acc = { 0, depth };
+    QTextBlock current = block.next();
+    int number = block.blockNumber() + 1;
+    if (!current.isValid())
+        return -1;
+    int firstBucket = bucketOf(number);
+    if (bucketStart(firstBucket) < number)
+        ++firstBucket;
+    const int boundary = firstBucket < bucketCount ? bucketStart(firstBucket) : indexedBlockCount;
+
+    // Строки до начала следующей корзины просматриваются по одной, дальше - по дереву.
+    while (current.isValid() && number < boundary) {
+        if (blockSummary(current, kind).close >= acc.open)
+            break;
+        acc = combine(acc, blockSummary(current, kind));
+        current = current.next();
+        ++number;
+    }
+
+    if (current.isValid() && number == boundary && firstBucket < bucketCount) {
+        const int bucket = findForward(kind, 1, 0, leafCount, firstBucket, acc);
+        if (bucket < 0)
+            return -1;
+        current = document->findBlockByNumber(bucketStart(bucket));
+        while (current.isValid() && blockSummary(current, kind).close < acc.open) {
+            acc = combine(acc, blockSummary(current, kind));
+            current = current.next();
+        }
+    }
+    if (!current.isValid())
+        return -1;
+
+    // В найденной строке закрывается последняя из acc.open открытых скобок.
+    depth = acc.open;
+    for (const CodeFolding::Bracket &other : blockBrackets(current)) {
+        if (other.kind != kind)
+            continue;
+        depth += other.isOpen ? 1 : -1;
+        if (depth == 0)
+            return current.position() + other.position;
+    }
+    return -1;
+}
+
+int BracketIndex::matchBackward(const QTextBlock &block, const CodeFolding::Bracket &bracket) {
+    const int kind = bracket.kind;
+
+    int depth = 0;
+    const QVector<CodeFolding::Bracket> brackets = blockBrackets(block);
+    for (int i = brackets.size() - 1; i >= 0; --i) {
+        const CodeFolding::Bracket &other = brackets.at(i);
+        if (other.kind != kind || other.position > bracket.position)
+            continue;
+        depth += other.isOpen ? -1 : 1;
+        if (depth == 0)
+            return block.position() + other.position;
+    }
+
+    update();
+
+    // acc.close закрывающих скобок ждут открывающей пары; она в первой (с конца) строке,
+    // открывающей не меньше acc.close скобок.
+    Summary acc = { depth, 0 };
+    QTextBlock current = block.previous();
+    int number = block.blockNumber() - 1;
+    if (!current.isValid())
+        return -1;
+    int lastBucket = bucketOf(number);
+    if (bucketStart(lastBucket) + bucketSize(lastBucket) - 1 > number)
+        --lastBucket;
+    const int boundary = lastBucket >= 0 ? bucketStart(lastBucket) + bucketSize(lastBucket) : 0;
+
+    while (current.isValid() && number >= boundary) {
+        if (blockSummary(current, kind).open >= acc.close)
+            break;
+        acc = combine(blockSummary(current, kind), acc);
+        current = current.previous();
+        --number;
+    }
+
+    if (current.isValid() && lastBucket >= 0 && number == boundary - 1) {
+        const int bucket = findBackward(kind, 1, 0, leafCount, lastBucket, acc);
+        if (bucket < 0)
+            return -1;
+        current = document->findBlockByNumber(bucketStart(bucket) + bucketSize(bucket) - 1);
+        while (current.isValid() && blockSummary(current, kind).open < acc.close) {
+            acc = combine(blockSummary(current, kind), acc);
+            current = current.previous();
+        }
+    }
+    if (!current.isValid())
+        return -1;
+
+    depth = acc.close;
+    const QVector<CodeFolding::Bracket> found = blockBrackets(current);
+    for (int i = found.size() - 1; i >= 0; --i) {
+        const CodeFolding::Bracket &other = found.at(i);
+        if (other.kind != kind)
+            continue;
+        depth += other.isOpen ? -1 : 1;
+        if (depth == 0)
+            return current.position() + other.position;
+    }
+    return -1;
+}
+
+QVector<CodeFolding::Bracket> BracketIndex::blockBrackets(const QTextBlock &block) {
+    QVector<CodeFolding::Bracket> brackets;
+    CodeFolding::scanBlock(block.text(), block.previous().userState(), nullptr, &brackets);
+    return brackets;
+}
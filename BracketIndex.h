@@ -0,0 +1,109 @@
+#ifndef BRACKETINDEX_H
+#define BRACKETINDEX_H
+
+#include "BlockData.h"
+#include "CodeFolding.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QBitArray>
+#include <QVector>
+
+// Поиск парной скобки без просмотра текста между скобками.
+// Для каждой строки в BlockData хранится итог (непарные закрывающие, незакрытые открывающие),
+// строки объединены в корзины примерно по BucketSize, над корзинами построено дерево отрезков
+// итогов и числа строк. Поиск пропускает целые поддеревья, итоги которых не закрывают искомую
+// скобку, и разбирает текст только строки с начальной скобкой и строки с найденной парой: O(log n).
+// Добавленные и удаленные строки меняют размер корзины, в которой началась правка (и следующих при
+// удалении); корзины дальше только сдвигаются по номерам строк и не пересчитываются.
+class BracketIndex : public QObject {
+    Q_OBJECT
+
+public:
+    // Индекс документа; создается при первом обращении и принадлежит документу.
+    static BracketIndex* forDocument(QTextDocument *document);
+
+    // Итог строки изменился при подсветке: корзина строки будет пересчитана при следующем поиске.
+    // Если число строк документа изменилось, строка считается началом правки.
+    void blockChanged(int blockNumber);
+
+    // Позиция скобки, парной к скобке в позиции position, или -1.
+    int matchingBracket(int position);
+
+    // Оценка занимаемой памяти, байт.
+    qint64 memoryUsage() const;
+
+    static const int BucketSize = 64;
+
+private:
+    // Итог последовательности строк по одному виду скобок.
+    struct Summary {
+        int close;
+        int open;
+    };
+
+    BracketIndex(QTextDocument *document);
+
+    static Summary combine(const Summary &left, const Summary &right);
+
+    static Summary blockSummary(const QTextBlock &block, int kind);
+
+    // Пересчет измененных корзин; индекс строится заново, если правка прошла мимо blockChanged
+    // или после удалений осталось слишком много пустых корзин.
+    void update();
+
+    void rebuild();
+
+    // Внутренние узлы дерева по листьям.
+    void buildNodes();
+
+    void updateBucket(int bucket);
+
+    void markDirty(int bucket);
+
+    // Правка, начавшаяся в строке blockNumber, добавила (delta > 0) или удалила строки.
+    void moveBlocks(int blockNumber, int delta);
+
+    // Корзина больше 2 * BucketSize строк делится пополам, следующие сдвигаются на одну.
+    void splitBucket(int bucket);
+
+    int bucketSize(int bucket) const;
+
+    void setBucketSize(int bucket, int size);
+
+    // Корзина строки с номером blockNumber и номер первой строки корзины: O(log n).
+    int bucketOf(int blockNumber) const;
+
+    int bucketStart(int bucket) const;
+
+    // Первая корзина с номером >= from, на которой закрывается acc.open открытых скобок:
+    // поддерево с итогом close < acc.open пропускается и добавляется к acc.
+    int findForward(int kind, int node, int nodeFrom, int nodeTo, int from, Summary &acc) const;
+
+    // Последняя корзина с номером <= to, на которой открывается acc.close закрытых скобок.
+    int findBackward(int kind, int node, int nodeFrom, int nodeTo, int to, Summary &acc) const;
+
+    int matchForward(const QTextBlock &block, const CodeFolding::Bracket &bracket);
+
+    int matchBackward(const QTextBlock &block, const CodeFolding::Bracket &bracket);
+
+    static QVector<CodeFolding::Bracket> blockBrackets(const QTextBlock &block);
+
+private:
+    QTextDocument *document;
+
+    int indexedBlockCount;
+    int bucketCount;
+    int leafCount;
+
+    // Дерево отрезков по корзинам: листья с индекса leafCount, корень - 1.
+    QVector<Summary> tree[BlockData::BracketKindCount];
+    // Число строк корзин в том же дереве.
+    QVector<int> counts;
+
+    QBitArray dirty;
+    QVector<int> dirtyBuckets;
+};
+
+#endif // BRACKETINDEX_H
@@ -0,0 +1,150 @@
+#include "BracketIndex.h"
+#include "CodeFolding.h"
+
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextCursor>
+
+// Поиск парной скобки через BracketIndex: пары в одной строке, в разных строках,
+// вложенные и разделенные несколькими корзинами, а также после вставки строк.
+class BracketIndexTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void sameLine();
+    void multiLine();
+    void nested();
+    void acrossBuckets();
+    void afterInsert();
+
+private:
+    // Итоги скобок строк [first, last], как их записывает подсветка.
+    static void scan(QTextDocument *document, int first = 0, int last = -1);
+
+    // Позиция символа c в строке line (occurrence - номер вхождения в строке).
+    static int position(QTextDocument *document, int line, QChar c, int occurrence = 0);
+
+    static int match(QTextDocument *document, int position);
+};
+
+void BracketIndexTest::scan(QTextDocument *document, int first, int last) {
+    if (last < 0)
+        last = document->blockCount() - 1;
+    QTextBlock block = document->findBlockByNumber(first);
+    for (int number = first; block.isValid() && number <= last; block = block.next(), ++number) {
+        block.setUserState(CodeFolding::scanBlock(block.text(), block.previous().userState(), BlockData::get(block)));
+        BracketIndex::forDocument(document)->blockChanged(number);
+    }
+}
+
+int BracketIndexTest::position(QTextDocument *document, int line, QChar c, int occurrence) {
+    const QTextBlock block = document->findBlockByNumber(line);
+    int column = -1;
+    for (int i = 0; i <= occurrence; ++i)
+        column = block.text().indexOf(c, column + 1);
+    return column < 0 ? -1 : block.position() + column;
+}
+
+int BracketIndexTest::match(QTextDocument *document, int position) {
+    return BracketIndex::forDocument(document)->matchingBracket(position);
+}
+
+void BracketIndexTest::sameLine() {
+    QTextDocument document;
+    document.setPlainText("int f() { return (a[0]); }");
+    scan(&document);
+
+    QCOMPARE(match(&document, position(&document, 0, '{')), position(&document, 0, '}'));
+    QCOMPARE(match(&document, position(&document, 0, ')', 1)), position(&document, 0, '(', 1));
+}
+
+void BracketIndexTest::multiLine() {
+    QTextDocument document;
+    document.setPlainText("int f() {\n"
+                          "    return 0;\n"
+                          "}\n"
+                          "void g() {\n"
+                          "}\n");
+    scan(&document);
+
+    QCOMPARE(match(&document, position(&document, 0, '{')), position(&document, 2, '}'));
+    QCOMPARE(match(&document, position(&document, 2, '}')), position(&document, 0, '{'));
+    QCOMPARE(match(&document, position(&document, 3, '{')), position(&document, 4, '}'));
+    QCOMPARE(match(&document, position(&document, 4, '}')), position(&document, 3, '{'));
+}
+
+void BracketIndexTest::nested() {
+    QTextDocument document;
+    document.setPlainText("{\n"
+                          "    if (a) {\n"
+                          "        { b(); }\n"
+                          "    } else {\n"
+                          "    }\n"
+                          "}\n"
+                          "{ }\n");
+    scan(&document);
+
+    QCOMPARE(match(&document, position(&document, 0, '{')), position(&document, 5, '}'));
+    QCOMPARE(match(&document, position(&document, 5, '}')), position(&document, 0, '{'));
+    QCOMPARE(match(&document, position(&document, 1, '{')), position(&document, 3, '}'));
+    QCOMPARE(match(&document, position(&document, 3, '}')), position(&document, 1, '{'));
+    QCOMPARE(match(&document, position(&document, 3, '{')), position(&document, 4, '}'));
+    QCOMPARE(match(&document, position(&document, 4, '}')), position(&document, 3, '{'));
+}
+
+void BracketIndexTest::acrossBuckets() {
+    // Внешняя пара охватывает много корзин, внутри - пары, тоже пересекающие границы корзин.
+    const int blocks = 40;
+    const int blockLines = 3 * BracketIndex::BucketSize / 2;
+    QString text = "namespace n {\n";
+    for (int i = 0; i < blocks; ++i) {
+        text += "void f() {\n";
+        for (int line = 0; line < blockLines; ++line)
+            text += line % 2 ? "    } else {\n" : "    if (x) {\n";
+        text += "    }\n}\n";
+    }
+    text += "}\n";
+
+    QTextDocument document;
+    document.setPlainText(text);
+    scan(&document);
+
+    const int last = document.blockCount() - 2;
+    QCOMPARE(match(&document, position(&document, 0, '{')), position(&document, last, '}'));
+    QCOMPARE(match(&document, position(&document, last, '}')), position(&document, 0, '{'));
+
+    for (int i = 0; i < blocks; ++i) {
+        const int start = 1 + i * (blockLines + 3);
+        const int end = start + blockLines + 2;
+        QCOMPARE(match(&document, position(&document, start, '{')), position(&document, end, '}'));
+        QCOMPARE(match(&document, position(&document, end, '}')), position(&document, start, '{'));
+    }
+}
+
+void BracketIndexTest::afterInsert() {
+    QString text = "int f() {\n";
+    for (int line = 0; line < 4 * BracketIndex::BucketSize; ++line)
+        text += "    call();\n";
+    text += "}\n";
+
+    QTextDocument document;
+    document.setPlainText(text);
+    scan(&document);
+    QCOMPARE(match(&document, position(&document, 0, '{')), position(&document, document.blockCount() - 2, '}'));
+
+    // Вставка вложенной пары в середину: итоги пересчитываются только для измененных строк.
+    const int line = 2 * BracketIndex::BucketSize;
+    QTextCursor cursor(document.findBlockByNumber(line));
+    cursor.insertText("    while (y) {\n        step();\n    }\n");
+    scan(&document, line, line + 3);
+
+    const int close = document.blockCount() - 2;
+    QCOMPARE(match(&document, position(&document, 0, '{')), position(&document, close, '}'));
+    QCOMPARE(match(&document, position(&document, close, '}')), position(&document, 0, '{'));
+    QCOMPARE(match(&document, position(&document, line, '{')), position(&document, line + 2, '}'));
+    QCOMPARE(match(&document, position(&document, line + 2, '}')), position(&document, line, '{'));
+}
+
+QTEST_MAIN(BracketIndexTest)
+
+#include "BracketIndexTest.moc"
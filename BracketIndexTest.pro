@@ -0,0 +1,31 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = BracketIndexTest
+
+# The test shares the build directory with the editor; keep its objects apart.
+OBJECTS_DIR = .obj/BracketIndexTest
+MOC_DIR = .moc/BracketIndexTest
+
+# BracketIndex and the per-block data it depends on.
+SOURCES += \
+    BlockData.cpp \
+    BracketIndex.cpp \
+    BracketIndexTest.cpp \
+    CodeFolding.cpp \
+    DocumentStatistics.cpp \
+    IdentifierIndex.cpp \
+    LayoutBudget.cpp \
+    MemoryUsage.cpp \
+    SymbolIndex.cpp
+
+HEADERS += \
+    BlockData.h \
+    BracketIndex.h \
+    CodeFolding.h \
+    DocumentStatistics.h \
+    IdentifierIndex.h \
+    LayoutBudget.h \
+    MemoryUsage.h \
+    SymbolIndex.h
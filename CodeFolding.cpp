@@ -0,0 +1,126 @@
+#include "CodeFolding.h"
+
+int CodeFolding::scanBlock(const QString &text, int previousState, BlockData *data,
+                           QVector<Bracket> *brackets) {
+    static const char openChars[] = "{([";
+    static const char closeChars[] = "})]";
+
+    bool inComment = previousState == 1;
+    bool inLineComment = false;
+    QChar quote;
+    int open[BlockData::BracketKindCount] = { 0, 0, 0 };
+    int close[BlockData::BracketKindCount] = { 0, 0, 0 };
+
+    const QChar *chars = text.constData();
+    const int length = text.length();
+    for (int i = 0; i < length; ++i) {
+        const QChar c = chars[i];
+        const QChar next = i + 1 < length ? chars[i + 1] : QChar();
+
+        if (inComment) {
+            if (c == '*' && next == '/') {
+                inComment = false;
+                ++i;
+            }
+            continue;
+        }
+
+        // Начало комментария ищется так же, как в подсветке: в любом месте строки.
+        if (c == '/' && next == '*') {
+            inComment = true;
+            ++i;
+            continue;
+        }
+        if (inLineComment)
+            continue;
+
+        if (!quote.isNull()) {
+            if (c == '\\')
+                ++i;
+            else if (c == quote)
+                quote = QChar();
+            continue;
+        }
+
+        if (c == '/' && next == '/') {
+            inLineComment = true;
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            quote = c;
+            continue;
+        }
+
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind) {
+            if (c == openChars[kind]) {
+                ++open[kind];
+            } else if (c == closeChars[kind]) {
+                if (open[kind] > 0)
+                    --open[kind];
+                else
+                    ++close[kind];
+            } else {
+                continue;
+            }
+            if (brackets)
+                brackets->append({ i, BlockData::BracketKind(kind), c == openChars[kind] });
+            break;
+        }
+    }
+
+    if (data) {
+        for (int kind = 0; kind < BlockData::BracketKindCount; ++kind) {
+            data->bracketOpen[kind] = open[kind];
+            data->bracketClose[kind] = close[kind];
+        }
+    }
+    return inComment ? 1 : 0;
+}
+
+bool CodeFolding::isFoldStart(const QTextBlock &block) {
+    const BlockData *data = static_cast<const BlockData*>(block.userData());
+    if (data && data->bracketOpen[BlockData::Brace] > 0 && block.next().isValid())
+        return true;
+    return isCommentStart(block);
+}
+
+QTextBlock CodeFolding::foldEnd(const QTextBlock &block) {
+    if (isCommentStart(block)) {
+        // Комментарий продолжается, пока состояние блока равно 1; строка с */ скрывается тоже.
+        QTextBlock end = block.next();
+        while (end.isValid() && end.userState() == 1 && end.next().isValid())
+            end = end.next();
+        return end;
+    }
+
+    const BlockData *data = static_cast<const BlockData*>(block.userData());
+    if (!data || data->bracketOpen[BlockData::Brace] == 0)
+        return QTextBlock();
+
+    int depth = data->bracketOpen[BlockData::Brace];
+    QTextBlock last = block;
+    QTextBlock next = block.next();
+    while (next.isValid()) {
+        const BlockData *nextData = static_cast<const BlockData*>(next.userData());
+        if (nextData) {
+            depth -= nextData->bracketClose[BlockData::Brace];
+            if (depth <= 0)
+                break;
+            depth += nextData->bracketOpen[BlockData::Brace];
+        }
+        last = next;
+        next = next.next();
+    }
+
+    // Одна строка без вложенного текста не сворачивается.
+    if (last == block)
+        return QTextBlock();
+    return last;
+}
+
+bool CodeFolding::isCommentStart(const QTextBlock &block) {
+    if (block.userState() != 1 || !block.next().isValid())
+        return false;
+    QTextBlock previous = block.previous();
+    return !previous.isValid() || previous.userState() != 1;
+}
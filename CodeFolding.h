@@ -0,0 +1,39 @@
+#ifndef CODEFOLDING_H
+#define CODEFOLDING_H
+
+#include "BlockData.h"
+
+#include <QTextBlock>
+#include <QString>
+#include <QVector>
+
+// Определение сворачиваемых фрагментов по скобкам { } и многострочным комментариям.
+// Для каждой строки подсветка сохраняет в BlockData число незакрытых открывающих и
+// непарных закрывающих скобок каждого вида, а в состоянии блока - признак комментария (1),
+// поэтому фрагменты пересчитываются вместе с подсветкой только для измененных строк.
+class CodeFolding {
+public:
+    struct Bracket {
+        int position;
+        BlockData::BracketKind kind;
+        bool isOpen;
+    };
+
+    // Разбор строки: скобки вне комментариев, строк и символьных констант.
+    // Итог по строке записывается в data (если задано), сами скобки - в brackets (если задано).
+    // Возвращает состояние блока: 1 - строка заканчивается внутри комментария /* */.
+    static int scanBlock(const QString &text, int previousState, BlockData *data,
+                         QVector<Bracket> *brackets = nullptr);
+
+    // Строка начинает сворачиваемый фрагмент.
+    static bool isFoldStart(const QTextBlock &block);
+
+    // Последняя строка, скрываемая при сворачивании фрагмента, начинающегося с block.
+    // Для скобок строка с закрывающей скобкой остается видимой, для комментария - скрывается.
+    static QTextBlock foldEnd(const QTextBlock &block);
+
+private:
+    static bool isCommentStart(const QTextBlock &block);
+};
+
+#endif // CODEFOLDING_H
@@ -13,14 +13,19 @@ void ColorListEditor::setColor(const QColor &color) {
 }
 
 void ColorListEditor::populateList() {
-    const QStringList colorNames = QColor::colorNames();
-
-    for (int i = 0; i < colorNames.size(); ++i) {
-        QColor color(colorNames[i]);
-
-        insertItem(i, colorNames[i]);
-        setItemData(i, color, Qt::DecorationRole);
+    // Список цветов строится один раз и разделяется всеми редакторами цвета:
+    // редактор создается заново при каждом изменении ячейки стиля.
+    static QPointer<QStandardItemModel> colorModel;
+    if (!colorModel) {
+        colorModel = new QStandardItemModel(QCoreApplication::instance());
+        const QStringList colorNames = QColor::colorNames();
+        for (const QString &name : colorNames) {
+            QStandardItem *item = new QStandardItem(name);
+            item->setData(QColor(name), Qt::DecorationRole);
+            colorModel->appendRow(item);
+        }
     }
+    setModel(colorModel);
 }
 
 
@@ -13,6 +13,9 @@
 
 #include <QItemEditorFactory>
 #include <QHeaderView>
+#include <QStandardItemModel>
+#include <QCoreApplication>
+#include <QPointer>
 
 enum class WindowType {
     BackgroundStyle,
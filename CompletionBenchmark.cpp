@@ -0,0 +1,106 @@
+#include "IdentifierIndex.h"
+
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QElapsedTimer>
+
+// Автодополнение на большом документе: IdentifierIndex::complete должен укладываться
+// в IdentifierIndex::CompletionBudget для коротких и длинных префиксов. Тест падает,
+// если худшее время из Repeats вызовов превышает бюджет.
+class CompletionBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void complete_data();
+    void complete();
+
+    void budget_data();
+    void budget();
+
+    // Слова удаленного текста не остаются в дереве.
+    void staleWordsPruned();
+
+private:
+    // Строк в документе и разных идентификаторов в нем.
+    static const int Lines = 500000;
+    static const int Identifiers = 50000;
+
+    static const int Repeats = 50;
+
+    QTextDocument document;
+};
+
+void CompletionBenchmark::initTestCase() {
+    QString text;
+    text.reserve(Lines * 48);
+    for (int line = 0; line < Lines; ++line) {
+        text += QString("    int identifier%1 = compute_%2(value%3, count);\n")
+                .arg(line % Identifiers).arg(line % 997).arg(line % 31);
+    }
+    document.setPlainText(text);
+    IdentifierIndex::forDocument(&document);
+}
+
+void CompletionBenchmark::complete_data() {
+    QTest::addColumn<QString>("prefix");
+    QTest::newRow("short") << "ide";
+    QTest::newRow("shared") << "compute_";
+    QTest::newRow("long") << "identifier4242";
+    QTest::newRow("missing") << "zzz";
+}
+
+void CompletionBenchmark::complete() {
+    QFETCH(QString, prefix);
+    IdentifierIndex *index = IdentifierIndex::forDocument(&document);
+    const QTextBlock near = document.findBlockByNumber(Lines / 2);
+
+    QBENCHMARK {
+        index->complete(prefix, near, 20);
+    }
+}
+
+void CompletionBenchmark::budget_data() {
+    complete_data();
+}
+
+void CompletionBenchmark::budget() {
+    QFETCH(QString, prefix);
+    IdentifierIndex *index = IdentifierIndex::forDocument(&document);
+    const QTextBlock near = document.findBlockByNumber(Lines / 2);
+
+    qint64 maxTime = 0;
+    for (int i = 0; i < Repeats; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        index->complete(prefix, near, 20);
+        maxTime = qMax(maxTime, timer.nsecsElapsed());
+    }
+    QVERIFY2(maxTime <= IdentifierIndex::CompletionBudget,
+             qPrintable(QString("complete(\"%1\") took %2 ms, budget %3 ms")
+                        .arg(prefix).arg(maxTime / 1e6).arg(IdentifierIndex::CompletionBudget / 1e6)));
+}
+
+void CompletionBenchmark::staleWordsPruned() {
+    QTextDocument scratch;
+    QString text;
+    for (int line = 0; line < 20000; ++line)
+        text += QString("old_word%1\n").arg(line);
+    scratch.setPlainText(text);
+    IdentifierIndex *index = IdentifierIndex::forDocument(&scratch);
+    const qint64 fullSize = index->memoryUsage();
+
+    QTextCursor cursor(&scratch);
+    cursor.select(QTextCursor::Document);
+    cursor.insertText("new_word and new_words");
+
+    QVERIFY(index->complete("old", scratch.firstBlock(), 20).isEmpty());
+    QCOMPARE(index->complete("new", scratch.firstBlock(), 20).size(), 2);
+    QVERIFY(index->memoryUsage() < fullSize / 4);
+}
+
+QTEST_MAIN(CompletionBenchmark)
+
+#include "CompletionBenchmark.moc"
@@ -0,0 +1,31 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = CompletionBenchmark
+
+# The benchmark shares the build directory with the editor; keep its objects apart.
+OBJECTS_DIR = .obj/CompletionBenchmark
+MOC_DIR = .moc/CompletionBenchmark
+
+# IdentifierIndex and the per-block data it depends on.
+SOURCES += \
+    BlockData.cpp \
+    BracketIndex.cpp \
+    CodeFolding.cpp \
+    CompletionBenchmark.cpp \
+    DocumentStatistics.cpp \
+    IdentifierIndex.cpp \
+    LayoutBudget.cpp \
+    MemoryUsage.cpp \
+    SymbolIndex.cpp
+
+HEADERS += \
+    BlockData.h \
+    BracketIndex.h \
+    CodeFolding.h \
+    DocumentStatistics.h \
+    IdentifierIndex.h \
+    LayoutBudget.h \
+    MemoryUsage.h \
+    SymbolIndex.h
@@ -0,0 +1,135 @@
+#include "DocumentStatistics.h"
+
+DocumentStatistics::DocumentStatistics(QTextDocument *document)
+    : QObject(document), document(document), words(0)
+{
+    revision = document->revision();
+
+    // Первоначальный подсчет выполняется один раз, дальше статистика только корректируется.
+    for (QTextBlock block = document->firstBlock(); block.isValid(); block = block.next())
+        countBlock(block);
+
+    connect(document, &QTextDocument::contentsChange, this, &DocumentStatistics::contentsChange);
+}
+
+DocumentStatistics* DocumentStatistics::forDocument(QTextDocument *document) {
+    DocumentStatistics *statistics =
+        document->findChild<DocumentStatistics*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!statistics)
+        statistics = new DocumentStatistics(document);
+    return statistics;
+}
+
+int DocumentStatistics::lineCount() const {
+    return document->blockCount();
+}
+
+qint64 DocumentStatistics::wordCount() const {
+    return words;
+}
+
+int DocumentStatistics::characterCount() const {
+    // Последний символ документа - служебный разделитель абзаца.
+    return document->characterCount() - 1;
+}
+
+int DocumentStatistics::selectionWordCount(const QTextCursor &cursor) {
+    const QString text = cursor.selectedText();
+    return countWords(text.constData(), text.length());
+}
+
+int DocumentStatistics::countWords(const QChar *text, int length) {
+    int count = 0;
+    bool inWord = false;
+    for (int i = 0; i < length; ++i) {
+        bool space = text[i].isSpace();
+        if (!space && !inWord)
+            ++count;
+        inWord = !space;
+    }
+    return count;
+}
+
+void DocumentStatistics::contentsChange(int position, int charsRemoved, int charsAdded) {
+    // Изменение только форматов (подсветка) не меняет ревизию и текст документа.
+    if (charsRemoved == charsAdded && document->revision() == revision)
+        return;
+    revision = document->revision();
+
+    if (charsRemoved == 0 && countInsertion(position, charsAdded))
+        return;
+
+    // Удаленные строки вычли себя сами при удалении своих BlockData,
+    // здесь пересчитываются строки, в которые попал новый текст.
+    QTextBlock block = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid())
+        last = document->lastBlock();
+
+    while (block.isValid()) {
+        countBlock(block);
+        if (block == last)
+            break;
+        block = block.next();
+    }
+}
+
+void DocumentStatistics::countBlock(QTextBlock block) {
+    BlockData *data = BlockData::get(block);
+    if (data->statistics == this && data->wordCount >= 0)
+        words -= data->wordCount;
+
+    const QString text = block.text();
+    data->wordCount = countWords(text.constData(), text.length());
+    data->statistics = this;
+    words += data->wordCount;
+}
+
+bool DocumentStatistics::countInsertion(int position, int charsAdded) {
+    QTextBlock block = document->findBlock(position);
+    if (!block.isValid() || !block.contains(position + charsAdded))
+        return false;
+
+    BlockData *data = static_cast<BlockData*>(block.userData());
+    if (!data || data->statistics != this || data->wordCount < 0)
+        return false;
+
+    // Границы расширяются до концов слов, которых коснулась вставка.
+    const int blockStart = block.position();
+    const int blockEnd = blockStart + block.length() - 1;
+
+    int from = position;
+    while (from > blockStart && !document->characterAt(from - 1).isSpace())
+        --from;
+    int to = position + charsAdded;
+    while (to < blockEnd && !document->characterAt(to).isSpace())
+        ++to;
+
+    const int before = countWords(from, to, position, position + charsAdded);
+    const int after = countWords(from, to, to, to);
+
+    data->wordCount += after - before;
+    words += after - before;
+    return true;
+}
+
+int DocumentStatistics::countWords(int from, int to, int skipFrom, int skipTo) const {
+    int count = 0;
+    bool inWord = false;
+    for (int i = from; i < to; ++i) {
+        if (i >= skipFrom && i < skipTo) {
+            i = skipTo - 1;
+            continue;
+        }
+        bool space = document->characterAt(i).isSpace();
+        if (!space && !inWord)
+            ++count;
+        inWord = !space;
+    }
+    return count;
+}
+
+void DocumentStatistics::blockDataDestroyed(BlockData *data) {
+    if (data->wordCount > 0)
+        words -= data->wordCount;
+}
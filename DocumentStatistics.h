@@ -0,0 +1,57 @@
+#ifndef DOCUMENTSTATISTICS_H
+#define DOCUMENTSTATISTICS_H
+
+#include "BlockData.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QString>
+
+// Статистика документа (строки, слова, символы), поддерживаемая инкрементально.
+// Количество слов хранится для каждой строки в BlockData, при изменении документа
+// пересчитываются только затронутые строки, а при наборе текста - только слова на границах вставки.
+class DocumentStatistics : public QObject {
+    Q_OBJECT
+
+public:
+    // Статистика документа; создается при первом обращении и принадлежит документу.
+    static DocumentStatistics* forDocument(QTextDocument *document);
+
+    int lineCount() const;
+
+    qint64 wordCount() const;
+
+    int characterCount() const;
+
+    // Подсчет слов в выделении выполняется только по запросу.
+    static int selectionWordCount(const QTextCursor &cursor);
+
+    // Слово - непрерывная последовательность непробельных символов.
+    static int countWords(const QChar *text, int length);
+
+private slots:
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    DocumentStatistics(QTextDocument *document);
+
+    void countBlock(QTextBlock block);
+
+    // Быстрый путь для набора текста внутри одной строки.
+    bool countInsertion(int position, int charsAdded);
+
+    // Количество слов в [from, to) без учета символов [skipFrom, skipTo).
+    int countWords(int from, int to, int skipFrom, int skipTo) const;
+
+    void blockDataDestroyed(BlockData *data);
+
+private:
+    friend class BlockData;
+
+    QTextDocument *document;
+    qint64 words;
+    int revision;
+};
+
+#endif // DOCUMENTSTATISTICS_H
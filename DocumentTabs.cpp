@@ -0,0 +1,190 @@
+#include "DocumentTabs.h"
+
+#include <QPlainTextDocumentLayout>
+#include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QDir>
+
+DocumentTabs::DocumentTabs(QWidget *parent) : QTabBar(parent) {
+    useCounter = 0;
+
+    setTabsClosable(true);
+    setDocumentMode(true);
+    setExpanding(false);
+    setElideMode(Qt::ElideMiddle);
+    setUsesScrollButtons(true);
+}
+
+int DocumentTabs::addDocument(const QString &fileName) {
+    Tab tab;
+    tab.fileName = fileName;
+    tab.lastUsed = ++useCounter;
+    tabs.append(tab);
+
+    // Документ создается до вкладки: первая вкладка сразу становится текущей.
+    tabs.last().document = createDocument();
+    const int index = addTab(QString());
+    updateTabText(index);
+    return index;
+}
+
+QTextDocument* DocumentTabs::document(int index, QString *errorMessage) {
+    Tab &tab = tabs[index];
+
+    if (!tab.document) {
+        QString text;
+        if (!tab.compressedText.isEmpty()) {
+            text = QString::fromUtf8(qUncompress(tab.compressedText));
+        } else if (!tab.fileName.isEmpty()) {
+            QFile file(tab.fileName);
+            if (!file.open(QFile::ReadOnly | QFile::Text)) {
+                if (errorMessage)
+                    *errorMessage = tr("Cannot read file %1:\n%2.")
+                                    .arg(QDir::toNativeSeparators(tab.fileName), file.errorString());
+                return nullptr;
+            }
+            QTextStream in(&file);
+            text = in.readAll();
+        }
+
+        tab.document = createDocument();
+        tab.document->setPlainText(text);
+        tab.document->setModified(tab.isModified);
+        tab.compressedText.clear();
+    }
+    tab.lastUsed = ++useCounter;
+
+    // Выгружаются давно не использованные документы сверх MaxLiveDocuments.
+    while (liveCount() > MaxLiveDocuments) {
+        int oldest = -1;
+        for (int i = 0; i < tabs.size(); ++i) {
+            if (i != index && tabs.at(i).document
+                    && (oldest < 0 || tabs.at(i).lastUsed < tabs.at(oldest).lastUsed))
+                oldest = i;
+        }
+        unload(oldest);
+    }
+
+    return tabs.at(index).document;
+}
+
+bool DocumentTabs::reload(int index, QString *errorMessage) {
+    Tab &tab = tabs[index];
+    if (!tab.document)
+        return true;
+
+    QFile file(tab.fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        if (errorMessage)
+            *errorMessage = tr("Cannot read file %1:\n%2.")
+                            .arg(QDir::toNativeSeparators(tab.fileName), file.errorString());
+        return false;
+    }
+    QTextStream in(&file);
+    tab.document->setPlainText(in.readAll());
+    tab.document->setModified(false);
+    return true;
+}
+
+int DocumentTabs::indexOf(const QTextDocument *document) const {
+    for (int i = 0; i < tabs.size(); ++i) {
+        if (tabs.at(i).document == document)
+            return i;
+    }
+    return -1;
+}
+
+int DocumentTabs::indexOfFile(const QString &fileName) const {
+    const QString path = QFileInfo(fileName).canonicalFilePath();
+    for (int i = 0; i < tabs.size(); ++i) {
+        if (!tabs.at(i).fileName.isEmpty() && QFileInfo(tabs.at(i).fileName).canonicalFilePath() == path)
+            return i;
+    }
+    return -1;
+}
+
+QString DocumentTabs::fileName(int index) const {
+    return tabs.at(index).fileName;
+}
+
+void DocumentTabs::setFileName(int index, const QString &fileName) {
+    tabs[index].fileName = fileName;
+    updateTabText(index);
+}
+
+bool DocumentTabs::isModified(int index) const {
+    const Tab &tab = tabs.at(index);
+    return tab.document ? tab.document->isModified() : tab.isModified;
+}
+
+void DocumentTabs::setViewState(int index, int cursorPosition, int scrollValue) {
+    tabs[index].cursorPosition = cursorPosition;
+    tabs[index].scrollValue = scrollValue;
+}
+
+int DocumentTabs::cursorPosition(int index) const {
+    return tabs.at(index).cursorPosition;
+}
+
+int DocumentTabs::scrollValue(int index) const {
+    return tabs.at(index).scrollValue;
+}
+
+void DocumentTabs::removeDocument(int index) {
+    QTextDocument *document = tabs.at(index).document;
+    tabs.remove(index);
+    removeTab(index);
+    delete document;
+}
+
+int DocumentTabs::liveCount() const {
+    int count = 0;
+    for (const Tab &tab : tabs) {
+        if (tab.document)
+            ++count;
+    }
+    return count;
+}
+
+QVector<QTextDocument*> DocumentTabs::liveDocuments() const {
+    QVector<QTextDocument*> documents;
+    for (const Tab &tab : tabs) {
+        if (tab.document)
+            documents.append(tab.document);
+    }
+    return documents;
+}
+
+qint64 DocumentTabs::compressedSize() const {
+    qint64 size = 0;
+    for (const Tab &tab : tabs)
+        size += tab.compressedText.size();
+    return size;
+}
+
+QTextDocument* DocumentTabs::createDocument() {
+    QTextDocument *document = new QTextDocument(this);
+    document->setDocumentLayout(new QPlainTextDocumentLayout(document));
+    emit documentCreated(document);
+    return document;
+}
+
+void DocumentTabs::unload(int index) {
+    Tab &tab = tabs[index];
+
+    // Неизмененный текст есть в файле; история отмены при выгрузке теряется.
+    tab.isModified = tab.document->isModified();
+    if (tab.isModified || tab.fileName.isEmpty())
+        tab.compressedText = qCompress(tab.document->toPlainText().toUtf8());
+
+    // Вместе с документом удаляются его разметка, BlockData и индексы.
+    delete tab.document;
+    tab.document = nullptr;
+}
+
+void DocumentTabs::updateTabText(int index) {
+    const QString &fileName = tabs.at(index).fileName;
+    setTabText(index, fileName.isEmpty() ? QString("untitled.txt") : QFileInfo(fileName).fileName());
+    setTabToolTip(index, QDir::toNativeSeparators(fileName));
+}
@@ -0,0 +1,92 @@
+#ifndef DOCUMENTTABS_H
+#define DOCUMENTTABS_H
+
+#include <QTabBar>
+#include <QTextDocument>
+#include <QByteArray>
+#include <QVector>
+#include <QString>
+
+// Вкладки открытых документов.
+// Живой QTextDocument (с разметкой, подсветкой и индексами) есть только у MaxLiveDocuments
+// последних использованных вкладок. Остальные выгружаются: от неизмененного документа остается
+// только путь к файлу, от измененного - сжатый текст. При переходе на выгруженную вкладку документ
+// создается заново из файла или сжатого текста.
+class DocumentTabs : public QTabBar {
+    Q_OBJECT
+
+public:
+    DocumentTabs(QWidget *parent = nullptr);
+
+    // Вкладка с новым пустым документом; текст загружается в него вызывающим.
+    int addDocument(const QString &fileName);
+
+    // Документ вкладки; выгруженный документ восстанавливается. Вкладка становится последней использованной.
+    // Если файл выгруженной вкладки не читается, вкладка остается выгруженной (пустой документ
+    // нельзя было бы отличить от файла и сохранить поверх него): nullptr и описание ошибки в errorMessage.
+    QTextDocument* document(int index, QString *errorMessage = nullptr);
+
+    // Текст неизмененной вкладки перечитывается из ее файла (файл изменен не редактором).
+    // Выгруженная вкладка и так прочитает файл при переходе на нее. false и описание ошибки
+    // в errorMessage, если файл не читается; документ тогда не меняется.
+    bool reload(int index, QString *errorMessage = nullptr);
+
+    // Вкладка документа или -1.
+    int indexOf(const QTextDocument *document) const;
+
+    // Вкладка файла или -1.
+    int indexOfFile(const QString &fileName) const;
+
+    QString fileName(int index) const;
+
+    void setFileName(int index, const QString &fileName);
+
+    bool isModified(int index) const;
+
+    // Положение курсора и прокрутки, восстанавливаемые при возврате на вкладку.
+    void setViewState(int index, int cursorPosition, int scrollValue);
+
+    int cursorPosition(int index) const;
+
+    int scrollValue(int index) const;
+
+    // Вкладка удаляется вместе с документом; документ не должен быть открыт в редакторе.
+    void removeDocument(int index);
+
+    int liveCount() const;
+
+    // Документы, которые сейчас не выгружены.
+    QVector<QTextDocument*> liveDocuments() const;
+
+    // Суммарный размер сжатого текста выгруженных вкладок.
+    qint64 compressedSize() const;
+
+    static const int MaxLiveDocuments = 4;
+
+signals:
+    // Создан пустой документ вкладки, текст в него еще не загружен.
+    void documentCreated(QTextDocument *document);
+
+private:
+    QTextDocument* createDocument();
+
+    // Выгрузка документа вкладки.
+    void unload(int index);
+
+    void updateTabText(int index);
+
+private:
+    struct Tab {
+        QString fileName;
+        QTextDocument *document = nullptr;
+        QByteArray compressedText;
+        bool isModified = false;
+        int cursorPosition = 0;
+        int scrollValue = 0;
+        quint64 lastUsed = 0;
+    };
+    QVector<Tab> tabs;
+    quint64 useCounter;
+};
+
+#endif // DOCUMENTTABS_H
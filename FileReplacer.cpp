@@ -0,0 +1,327 @@
+#include "FileReplacer.h"
+
+#include <QByteArrayMatcher>
+#include <QDirIterator>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QBoxLayout>
+#include <QFormLayout>
+#include <QMessageBox>
+
+FileReplacer::FileReplacer(QObject *parent) : QObject(parent) {
+    generation = 0;
+    done = 0;
+    total = 0;
+}
+
+FileReplacer::~FileReplacer() {
+    // Задачи пула ссылаются на this, поэтому дожидаемся их завершения.
+    cancel();
+    pool.waitForDone();
+}
+
+void FileReplacer::preview(const QStringList &fileNames, const QString &oldString) {
+    start(fileNames, oldString.toUtf8(), QByteArray(), false);
+}
+
+void FileReplacer::replace(const QStringList &fileNames, const QString &oldString, const QString &newString) {
+    start(fileNames, oldString.toUtf8(), newString.toUtf8(), true);
+}
+
+void FileReplacer::cancel() {
+    canceled.storeRelease(1);
+}
+
+bool FileReplacer::isRunning() const {
+    return done < total;
+}
+
+void FileReplacer::start(const QStringList &fileNames, const QByteArray &pattern,
+                         const QByteArray &replacement, bool writeResult) {
+    // Предыдущий запуск отменяется, его запоздавшие результаты отбрасываются по номеру поколения.
+    cancel();
+    pool.waitForDone();
+    canceled.storeRelease(0);
+
+    ++generation;
+    done = 0;
+    total = fileNames.size();
+
+    if (pattern.isEmpty() || total == 0) {
+        total = 0;
+        emit finished(false);
+        return;
+    }
+
+    emit progressChanged(done, total);
+    for (const QString &fileName : fileNames) {
+        pool.start(new FileReplaceTask(this, generation, fileName, pattern, replacement, writeResult));
+    }
+}
+
+void FileReplacer::taskFinished(int taskGeneration, const QString &fileName,
+                                qint64 matches, const QString &errorMessage) {
+    if (taskGeneration != generation)
+        return;
+
+    ++done;
+    emit fileProcessed(fileName, matches, errorMessage);
+    emit progressChanged(done, total);
+
+    if (done == total)
+        emit finished(canceled.loadAcquire() != 0);
+}
+
+
+FileReplaceTask::FileReplaceTask(FileReplacer *replacer, int generation, const QString &fileName,
+                                 const QByteArray &pattern, const QByteArray &replacement, bool writeResult)
+    : replacer(replacer), generation(generation), fileName(fileName),
+      pattern(pattern), replacement(replacement), writeResult(writeResult)
+{}
+
+void FileReplaceTask::run() {
+    QString errorMessage;
+    qint64 matches = streamFile(fileName, pattern, replacement, writeResult,
+                                replacer->canceled, &errorMessage);
+
+    // Результат передается в поток объекта FileReplacer.
+    FileReplacer *receiver = replacer;
+    int taskGeneration = generation;
+    QString name = fileName;
+    QMetaObject::invokeMethod(receiver, [receiver, taskGeneration, name, matches, errorMessage]() {
+        receiver->taskFinished(taskGeneration, name, matches, errorMessage);
+    }, Qt::QueuedConnection);
+}
+
+qint64 FileReplaceTask::streamFile(const QString &fileName, const QByteArray &pattern,
+                                   const QByteArray &replacement, bool writeResult,
+                                   const QAtomicInt &canceled, QString *errorMessage) {
+    QFile in(fileName);
+    if (!in.open(QFile::ReadOnly)) {
+        *errorMessage = in.errorString();
+        return -1;
+    }
+
+    // Запись идет во временный файл рядом с исходным, commit() атомарно его переименовывает.
+    QSaveFile out(fileName);
+    if (writeResult && !out.open(QFile::WriteOnly)) {
+        *errorMessage = out.errorString();
+        return -1;
+    }
+
+    QByteArrayMatcher matcher(pattern);
+    const int patternSize = pattern.size();
+
+    // В буфере остается не более (patternSize - 1) байт предыдущего блока:
+    // в них может начинаться совпадение, пересекающее границу блоков.
+    QByteArray buffer;
+    buffer.reserve(FileReplacer::BufferSize + patternSize);
+
+    qint64 matches = 0;
+    for (;;) {
+        if (canceled.loadAcquire()) {
+            *errorMessage = QObject::tr("Canceled");
+            return -1;
+        }
+
+        const int tail = buffer.size();
+        buffer.resize(tail + FileReplacer::BufferSize);
+        const qint64 read = in.read(buffer.data() + tail, FileReplacer::BufferSize);
+        if (read < 0) {
+            *errorMessage = in.errorString();
+            return -1;
+        }
+        buffer.resize(tail + int(read));
+
+        if (read == 0) {
+            // Конец файла: остаток буфера совпадений уже не содержит.
+            if (writeResult)
+                out.write(buffer);
+            break;
+        }
+
+        int pos = 0;
+        int index;
+        while ((index = matcher.indexIn(buffer, pos)) >= 0) {
+            ++matches;
+            if (writeResult) {
+                out.write(buffer.constData() + pos, index - pos);
+                out.write(replacement);
+            }
+            pos = index + patternSize;
+        }
+
+        int keep = buffer.size() - pos;
+        if (keep > patternSize - 1)
+            keep = patternSize - 1;
+        const int flushEnd = buffer.size() - keep;
+
+        if (writeResult)
+            out.write(buffer.constData() + pos, flushEnd - pos);
+        buffer.remove(0, flushEnd);
+    }
+
+    if (writeResult) {
+        if (matches == 0) {
+            // Файл без совпадений не трогаем, чтобы не менять дату изменения.
+            out.cancelWriting();
+        } else if (!out.commit()) {
+            *errorMessage = out.errorString();
+            return -1;
+        }
+    }
+
+    return matches;
+}
+
+
+ReplaceInFilesDialog::ReplaceInFilesDialog(const QString &oldString, const QString &newString, QWidget *parent)
+    : QDialog(parent), totalMatches(0), isReplacing(false)
+{
+    replacer = new FileReplacer(this);
+
+    findEdit = new QLineEdit(oldString);
+    findEdit->setPlaceholderText("Find");
+    replaceEdit = new QLineEdit(newString);
+    replaceEdit->setPlaceholderText("Replace");
+    folderEdit = new QLineEdit(QDir::currentPath());
+    filterEdit = new QLineEdit("*");
+    filterEdit->setToolTip(tr("File name filters separated by ';', for example *.log;*.txt"));
+
+    QPushButton *browseButton = new QPushButton(tr("Browse..."));
+    QBoxLayout *folderLayout = new QBoxLayout(QBoxLayout::LeftToRight);
+    folderLayout->addWidget(folderEdit);
+    folderLayout->addWidget(browseButton);
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow(tr("Find:"), findEdit);
+    formLayout->addRow(tr("Replace:"), replaceEdit);
+    formLayout->addRow(tr("Folder:"), folderLayout);
+    formLayout->addRow(tr("Files:"), filterEdit);
+
+    results = new QListWidget;
+    results->setUniformItemSizes(true);
+    progress = new QProgressBar;
+    progress->setValue(0);
+    summary = new QLabel;
+
+    previewButton = new QPushButton(tr("Preview"));
+    replaceButton = new QPushButton(tr("Replace all"));
+    cancelButton = new QPushButton(tr("Cancel"));
+    cancelButton->setEnabled(false);
+
+    QBoxLayout *buttonLayout = new QBoxLayout(QBoxLayout::LeftToRight);
+    buttonLayout->addWidget(previewButton);
+    buttonLayout->addWidget(replaceButton);
+    buttonLayout->addWidget(cancelButton);
+
+    QBoxLayout *mainLayout = new QBoxLayout(QBoxLayout::TopToBottom);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addWidget(results);
+    mainLayout->addWidget(progress);
+    mainLayout->addWidget(summary);
+    mainLayout->addLayout(buttonLayout);
+    setLayout(mainLayout);
+
+    setWindowTitle(tr("Replace in files"));
+    resize(600, 400);
+
+    connect(browseButton, SIGNAL(clicked()), this, SLOT(browse()));
+    connect(previewButton, SIGNAL(clicked()), this, SLOT(preview()));
+    connect(replaceButton, SIGNAL(clicked()), this, SLOT(replace()));
+    connect(cancelButton, &QPushButton::clicked, replacer, &FileReplacer::cancel);
+
+    connect(replacer, &FileReplacer::fileProcessed, this, &ReplaceInFilesDialog::fileProcessed);
+    connect(replacer, &FileReplacer::progressChanged, this, &ReplaceInFilesDialog::progressChanged);
+    connect(replacer, &FileReplacer::finished, this, &ReplaceInFilesDialog::finished);
+}
+
+void ReplaceInFilesDialog::reject() {
+    // Закрытие окна во время работы только отменяет операцию.
+    if (replacer->isRunning()) {
+        replacer->cancel();
+        return;
+    }
+    QDialog::reject();
+}
+
+void ReplaceInFilesDialog::browse() {
+    QString folder = QFileDialog::getExistingDirectory(this, tr("Folder"), folderEdit->text());
+    if (!folder.isEmpty())
+        folderEdit->setText(folder);
+}
+
+void ReplaceInFilesDialog::preview() {
+    isReplacing = false;
+    setRunning(true);
+    replacer->preview(collectFiles(), findEdit->text());
+}
+
+void ReplaceInFilesDialog::replace() {
+    const QMessageBox::StandardButton ret =
+        QMessageBox::warning(this, windowTitle(),
+                             tr("Replace all occurrences in the files of the folder?\n"
+                                "This cannot be undone."),
+                             QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes)
+        return;
+
+    isReplacing = true;
+    changedFiles.clear();
+    setRunning(true);
+    replacer->replace(collectFiles(), findEdit->text(), replaceEdit->text());
+}
+
+void ReplaceInFilesDialog::fileProcessed(const QString &fileName, qint64 matches, const QString &errorMessage) {
+    if (matches < 0) {
+        results->addItem(QDir::toNativeSeparators(fileName) + ": " + errorMessage);
+        return;
+    }
+    if (matches == 0)
+        return;
+
+    totalMatches += matches;
+    if (isReplacing)
+        changedFiles.append(fileName);
+    results->addItem(QDir::toNativeSeparators(fileName) + ": " + QString::number(matches));
+}
+
+void ReplaceInFilesDialog::progressChanged(int done, int total) {
+    progress->setMaximum(total);
+    progress->setValue(done);
+}
+
+void ReplaceInFilesDialog::finished(bool canceled) {
+    setRunning(false);
+
+    QString text = QString::number(totalMatches) +
+                   (isReplacing ? " words were replaced" : " words were found");
+    if (canceled)
+        text += " (canceled)";
+    summary->setText(text);
+}
+
+QStringList ReplaceInFilesDialog::collectFiles() const {
+    QStringList fileNames;
+    const QStringList filters = filterEdit->text().split(';', Qt::SkipEmptyParts);
+
+    QDirIterator it(folderEdit->text(), filters, QDir::Files | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        fileNames.append(it.next());
+
+    return fileNames;
+}
+
+void ReplaceInFilesDialog::setRunning(bool running) {
+    if (running) {
+        results->clear();
+        summary->clear();
+        totalMatches = 0;
+    }
+    previewButton->setEnabled(!running);
+    replaceButton->setEnabled(!running);
+    cancelButton->setEnabled(running);
+}
@@ -0,0 +1,138 @@
+#ifndef FILEREPLACER_H
+#define FILEREPLACER_H
+
+#include <QObject>
+#include <QDialog>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPushButton>
+#include <QProgressBar>
+#include <QLabel>
+
+// Замена во множестве файлов без загрузки их в редактор.
+// Каждый файл читается блоками фиксированного размера, результат пишется во временный файл,
+// который атомарно подменяет исходный (QSaveFile). Память не зависит от размера файлов.
+class FileReplacer : public QObject {
+    Q_OBJECT
+
+public:
+    FileReplacer(QObject *parent = nullptr);
+
+    ~FileReplacer();
+
+    // Подсчет совпадений без изменения файлов.
+    void preview(const QStringList &fileNames, const QString &oldString);
+
+    void replace(const QStringList &fileNames, const QString &oldString, const QString &newString);
+
+    void cancel();
+
+    bool isRunning() const;
+
+    // Размер буфера чтения одного файла.
+    static const int BufferSize = 64 * 1024;
+
+signals:
+    // matches = -1, если файл не удалось обработать (текст ошибки в errorMessage).
+    void fileProcessed(const QString &fileName, qint64 matches, const QString &errorMessage);
+
+    void progressChanged(int done, int total);
+
+    void finished(bool canceled);
+
+private:
+    void start(const QStringList &fileNames, const QByteArray &pattern,
+               const QByteArray &replacement, bool writeResult);
+
+    void taskFinished(int generation, const QString &fileName, qint64 matches, const QString &errorMessage);
+
+private:
+    friend class FileReplaceTask;
+
+    QThreadPool pool;
+    QAtomicInt canceled;
+
+    int generation;
+    int done;
+    int total;
+};
+
+// Задача обработки одного файла в пуле потоков.
+class FileReplaceTask : public QRunnable {
+public:
+    FileReplaceTask(FileReplacer *replacer, int generation, const QString &fileName,
+                    const QByteArray &pattern, const QByteArray &replacement, bool writeResult);
+
+    void run() override;
+
+    // Потоковая обработка: возвращает количество совпадений или -1 при ошибке/отмене.
+    static qint64 streamFile(const QString &fileName, const QByteArray &pattern,
+                             const QByteArray &replacement, bool writeResult,
+                             const QAtomicInt &canceled, QString *errorMessage);
+
+private:
+    FileReplacer *replacer;
+    int generation;
+    QString fileName;
+    QByteArray pattern;
+    QByteArray replacement;
+    bool writeResult;
+};
+
+// Диалог "Replace in files": выбор папки и маски, предпросмотр, замена и отмена.
+class ReplaceInFilesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ReplaceInFilesDialog(const QString &oldString, const QString &newString, QWidget *parent = nullptr);
+
+    // Файлы, которые были изменены последней заменой.
+    QStringList getChangedFiles() { return changedFiles; }
+
+protected:
+    void reject() override;
+
+private slots:
+    void browse();
+
+    void preview();
+
+    void replace();
+
+    void fileProcessed(const QString &fileName, qint64 matches, const QString &errorMessage);
+
+    void progressChanged(int done, int total);
+
+    void finished(bool canceled);
+
+private:
+    QStringList collectFiles() const;
+
+    void setRunning(bool running);
+
+private:
+    FileReplacer *replacer;
+
+    QLineEdit *findEdit;
+    QLineEdit *replaceEdit;
+    QLineEdit *folderEdit;
+    QLineEdit *filterEdit;
+    QListWidget *results;
+    QProgressBar *progress;
+    QLabel *summary;
+    QPushButton *previewButton;
+    QPushButton *replaceButton;
+    QPushButton *cancelButton;
+
+    QStringList changedFiles;
+    qint64 totalMatches;
+    bool isReplacing;
+};
+
+#endif // FILEREPLACER_H
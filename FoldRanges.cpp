@@ -0,0 +1,115 @@
+#include "FoldRanges.h"
+
+#include <algorithm>
+
+FoldRanges::FoldRanges(QTextDocument *document)
+    : QObject(document), document(document)
+{
+    revision = document->revision();
+    blockCount = document->blockCount();
+    connect(document, &QTextDocument::contentsChange, this, &FoldRanges::contentsChange);
+}
+
+FoldRanges* FoldRanges::forDocument(QTextDocument *document) {
+    FoldRanges *ranges = document->findChild<FoldRanges*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!ranges)
+        ranges = new FoldRanges(document);
+    return ranges;
+}
+
+void FoldRanges::add(const QTextBlock &start, const QTextBlock &end) {
+    folds.append({ start, BlockData::get(start), end, BlockData::get(end) });
+}
+
+void FoldRanges::remove(const QTextBlock &start) {
+    for (int i = 0; i < folds.size(); ++i) {
+        if (folds.at(i).start == start) {
+            folds.remove(i);
+            return;
+        }
+    }
+}
+
+QVector<QTextBlock> FoldRanges::takeReleased() {
+    QVector<QTextBlock> blocks;
+    for (const Line &line : released) {
+        if (isAlive(line.block, line.data))
+            blocks.append(line.block);
+    }
+    released.clear();
+    return blocks;
+}
+
+void FoldRanges::contentsChange(int position, int charsRemoved, int charsAdded) {
+    // Изменение только форматов (подсветка) не меняет ревизию документа.
+    if (charsRemoved == charsAdded && document->revision() == revision)
+        return;
+    revision = document->revision();
+    const int previousCount = blockCount;
+    blockCount = document->blockCount();
+    if (folds.isEmpty())
+        return;
+
+    const QTextBlock first = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid())
+        last = document->lastBlock();
+    const bool isLineEdit = first == last && blockCount == previousCount;
+    const int firstNumber = first.blockNumber();
+    const int lastNumber = last.blockNumber();
+
+    bool isReleased = false;
+    for (const Fold &fold : folds) {
+        if (isAlive(fold.start, fold.startData) && isAlive(fold.end, fold.endData)) {
+            if (lastNumber < fold.start.blockNumber() || firstNumber > fold.end.blockNumber())
+                continue;
+            if (isLineEdit && first == fold.start)
+                continue;
+        }
+        release(fold, first);
+        isReleased = true;
+    }
+    if (!isReleased)
+        return;
+
+    // Вложенные фрагменты разворачиваются вместе с внешним.
+    folds.erase(std::remove_if(folds.begin(), folds.end(), [](const Fold &fold) {
+        return !isAlive(fold.start, fold.startData) || !fold.startData->isFolded;
+    }), folds.end());
+    emit foldsReleased();
+}
+
+void FoldRanges::release(const Fold &fold, const QTextBlock &first) {
+    const bool isStartAlive = isAlive(fold.start, fold.startData);
+    const bool isEndAlive = isAlive(fold.end, fold.endData);
+    if (isStartAlive)
+        fold.startData->isFolded = false;
+
+    // Без первой строки скрытые строки ищутся от места правки: сама строка правки
+    // может быть видимой, если с ней слилась удаленная первая строка.
+    QTextBlock block = isStartAlive ? fold.start.next() : first;
+    if (!isStartAlive && block.isValid()) {
+        const BlockData *data = static_cast<const BlockData*>(block.userData());
+        if (!data || !data->isFoldHidden)
+            block = block.next();
+    }
+    if (isEndAlive && block.isValid() && block.blockNumber() > fold.end.blockNumber())
+        return;
+
+    for (; block.isValid(); block = block.next()) {
+        BlockData *data = static_cast<BlockData*>(block.userData());
+        if (!isEndAlive && (!data || !data->isFoldHidden))
+            break;
+        if (data && data->isFoldHidden) {
+            data->isFoldHidden = false;
+            data->isFolded = false;
+            released.append({ block, data });
+        }
+        if (block == fold.end)
+            break;
+    }
+}
+
+bool FoldRanges::isAlive(const QTextBlock &block, const BlockData *data) {
+    return block.isValid() && block.userData() == data;
+}
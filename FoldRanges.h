@@ -0,0 +1,70 @@
+#ifndef FOLDRANGES_H
+#define FOLDRANGES_H
+
+#include "BlockData.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QVector>
+
+// Свернутые фрагменты документа. Флаги строк (isFolded, isFoldHidden) сами по себе не знают,
+// к какому фрагменту относятся, поэтому фрагмент хранится отдельно: он привязан к своей первой
+// строке и помнит последнюю скрытую. Правка, затронувшая скрытые строки или разбившая либо
+// удалившая первую строку, разворачивает фрагмент; иначе Enter в первой строке или ее удаление
+// оставили бы скрытые строки без фрагмента, и развернуть их было бы нечем.
+// Правка внутри первой строки, не меняющая числа строк, фрагмент сохраняет.
+class FoldRanges : public QObject {
+    Q_OBJECT
+
+public:
+    // Фрагменты документа; создаются при первом обращении и принадлежат документу.
+    static FoldRanges* forDocument(QTextDocument *document);
+
+    // Фрагмент start..end свернут (end - последняя скрытая строка); флаги строк выставляет редактор.
+    void add(const QTextBlock &start, const QTextBlock &end);
+
+    // Фрагмент, начинающийся со start, развернут редактором.
+    void remove(const QTextBlock &start);
+
+    // Строки, развернутые правками с прошлого вызова; их видимость еще не обновлена.
+    QVector<QTextBlock> takeReleased();
+
+signals:
+    // Правка развернула фрагменты. Видимость строк меняется после завершения правки,
+    // поэтому сигнал подключается с Qt::QueuedConnection.
+    void foldsReleased();
+
+private slots:
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    FoldRanges(QTextDocument *document);
+
+    struct Fold {
+        QTextBlock start;
+        BlockData *startData;
+        QTextBlock end;
+        BlockData *endData;
+    };
+
+    struct Line {
+        QTextBlock block;
+        BlockData *data;
+    };
+
+    // Снятие флагов строк фрагмента; first - первая строка правки, если первая строка фрагмента удалена.
+    void release(const Fold &fold, const QTextBlock &first);
+
+    // Строка не удалена: у удаленной строки пользовательские данные уже другие.
+    static bool isAlive(const QTextBlock &block, const BlockData *data);
+
+private:
+    QTextDocument *document;
+    QVector<Fold> folds;
+    QVector<Line> released;
+    int revision;
+    int blockCount;
+};
+
+#endif // FOLDRANGES_H
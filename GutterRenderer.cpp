@@ -0,0 +1,61 @@
+#include "GutterRenderer.h"
+
+#include <QFontMetrics>
+
+GutterRenderer::GutterRenderer() {
+    cellWidth = 0;
+    cellHeight = 0;
+    pixelRatio = 1;
+}
+
+void GutterRenderer::setFont(const QFont &font, const QColor &color, qreal devicePixelRatio) {
+    const QString key = font.key() + color.name() + QString::number(devicePixelRatio);
+    if (key == atlasKey)
+        return;
+    atlasKey = key;
+
+    QFontMetrics metrics(font);
+    cellWidth = 0;
+    for (char digit = '0'; digit <= '9'; ++digit)
+        cellWidth = qMax(cellWidth, metrics.horizontalAdvance(QLatin1Char(digit)));
+    cellHeight = metrics.height();
+    pixelRatio = devicePixelRatio;
+
+    atlas = QPixmap(QSize(cellWidth * 10, cellHeight) * pixelRatio);
+    atlas.setDevicePixelRatio(pixelRatio);
+    atlas.fill(Qt::transparent);
+
+    QPainter painter(&atlas);
+    painter.setFont(font);
+    painter.setPen(color);
+    for (int digit = 0; digit < 10; ++digit) {
+        painter.drawText(QRect(digit * cellWidth, 0, cellWidth, cellHeight),
+                         Qt::AlignRight, QString(QLatin1Char(char('0' + digit))));
+    }
+}
+
+void GutterRenderer::drawNumber(QPainter *painter, int number, int right, int top) const {
+    // Цифры номера в обратном порядке.
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = char(number % 10);
+        number /= 10;
+    } while (number > 0);
+
+    int x = right - count * cellWidth;
+    for (int i = count - 1; i >= 0; --i, x += cellWidth) {
+        painter->drawPixmap(QRectF(x, top, cellWidth, cellHeight), atlas,
+                            QRectF(digits[i] * cellWidth * pixelRatio, 0,
+                                   cellWidth * pixelRatio, cellHeight * pixelRatio));
+    }
+}
+
+int GutterRenderer::getLineHeight() const {
+    return cellHeight;
+}
+
+
+qint64 GutterRenderer::memoryUsage() const {
+    return qint64(atlas.width()) * atlas.height() * atlas.depth() / 8;
+}
@@ -0,0 +1,36 @@
+#ifndef GUTTERRENDERER_H
+#define GUTTERRENDERER_H
+
+#include <QPainter>
+#include <QPixmap>
+#include <QFont>
+#include <QColor>
+#include <QString>
+
+// Отрисовка номеров строк из кэша заранее отрисованных цифр.
+// Цифры 0-9 рисуются один раз в одну полосу (атлас) для текущего шрифта,
+// номер строки собирается копированием цифр из атласа без создания строк и без разбора текста.
+class GutterRenderer {
+public:
+    GutterRenderer();
+
+    // Атлас перестраивается, только если изменились шрифт, цвет или плотность пикселей.
+    void setFont(const QFont &font, const QColor &color, qreal devicePixelRatio);
+
+    // Номер выравнивается по правому краю right, top - верх строки текста.
+    void drawNumber(QPainter *painter, int number, int right, int top) const;
+
+    int getLineHeight() const;
+
+    // Размер атласа, байт.
+    qint64 memoryUsage() const;
+
+private:
+    QPixmap atlas;
+    QString atlasKey;
+    int cellWidth;
+    int cellHeight;
+    qreal pixelRatio;
+};
+
+#endif // GUTTERRENDERER_H
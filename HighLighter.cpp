@@ -1,66 +1,146 @@
 #include "HighLighter.h"
+#include "CodeFolding.h"
+#include "BracketIndex.h"
+#include "SymbolIndex.h"
+#include "LayoutBudget.h"
 
 Highlighter::Highlighter(QTextDocument *parent)
     : QSyntaxHighlighter(parent)
 {   
     isActive = true;
+    isDeferred = false;
+    highlightTime = 0;
     languageVersion = LanguageVersion::C89;
 
-    // Добавление стиля ATB.
-    if (QFile::exists(":Styles/ATB.json")) {
-        QFile file(":Styles/ATB.json");
-        if (file.open(QFile::ReadOnly)) {
-            QByteArray data = file.readAll();
-            QTextCodec *codec = Qt::codecForHtml(data);
+    // При запуске читается только стиль по умолчанию, остальные встроенные стили - при выборе.
+    loadResourceStyle("Default");
+}
 
-            std::istringstream stream(codec->toUnicode(data).toStdString());
-            setStyle(stream, "ATB");
+void Highlighter::highlightBlock(const QString &text)
+{
+    TraceScope trace("Highlighter::highlightBlock");
+    QElapsedTimer timer;
+    timer.start();
+    // Скрытые строки (свернутые или отброшенные фильтром) и строки первого отложенного прохода
+    // не подсвечиваются: для них обновляются только скобки и состояние комментария.
+    BlockData *data = BlockData::get(currentBlock());
+    BracketIndex::forDocument(document())->blockChanged(currentBlock().blockNumber());
+    if (!currentBlock().isVisible() || isDeferred) {
+        setCurrentBlockState(CodeFolding::scanBlock(text, previousBlockState(), data));
+        data->isHighlightSkipped = true;
+
+        // Проход по документу всегда заканчивается его последней строкой.
+        if (isDeferred && !currentBlock().next().isValid()) {
+            isDeferred = false;
+            emit deferredPassFinished();
+        }
+        highlightTime += timer.nsecsElapsed();
+        return;
+    }
+    data->isHighlightSkipped = false;
+    CodeFolding::scanBlock(text, previousBlockState(), data);
+
+    QVector<HighlightEngine::Span> spans;
+    QVector<HighlightEngine::Span> symbolSpans;
+    setCurrentBlockState(engine.highlightLine(text, previousBlockState(), spans, &symbolSpans));
+
+    // Классы лексем начала строки для миникарты.
+    quint8 classes[BlockData::TokenColumns];
+    const int columns = qMin(text.length(), int(BlockData::TokenColumns));
+    for (int i = 0; i < columns; ++i)
+        classes[i] = text.at(i).isSpace() ? BlockData::NoToken : BlockData::PlainToken;
+
+    for (const HighlightEngine::Span &span : spans) {
+        setFormat(span.start, span.length, engine.format(span.kind));
+        for (int i = span.start; i < qMin(span.start + span.length, columns); ++i) {
+            if (classes[i] != BlockData::NoToken)
+                classes[i] = quint8(tokenClass(span.kind));
         }
     }
 
-    // Добавление стиля по умолчанию.
-    if (QFile::exists(":Styles/Default.json")) {
-        QFile file(":Styles/Default.json");
-        if (file.open(QFile::ReadOnly)) {
-            QByteArray data = file.readAll();
-            QTextCodec *codec = Qt::codecForHtml(data);
+    // Совпадения правил функций и классов попадают в таблицу символов документа.
+    SymbolIndex *symbolIndex = SymbolIndex::forDocument(document());
+    QVector<BlockData::Symbol> symbols;
+    for (const HighlightEngine::Span &span : symbolSpans) {
+        const int kind = span.kind == HighlightEngine::Class ? SymbolIndex::Class : SymbolIndex::Function;
+        symbols.append({ symbolIndex->nameId(text.mid(span.start, span.length)), kind, span.start });
+    }
 
-            std::istringstream stream(codec->toUnicode(data).toStdString());
-            setStyle(stream, "Default");
-        }
+    symbolIndex->setBlockSymbols(currentBlock(), data, symbols);
+    updateTokenRuns(data, classes, columns);
+    LayoutBudget::forDocument(document())->blockHighlighted(currentBlock(), spans.size());
+    highlightTime += timer.nsecsElapsed();
+}
+
+BlockData::TokenClass Highlighter::tokenClass(HighlightEngine::TokenKind kind) {
+    switch (kind) {
+    case HighlightEngine::Keyword:
+        return BlockData::KeywordToken;
+    case HighlightEngine::Class:
+        return BlockData::ClassToken;
+    case HighlightEngine::Quotation:
+        return BlockData::QuotationToken;
+    case HighlightEngine::Include:
+        return BlockData::IncludeToken;
+    case HighlightEngine::Function:
+        return BlockData::FunctionToken;
+    case HighlightEngine::SingleLineComment:
+    case HighlightEngine::MultiLineComment:
+        return BlockData::CommentToken;
+    case HighlightEngine::Search:
+        return BlockData::SearchToken;
+    default:
+        return BlockData::PlainToken;
     }
 }
 
-void Highlighter::highlightBlock(const QString &text)
-{
-    foreach (const HighlightingRule &rule, highlightingRules) {
-            QRegExp expression(rule.pattern);
-            int index = expression.indexIn(text);
-            while (index >= 0) {
-                int length = expression.matchedLength();
-                setFormat(index, length, rule.format);
-                index = expression.indexIn(text, index + length);
-            }
+void Highlighter::updateTokenRuns(BlockData *data, const quint8 *classes, int columns) {
+    QByteArray runs;
+    int start = 0;
+    while (start < columns) {
+        int end = start + 1;
+        while (end < columns && classes[end] == classes[start])
+            ++end;
+        if (classes[start] != BlockData::NoToken) {
+            runs.append(char(start));
+            runs.append(char(end - start));
+            runs.append(char(classes[start]));
         }
-        setCurrentBlockState(0);
+        start = end;
+    }
 
-        int startIndex = 0;
-        if (previousBlockState() != 1)
-            startIndex = commentStartExpression.indexIn(text);
+    // Номер изменения общий для всех строк: по нему миникарта находит измененные участки.
+    static int tokenRevision = 0;
+    if (runs != data->tokenRuns) {
+        data->tokenRuns = runs;
+        data->tokenRevision = ++tokenRevision;
+    }
+}
 
-        while (startIndex >= 0) {
-            int endIndex = commentEndExpression.indexIn(text, startIndex);
-            int commentLength;
-            if (endIndex == -1) {
-                setCurrentBlockState(1);
-                commentLength = text.length() - startIndex;
-            } else {
-                commentLength = endIndex - startIndex
-                                + commentEndExpression.matchedLength();
-            }
-            setFormat(startIndex, commentLength, styles.value(styleVersion).multiLineCommentFormat);
-            startIndex = commentStartExpression.indexIn(text, startIndex + commentLength);
-        }
+QColor Highlighter::tokenColor(int tokenClass) const {
+    const Style style = styles.value(styleVersion);
+    auto color = [](const QTextCharFormat &format) {
+        return format.foreground().style() == Qt::NoBrush ? QColor() : format.foreground().color();
+    };
+
+    switch (tokenClass) {
+    case BlockData::KeywordToken:
+        return color(style.keywordFormat);
+    case BlockData::ClassToken:
+        return color(style.classFormat);
+    case BlockData::QuotationToken:
+        return color(style.quotationFormat);
+    case BlockData::IncludeToken:
+        return color(style.includeFormat);
+    case BlockData::FunctionToken:
+        return color(style.functionFormat);
+    case BlockData::CommentToken:
+        return color(style.multiLineCommentFormat);
+    case BlockData::SearchToken:
+        return QColor(Qt::red).lighter(160);
+    default:
+        return QColor();
+    }
 }
 
 void Highlighter::setLanguageVersion(LanguageVersion version) {
@@ -69,66 +149,30 @@ void Highlighter::setLanguageVersion(LanguageVersion version) {
 }
 
 void Highlighter::setStyle(QString styleName) {
+    // Встроенный стиль, еще не прочитанный из ресурсов, читается и сразу выбирается.
+    if (!styles.contains(styleName) && loadResourceStyle(styleName))
+        return;
+
     styleVersion = styleName;
     updateStyleFormats();
 }
 
-void Highlighter::setStyle(Style newStyle, QString styleName) {
-    QString errorMessage;
+bool Highlighter::loadResourceStyle(const QString &styleName) {
+    QFile file(":Styles/" + styleName + ".json");
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    Style style;
+    if (!StyleJson::read(file.readAll(), &style))
+        return false;
+    addStyle(styleName, style);
+    return true;
+}
 
+void Highlighter::setStyle(Style newStyle, QString styleName) {
     QFile file(styleName);
     if (file.open(QFile::WriteOnly | QFile::Text)) {
-        QTextStream out(&file);
-        out << "{\n"
-            << "  \"classFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.classFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.classFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.classFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.classFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"functionFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.functionFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.functionFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.functionFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.functionFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"includeFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.includeFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.includeFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.includeFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.includeFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"keywordFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.keywordFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.keywordFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.keywordFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.keywordFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"multiLineCommentFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.multiLineCommentFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.multiLineCommentFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.multiLineCommentFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.multiLineCommentFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"quotationFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.quotationFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.quotationFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.quotationFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.quotationFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"searchFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.searchFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.searchFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.searchFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.searchFormat.foreground().color().name() << "\"\n"
-            << "  },\n"
-            << "  \"singleLineCommentFormat\": {\n"
-            << "    \"FontItalic\": " <<    newStyle.singleLineCommentFormat.fontItalic() << ",\n"
-            << "    \"FontUnderline\": " << newStyle.singleLineCommentFormat.fontUnderline() << ",\n"
-            << "    \"FontWeight\": " <<    newStyle.singleLineCommentFormat.fontWeight() << ",\n"
-            << "    \"Foreground\": \"" <<  newStyle.singleLineCommentFormat.foreground().color().name() << "\"\n"
-            << "  }\n"
-            << "}";
+        file.write(StyleJson::write(newStyle));
         file.close();
     }
 
@@ -138,83 +182,10 @@ void Highlighter::setStyle(Style newStyle, QString styleName) {
     updateStyleFormats();
 }
 
-void Highlighter::setStyle(std::istringstream& style, QString styleName) {
-
-    QTextCharFormat newKeywordFormat;
-    QTextCharFormat newClassFormat;
-    QTextCharFormat newQuotationFormat;
-    QTextCharFormat newFunctionFormat;
-    QTextCharFormat newIncludeFormat;
-    QTextCharFormat newSingleLineCommentFormat;
-    QTextCharFormat newMultiLineCommentFormat;
-    QTextCharFormat newSearchFormat;
-
-    try {
-        std::string str;
-        style >> str;
-        if (str != "{")
-            throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-
-        size_t styleNumber = 8;
-        while (styleNumber > 0) {
-            style >> str;
-            if (str == "\"keywordFormat\":")
-                setFormats(newKeywordFormat, style);
-            else {
-                if (str == "\"classFormat\":")
-                    setFormats(newClassFormat, style);
-                else {
-                    if (str == "\"singleLineCommentFormat\":")
-                        setFormats(newSingleLineCommentFormat, style);
-                    else {
-                        if (str == "\"multiLineCommentFormat\":")
-                            setFormats(newMultiLineCommentFormat, style);
-                        else {
-                            if (str == "\"quotationFormat\":")
-                                setFormats(newQuotationFormat, style);
-                            else {
-                                if (str == "\"functionFormat\":")
-                                    setFormats(newFunctionFormat, style);
-                                else {
-                                    if (str == "\"includeFormat\":")
-                                        setFormats(newIncludeFormat, style);
-                                    else {
-                                        if (str == "\"searchFormat\":")
-                                            setFormats(newSearchFormat, style);
-                                        else
-                                            throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            styleNumber--;
-        }
-
-        styles.insert(
-            styleName,
-            {
-                newKeywordFormat,
-                newClassFormat,
-                newQuotationFormat,
-                newFunctionFormat,
-                newIncludeFormat,
-                newSingleLineCommentFormat,
-                newMultiLineCommentFormat,
-                newSearchFormat
-            }
-        );
-        styleVersion = styleName;
-        updateStyleFormats();
-
-    } catch (std::invalid_argument &exc) {
-        QMessageBox *messageBox = new QMessageBox();
-        messageBox->setText(exc.what());
-        messageBox->show();
-    }
+void Highlighter::addStyle(const QString &styleName, const Style &style) {
+    styles.insert(styleName, style);
+    styleVersion = styleName;
+    updateStyleFormats();
 }
 
 void Highlighter::selectSearch(QString newSearchString) {
@@ -222,207 +193,43 @@ void Highlighter::selectSearch(QString newSearchString) {
     updateStyleFormats();
 }
 
+void Highlighter::setDocumentDeferred(QTextDocument *newDocument) {
+    // Редактор находит подсветку среди потомков своего документа.
+    setParent(newDocument);
+    isDeferred = true;
+    setDocument(newDocument);
+}
+
 void Highlighter::setActive(bool isActive) {
     this->isActive = isActive;
     updateStyleFormats();
 }
 
+void Highlighter::copySettings(const Highlighter *other) {
+    styles = other->styles;
+    styleVersion = other->styleVersion;
+    languageVersion = other->languageVersion;
+    searchString = other->searchString;
+    isActive = other->isActive;
+    updateStyleFormats();
+}
+
 Style Highlighter::getStyle() const {
     return styles.value(styleVersion);
 }
 
-void Highlighter::updateLanguageVersion() {
-    if (isActive) {
-        HighlightingRule rule;
-        QVector<QString> keywordPatterns;
-        if (languageVersion == LanguageVersion::C89) {
-            keywordPatterns = {
-                // C89.
-                "\\bauto\\b", "\\bbreak\\b", "\\bcase\\b",
-                "\\bchar\\b", "\\bconst\\b", "\\bcontinue\\b",
-                "\\bdefault\\b", "\\bdo\\b", "\\bdouble\\b",
-                "\\belse\\b", "\\benum\\b", "\\bextern\\b",
-                "\\bfloat\\b", "\\bfor\\b", "\\bgoto\\b",
-                "\\bif\\b", "\\bint\\b", "\\blong\\b",
-                "\\bregister\\b", "\\breturn\\b", "\\bshort\\b",
-                "\\bsigned\\b", "\\bsigeof\\b", "\\bstatic\\b",
-                "\\bstruct\\b", "\\bswitch\\b", "\\btypedef\\b",
-                "\\bunion\\b", "\\bunsigned\\b", "\\bvoid\\b",
-                "\\bvolatile\\b", "\\bwhile\\b"
-            };
-        }
-
-        if (languageVersion == LanguageVersion::CPP98_03) {
-            keywordPatterns = {
-                // C89.
-                "\\bauto\\b", "\\bbreak\\b", "\\bcase\\b",
-                "\\bchar\\b", "\\bconst\\b", "\\bcontinue\\b",
-                "\\bdefault\\b", "\\bdo\\b", "\\bdouble\\b",
-                "\\belse\\b", "\\benum\\b", "\\bextern\\b",
-                "\\bfloat\\b", "\\bfor\\b", "\\bgoto\\b",
-                "\\bif\\b", "\\bint\\b", "\\blong\\b",
-                "\\bregister\\b", "\\breturn\\b", "\\bshort\\b",
-                "\\bsigned\\b", "\\bsigeof\\b", "\\bstatic\\b",
-                "\\bstruct\\b", "\\bswitch\\b", "\\btypedef\\b",
-                "\\bunion\\b", "\\bunsigned\\b", "\\bvoid\\b",
-                "\\bvolatile\\b", "\\bwhile\\b",
-
-                // C++98/03 (new).
-                "\\basm\\b", "\\bbool\\b", "\\bcatch\\b",
-                "\\bclass\\b", "\\bconst_cast\\b", "\\bdelete\\b",
-                "\\bdynamic_cast\\b", "\\bexplicit\\b", "\\bexport\\b",
-                "\\bfalse\\b", "\\bfriend\\b", "\\binline\\b",
-                "\\bmutable\\b", "\\bnamespace\\b", "\\bnew\\b",
-                "\\boperator\\b", "\\bprivate\\b", "\\bprotected\\b",
-                "\\bpublic\\b", "\\breinterpret_cast\\b", "\\bstatic_cast\\b",
-                "\\btemplate\\b", "\\bthis\\b", "\\bthrow\\b",
-                "\\btrue\\b", "\\btry\\b", "\\btypeid\\b",
-                "\\btypename\\b", "\\busing\\b", "\\bvirtual\\b",
-                "\\bwchar_t\\b"
-            };
-        }
-
-        if (languageVersion == LanguageVersion::CPP11) {
-            keywordPatterns = {
-                // C89.
-                "\\bauto\\b", "\\bbreak\\b", "\\bcase\\b",
-                "\\bchar\\b", "\\bconst\\b", "\\bcontinue\\b",
-                "\\bdefault\\b", "\\bdo\\b", "\\bdouble\\b",
-                "\\belse\\b", "\\benum\\b", "\\bextern\\b",
-                "\\bfloat\\b", "\\bfor\\b", "\\bgoto\\b",
-                "\\bif\\b", "\\bint\\b", "\\blong\\b",
-                "\\bregister\\b", "\\breturn\\b", "\\bshort\\b",
-                "\\bsigned\\b", "\\bsigeof\\b", "\\bstatic\\b",
-                "\\bstruct\\b", "\\bswitch\\b", "\\btypedef\\b",
-                "\\bunion\\b", "\\bunsigned\\b", "\\bvoid\\b",
-                "\\bvolatile\\b", "\\bwhile\\b",
-
-                // C++98/03 (new).
-                "\\basm\\b", "\\bbool\\b", "\\bcatch\\b",
-                "\\bclass\\b", "\\bconst_cast\\b", "\\bdelete\\b",
-                "\\bdynamic_cast\\b", "\\bexplicit\\b", "\\bexport\\b",
-                "\\bfalse\\b", "\\bfriend\\b", "\\binline\\b",
-                "\\bmutable\\b", "\\bnamespace\\b", "\\bnew\\b",
-                "\\boperator\\b", "\\bprivate\\b", "\\bprotected\\b",
-                "\\bpublic\\b", "\\breinterpret_cast\\b", "\\bstatic_cast\\b",
-                "\\btemplate\\b", "\\bthis\\b", "\\bthrow\\b",
-                "\\btrue\\b", "\\btry\\b", "\\btypeid\\b",
-                "\\btypename\\b", "\\busing\\b", "\\bvirtual\\b",
-                "\\bwchar_t\\b"
-
-                // C++11 (new).
-                "\\balignas\\b", "\\balignof\\b", "\\bchar16_t\\b",
-                "\\bchar32_t\\b", "\\bconstexpr\\b", "\\bdecltype\\b",
-                "\\bnoexcept\\b", "\\bnullptr\\b", "\\bstatic_assert\\b",
-                "\\bthread_local\\b"
-            };
-        }
-
-        for (const QString &pattern : keywordPatterns) {
-            rule.pattern = QRegExp(pattern);
-            rule.format = styles.value(styleVersion).keywordFormat;
-            highlightingRules.append(rule);
-        }
-    }
+bool Highlighter::isDeferredPass() const {
+    return isDeferred;
 }
 
-void Highlighter::updateStyleFormats() {
-    highlightingRules.clear();
-    if (isActive) {
-        HighlightingRule rule;
-
-        Style style = styles.value(styleVersion);
-
-        updateLanguageVersion();
-
-        rule.pattern = QRegExp("\\bQ[A-Za-z]+\\b");
-        rule.format = style.classFormat;
-        highlightingRules.append(rule);
-
-        rule.pattern = QRegExp("\".*\"");
-        rule.format = style.quotationFormat;
-        highlightingRules.append(rule);
-
-        rule.pattern = QRegExp("#include <.*>");
-        rule.format = style.includeFormat;
-        highlightingRules.append(rule);
-
-        rule.pattern = QRegExp("\\b[A-Za-z0-9_]+(?=\\()");
-        rule.format = style.functionFormat;
-        highlightingRules.append(rule);
-
-        rule.pattern = QRegExp("//[^\n]*");
-        rule.format = style.singleLineCommentFormat;
-        highlightingRules.append(rule);
-
-        commentStartExpression = QRegExp("/\\*");
-        commentEndExpression = QRegExp("\\*/");
-
-        if (!searchString.isEmpty()) {
-            style.searchFormat.setBackground(QColor(Qt::red).lighter(160));
-            rule.pattern = QRegExp(searchString, Qt::CaseSensitive, QRegExp::FixedString);
-            rule.format = style.searchFormat;
-            highlightingRules.append(rule);
-        }
-    }
+qint64 Highlighter::getHighlightTime() const {
+    return highlightTime;
 }
 
-void Highlighter::setFormats(QTextCharFormat& format, std::istringstream& style) {
-    std::string str;
-
-    style >> str;
-    if (str != "{")
-        throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-
-    size_t styleNumber = 4;
-    while (styleNumber > 0) {
-        if(!(style >> str)) {
-            break;
-        }
-        if (str == "\"Foreground\":") {
-            style >> str;
-            std::string foreground = str.substr(1,7);
-            format.setForeground(QBrush(QColor(QString(foreground.c_str()))));
-        } else {
-            if (str == "\"FontWeight\":") {
-                int fontWeight;
-                if (!(style >> fontWeight))
-                    throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-                style >> str;
-                if (str != ",")
-                    throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-                format.setFontWeight(fontWeight);
-            } else {
-                if (str == "\"FontItalic\":") {
-                    style >> str;
-                    if (str == "true," || str == "true" || str == "1," || str == "1") {
-                        format.setFontItalic(true);
-                    } else {
-                        if (str == "false," || str == "false" || str == "0," || str == "0") {
-                            format.setFontItalic(false);
-                        } else {
-                            throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-                        }
-                    }
-                } else {
-                    if (str == "\"FontUnderline\":") {
-                        style >> str;
-                        if (str == "true," || str == "true" || str == "1," || str == "1") {
-                            format.setFontUnderline(true);
-                        } else {
-                            if (str == "false," || str == "false" || str == "0," || str == "0") {
-                                format.setFontUnderline(false);
-                            } else {
-                                throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-                            }
-                        }
-                    } else {
-                        throw std::invalid_argument("Данный формат стиля не поддерживается системой.");
-                    }
-                }
-            }
-        }
-        styleNumber--;
-    }
-    style >> str;
+void Highlighter::updateStyleFormats() {
+    // Правила собираются заново под текущий стиль, версию языка и строку поиска.
+    if (isActive)
+        engine = HighlightEngine(styles.value(styleVersion), languageVersion, searchString);
+    else
+        engine = HighlightEngine();
 }
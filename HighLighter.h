@@ -1,42 +1,23 @@
 #ifndef HIGHLIGHTER_H
 #define HIGHLIGHTER_H
 
+#include "BlockData.h"
+#include "HighlightEngine.h"
+#include "Trace.h"
+
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
-#include <QRegExp>
 #include <QTextDocument>
-#include <QTextCodec>
-#include <QMessageBox>
 #include <QString>
 #include <QMap>
 #include <QFile>
 #include <QFileInfo>
-#include <QTextCodec>
 #include <QTextStream>
 #include <QDir>
-#include <QMessageBox>
-
-#include <sstream>
-#include <string>
-#include <stdexcept>
-
-enum class LanguageVersion {
-    C89,
-    CPP98_03,
-    CPP11
-};
-
-struct Style {
-    QTextCharFormat keywordFormat;
-    QTextCharFormat classFormat;
-    QTextCharFormat quotationFormat;
-    QTextCharFormat functionFormat;
-    QTextCharFormat includeFormat;
-    QTextCharFormat singleLineCommentFormat;
-    QTextCharFormat multiLineCommentFormat;
-    QTextCharFormat searchFormat;
-};
+#include <QElapsedTimer>
 
+// Подсветка документа редактора: участки HighlightEngine переносятся в форматы строк,
+// заодно обновляются сворачивание, скобки, символы и классы лексем для миникарты.
 class Highlighter : public QSyntaxHighlighter
 {
     Q_OBJECT
@@ -50,34 +31,53 @@ public:
 
     void setStyle(Style newStyle, QString styleName);
 
-    void setStyle(std::istringstream& style, QString styleName);
+    // Стиль, прочитанный из файла; стиль становится текущим.
+    void addStyle(const QString &styleName, const Style &style);
 
     void selectSearch(QString newSearchString);
 
     void setActive(bool isActive);
 
+    // Стили, версия языка, строка поиска и включенность переносятся с подсветки другого документа.
+    void copySettings(const Highlighter *other);
+
     Style getStyle() const;
 
+    // Цвет класса лексемы BlockData::TokenClass в текущем стиле; для обычного текста - недействительный.
+    QColor tokenColor(int tokenClass) const;
+
+    // Подключение к документу без полной подсветки: первый проход по документу (при загрузке текста
+    // или отложенный проход QSyntaxHighlighter) только размечает строки для сворачивания и
+    // помечает их неподсвеченными. По окончании прохода испускается deferredPassFinished,
+    // после чего строки подсвечиваются редактором, начиная с видимых.
+    void setDocumentDeferred(QTextDocument *document);
+
+    // Идет первый проход по документу, начатый setDocumentDeferred.
+    bool isDeferredPass() const;
+
+    // Суммарное время подсветки строк с создания подсветки, нс.
+    qint64 getHighlightTime() const;
+
+signals:
+    void deferredPassFinished();
+
 protected:
     void highlightBlock(const QString &text) override;
 
 private:
-    void updateLanguageVersion();
-
     void updateStyleFormats();
 
-    void setFormats(QTextCharFormat& format, std::istringstream& style);
+    // Чтение встроенного стиля :Styles/<styleName>.json; стиль становится текущим.
+    bool loadResourceStyle(const QString &styleName);
 
-private:
-    struct HighlightingRule
-    {
-        QRegExp pattern;
-        QTextCharFormat format;
-    };
-    QVector<HighlightingRule> highlightingRules;
+    // Класс лексемы миникарты для участка подсветки.
+    static BlockData::TokenClass tokenClass(HighlightEngine::TokenKind kind);
+
+    // Сжатая запись классов лексем строки для миникарты.
+    void updateTokenRuns(BlockData *data, const quint8 *classes, int columns);
 
-    QRegExp commentStartExpression;
-    QRegExp commentEndExpression;
+private:
+    HighlightEngine engine;
 
     QMap<QString, Style> styles;
 
@@ -87,6 +87,9 @@ private:
     QString styleVersion;
 
     bool isActive;
+    bool isDeferred;
+
+    qint64 highlightTime;
 };
 
 #endif // HIGHLIGHTER_H
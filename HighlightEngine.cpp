@@ -0,0 +1,187 @@
+#include "HighlightEngine.h"
+
+#include <QStringList>
+
+HighlightEngine::HighlightEngine() {
+    isActive = false;
+}
+
+HighlightEngine::HighlightEngine(const Style &style, LanguageVersion version, const QString &searchString) {
+    isActive = true;
+
+    formats[Keyword] = style.keywordFormat;
+    formats[Class] = style.classFormat;
+    formats[Quotation] = style.quotationFormat;
+    formats[Include] = style.includeFormat;
+    formats[Function] = style.functionFormat;
+    formats[SingleLineComment] = style.singleLineCommentFormat;
+    formats[MultiLineComment] = style.multiLineCommentFormat;
+    formats[Search] = style.searchFormat;
+    formats[Search].setBackground(QColor(Qt::red).lighter(160));
+
+    for (const QString &pattern : keywordPatterns(version))
+        rules.append({ QRegExp(pattern), Keyword });
+
+    rules.append({ QRegExp("\\bQ[A-Za-z]+\\b"), Class });
+    rules.append({ QRegExp("\".*\""), Quotation });
+    rules.append({ QRegExp("#include <.*>"), Include });
+    rules.append({ QRegExp("\\b[A-Za-z0-9_]+(?=\\()"), Function });
+    rules.append({ QRegExp("//[^\n]*"), SingleLineComment });
+
+    commentStartExpression = QRegExp("/\\*");
+    commentEndExpression = QRegExp("\\*/");
+
+    if (!searchString.isEmpty())
+        rules.append({ QRegExp(searchString, Qt::CaseSensitive, QRegExp::FixedString), Search });
+}
+
+int HighlightEngine::highlightLine(const QString &text, int previousState, QVector<Span> &spans,
+                                   QVector<Span> *symbols) const {
+    if (!isActive)
+        return 0;
+
+    // Выражения копируются: поиск меняет состояние QRegExp, а движок общий для потоков.
+    for (const Rule &rule : rules) {
+        QRegExp expression(rule.pattern);
+        int index = expression.indexIn(text);
+        while (index >= 0) {
+            const int length = expression.matchedLength();
+            spans.append({ index, length, rule.kind });
+            if (symbols && (rule.kind == Class || rule.kind == Function)
+                    && !isControlKeyword(expression.cap(0)))
+                symbols->append({ index, length, rule.kind });
+            index = expression.indexIn(text, index + length);
+        }
+    }
+
+    QRegExp commentStart(commentStartExpression);
+    QRegExp commentEnd(commentEndExpression);
+    int state = 0;
+
+    int startIndex = 0;
+    if (previousState != 1)
+        startIndex = commentStart.indexIn(text);
+
+    while (startIndex >= 0) {
+        const int endIndex = commentEnd.indexIn(text, startIndex);
+        int commentLength;
+        if (endIndex == -1) {
+            state = 1;
+            commentLength = text.length() - startIndex;
+        } else {
+            commentLength = endIndex - startIndex + commentEnd.matchedLength();
+        }
+        spans.append({ startIndex, commentLength, MultiLineComment });
+
+        // Имена внутри комментария символами не считаются.
+        if (symbols) {
+            for (int i = symbols->size() - 1; i >= 0; --i) {
+                if (symbols->at(i).start >= startIndex && symbols->at(i).start < startIndex + commentLength)
+                    symbols->remove(i);
+            }
+        }
+        startIndex = commentStart.indexIn(text, startIndex + commentLength);
+    }
+    return state;
+}
+
+QTextCharFormat HighlightEngine::format(TokenKind kind) const {
+    return formats[kind];
+}
+
+QVector<QString> HighlightEngine::keywordPatterns(LanguageVersion version) {
+    QVector<QString> patterns;
+    if (version == LanguageVersion::C89) {
+        patterns = {
+            // C89.
+            "\\bauto\\b", "\\bbreak\\b", "\\bcase\\b",
+            "\\bchar\\b", "\\bconst\\b", "\\bcontinue\\b",
+            "\\bdefault\\b", "\\bdo\\b", "\\bdouble\\b",
+            "\\belse\\b", "\\benum\\b", "\\bextern\\b",
+            "\\bfloat\\b", "\\bfor\\b", "\\bgoto\\b",
+            "\\bif\\b", "\\bint\\b", "\\blong\\b",
+            "\\bregister\\b", "\\breturn\\b", "\\bshort\\b",
+            "\\bsigned\\b", "\\bsigeof\\b", "\\bstatic\\b",
+            "\\bstruct\\b", "\\bswitch\\b", "\\btypedef\\b",
+            "\\bunion\\b", "\\bunsigned\\b", "\\bvoid\\b",
+            "\\bvolatile\\b", "\\bwhile\\b"
+        };
+    }
+
+    if (version == LanguageVersion::CPP98_03) {
+        patterns = {
+            // C89.
+            "\\bauto\\b", "\\bbreak\\b", "\\bcase\\b",
+            "\\bchar\\b", "\\bconst\\b", "\\bcontinue\\b",
+            "\\bdefault\\b", "\\bdo\\b", "\\bdouble\\b",
+            "\\belse\\b", "\\benum\\b", "\\bextern\\b",
+            "\\bfloat\\b", "\\bfor\\b", "\\bgoto\\b",
+            "\\bif\\b", "\\bint\\b", "\\blong\\b",
+            "\\bregister\\b", "\\breturn\\b", "\\bshort\\b",
+            "\\bsigned\\b", "\\bsigeof\\b", "\\bstatic\\b",
+            "\\bstruct\\b", "\\bswitch\\b", "\\btypedef\\b",
+            "\\bunion\\b", "\\bunsigned\\b", "\\bvoid\\b",
+            "\\bvolatile\\b", "\\bwhile\\b",
+
+            // C++98/03 (new).
+            "\\basm\\b", "\\bbool\\b", "\\bcatch\\b",
+            "\\bclass\\b", "\\bconst_cast\\b", "\\bdelete\\b",
+            "\\bdynamic_cast\\b", "\\bexplicit\\b", "\\bexport\\b",
+            "\\bfalse\\b", "\\bfriend\\b", "\\binline\\b",
+            "\\bmutable\\b", "\\bnamespace\\b", "\\bnew\\b",
+            "\\boperator\\b", "\\bprivate\\b", "\\bprotected\\b",
+            "\\bpublic\\b", "\\breinterpret_cast\\b", "\\bstatic_cast\\b",
+            "\\btemplate\\b", "\\bthis\\b", "\\bthrow\\b",
+            "\\btrue\\b", "\\btry\\b", "\\btypeid\\b",
+            "\\btypename\\b", "\\busing\\b", "\\bvirtual\\b",
+            "\\bwchar_t\\b"
+        };
+    }
+
+    if (version == LanguageVersion::CPP11) {
+        patterns = {
+            // C89.
+            "\\bauto\\b", "\\bbreak\\b", "\\bcase\\b",
+            "\\bchar\\b", "\\bconst\\b", "\\bcontinue\\b",
+            "\\bdefault\\b", "\\bdo\\b", "\\bdouble\\b",
+            "\\belse\\b", "\\benum\\b", "\\bextern\\b",
+            "\\bfloat\\b", "\\bfor\\b", "\\bgoto\\b",
+            "\\bif\\b", "\\bint\\b", "\\blong\\b",
+            "\\bregister\\b", "\\breturn\\b", "\\bshort\\b",
+            "\\bsigned\\b", "\\bsigeof\\b", "\\bstatic\\b",
+            "\\bstruct\\b", "\\bswitch\\b", "\\btypedef\\b",
+            "\\bunion\\b", "\\bunsigned\\b", "\\bvoid\\b",
+            "\\bvolatile\\b", "\\bwhile\\b",
+
+            // C++98/03 (new).
+            "\\basm\\b", "\\bbool\\b", "\\bcatch\\b",
+            "\\bclass\\b", "\\bconst_cast\\b", "\\bdelete\\b",
+            "\\bdynamic_cast\\b", "\\bexplicit\\b", "\\bexport\\b",
+            "\\bfalse\\b", "\\bfriend\\b", "\\binline\\b",
+            "\\bmutable\\b", "\\bnamespace\\b", "\\bnew\\b",
+            "\\boperator\\b", "\\bprivate\\b", "\\bprotected\\b",
+            "\\bpublic\\b", "\\breinterpret_cast\\b", "\\bstatic_cast\\b",
+            "\\btemplate\\b", "\\bthis\\b", "\\bthrow\\b",
+            "\\btrue\\b", "\\btry\\b", "\\btypeid\\b",
+            "\\btypename\\b", "\\busing\\b", "\\bvirtual\\b",
+            "\\bwchar_t\\b"
+
+            // C++11 (new).
+            "\\balignas\\b", "\\balignof\\b", "\\bchar16_t\\b",
+            "\\bchar32_t\\b", "\\bconstexpr\\b", "\\bdecltype\\b",
+            "\\bnoexcept\\b", "\\bnullptr\\b", "\\bstatic_assert\\b",
+            "\\bthread_local\\b"
+        };
+    }
+
+    return patterns;
+}
+
+bool HighlightEngine::isControlKeyword(const QString &word) {
+    // Правило функций находит и управляющие конструкции вида if (...) - они не символы.
+    static const QStringList keywords = {
+        "if", "for", "while", "switch", "return", "sizeof", "catch", "alignof", "decltype",
+        "static_assert", "noexcept", "typeid", "throw", "delete", "new", "defined"
+    };
+    return keywords.contains(word);
+}
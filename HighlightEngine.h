@@ -0,0 +1,74 @@
+#ifndef HIGHLIGHTENGINE_H
+#define HIGHLIGHTENGINE_H
+
+#include "SyntaxStyle.h"
+
+#include <QTextCharFormat>
+#include <QRegExp>
+#include <QVector>
+#include <QString>
+
+enum class LanguageVersion {
+    C89,
+    CPP98_03,
+    CPP11
+};
+
+// Правила подсветки C/C++ без документа и окон: строка и состояние предыдущей строки на входе,
+// участки подсветки на выходе. Движок не меняется после создания, поэтому один движок
+// можно использовать из нескольких потоков одновременно. Highlighter переносит участки
+// в документ редактора, пакетная подсветка - в HTML или ANSI.
+class HighlightEngine {
+public:
+    enum TokenKind {
+        Keyword,
+        Class,
+        Quotation,
+        Include,
+        Function,
+        SingleLineComment,
+        MultiLineComment,
+        Search,
+        TokenKindCount
+    };
+
+    struct Span {
+        int start;
+        int length;
+        TokenKind kind;
+    };
+
+    // Движок без правил: строки не подсвечиваются.
+    HighlightEngine();
+
+    HighlightEngine(const Style &style, LanguageVersion version, const QString &searchString = QString());
+
+    // Подсветка строки text. Участки добавляются в spans в порядке применения: более поздний
+    // участок перекрывает более ранние. Имена классов и функций вне комментариев (кроме
+    // управляющих конструкций) добавляются в symbols, если задано. previousState - состояние
+    // конца предыдущей строки; возвращается состояние конца строки: 1 - внутри /* */, иначе 0.
+    int highlightLine(const QString &text, int previousState, QVector<Span> &spans,
+                      QVector<Span> *symbols = nullptr) const;
+
+    QTextCharFormat format(TokenKind kind) const;
+
+private:
+    static QVector<QString> keywordPatterns(LanguageVersion version);
+
+    static bool isControlKeyword(const QString &word);
+
+private:
+    struct Rule {
+        QRegExp pattern;
+        TokenKind kind;
+    };
+    QVector<Rule> rules;
+
+    QRegExp commentStartExpression;
+    QRegExp commentEndExpression;
+
+    QTextCharFormat formats[TokenKindCount];
+    bool isActive;
+};
+
+#endif // HIGHLIGHTENGINE_H
@@ -0,0 +1,19 @@
+QT       += core gui
+
+TEMPLATE = lib
+CONFIG += staticlib c++11
+
+TARGET = HighlightEngine
+DESTDIR = $$OUT_PWD
+
+# The library shares the build directory with the editor; keep its objects apart.
+OBJECTS_DIR = .obj/HighlightEngine
+MOC_DIR = .moc/HighlightEngine
+
+SOURCES += \
+    HighlightEngine.cpp \
+    SyntaxStyle.cpp
+
+HEADERS += \
+    HighlightEngine.h \
+    SyntaxStyle.h
@@ -0,0 +1,244 @@
+#include "IdentifierIndex.h"
+
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+
+IdentifierIndex::IdentifierIndex(QTextDocument *document) : QObject(document), document(document) {
+    revision = document->revision();
+    deadWordCount = 0;
+
+    // Корень дерева.
+    nodes.append({ 0, -1, -1, 0, -1 });
+
+    for (QTextBlock block = document->firstBlock(); block.isValid(); block = block.next())
+        indexBlock(block);
+
+    connect(document, &QTextDocument::contentsChange, this, &IdentifierIndex::contentsChange);
+}
+
+IdentifierIndex* IdentifierIndex::forDocument(QTextDocument *document) {
+    IdentifierIndex *index = document->findChild<IdentifierIndex*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!index)
+        index = new IdentifierIndex(document);
+    return index;
+}
+
+QStringList IdentifierIndex::complete(const QString &prefix, const QTextBlock &near, int limit) const {
+    const int start = findNode(prefix);
+    if (start < 0)
+        return QStringList();
+
+    // Все слова поддерева префикса (обход в глубину без рекурсии).
+    QVector<int> candidates;
+    QVector<int> stack;
+    if (nodes.at(start).firstChild >= 0)
+        stack.append(nodes.at(start).firstChild);
+    while (!stack.isEmpty() && candidates.size() < MaxCandidates) {
+        const int node = stack.takeLast();
+        if (nodes.at(node).next >= 0)
+            stack.append(nodes.at(node).next);
+        if (nodes.at(node).firstChild >= 0)
+            stack.append(nodes.at(node).firstChild);
+        if (nodes.at(node).count > 0)
+            candidates.append(nodes.at(node).wordId);
+    }
+    if (candidates.isEmpty())
+        return QStringList();
+
+    // Расстояние в строках до ближайшего вхождения слова рядом с курсором.
+    QHash<int, int> distances;
+    QTextBlock up = near;
+    QTextBlock down = near.next();
+    for (int distance = 0; distance <= ProximityLines; ++distance) {
+        for (const QTextBlock &block : { up, down }) {
+            const BlockData *data = static_cast<const BlockData*>(block.userData());
+            if (!block.isValid() || !data)
+                continue;
+            for (int wordId : data->identifiers) {
+                if (!distances.contains(wordId))
+                    distances.insert(wordId, distance);
+            }
+        }
+        up = up.isValid() ? up.previous() : up;
+        down = down.isValid() ? down.next() : down;
+    }
+
+    // Обход остановлен на MaxCandidates: слова рядом с курсором добавляются, даже если обход до них не дошел.
+    if (candidates.size() >= MaxCandidates) {
+        QSet<int> collected(candidates.begin(), candidates.end());
+        for (QHash<int, int>::const_iterator it = distances.constBegin(); it != distances.constEnd(); ++it) {
+            const QString &word = words.at(it.key());
+            if (word.size() > prefix.size() && word.startsWith(prefix)
+                    && nodes.at(wordNodes.at(it.key())).count > 0 && !collected.contains(it.key()))
+                candidates.append(it.key());
+        }
+    }
+
+    QVector<QPair<double, int>> ranked;
+    ranked.reserve(candidates.size());
+    for (int wordId : candidates) {
+        double score = std::log(1.0 + nodes.at(wordNodes.at(wordId)).count);
+        QHash<int, int>::const_iterator it = distances.constFind(wordId);
+        if (it != distances.constEnd())
+            score += 4.0 * (1.0 - double(it.value()) / (ProximityLines + 1));
+        ranked.append(qMakePair(-score, wordId));
+    }
+
+    const int count = qMin(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end());
+
+    QStringList result;
+    for (int i = 0; i < count; ++i)
+        result.append(words.at(ranked.at(i).second));
+    return result;
+}
+
+qint64 IdentifierIndex::memoryUsage() const {
+    qint64 bytes = sizeof(IdentifierIndex);
+    bytes += nodes.capacity() * sizeof(Node) + wordNodes.capacity() * sizeof(int);
+    bytes += words.capacity() * sizeof(QString);
+    for (const QString &word : words)
+        bytes += 2 * word.capacity();
+    return bytes;
+}
+
+void IdentifierIndex::contentsChange(int position, int charsRemoved, int charsAdded) {
+    // Изменение только форматов (подсветка) не меняет ревизию и текст документа.
+    if (charsRemoved == charsAdded && document->revision() == revision)
+        return;
+    revision = document->revision();
+
+    // Удаленные строки вычли свои идентификаторы при удалении своих BlockData.
+    QTextBlock block = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid())
+        last = document->lastBlock();
+
+    while (block.isValid()) {
+        indexBlock(block);
+        if (block == last)
+            break;
+        block = block.next();
+    }
+
+    if (deadWordCount > MinDeadWords && deadWordCount > words.size() - deadWordCount)
+        compact();
+}
+
+void IdentifierIndex::indexBlock(QTextBlock block) {
+    BlockData *data = BlockData::get(block);
+    if (data->identifierIndex == this) {
+        for (int wordId : data->identifiers)
+            releaseWord(wordId);
+    }
+    data->identifiers.clear();
+    data->identifierIndex = this;
+
+    const QString text = block.text();
+    const QChar *chars = text.constData();
+    const int length = text.length();
+    int i = 0;
+    while (i < length) {
+        const QChar c = chars[i];
+        if (!c.isLetter() && c != '_') {
+            // Числа целиком пропускаются, чтобы их хвосты не стали идентификаторами.
+            if (c.isDigit()) {
+                while (i < length && (chars[i].isLetterOrNumber() || chars[i] == '_'))
+                    ++i;
+            } else {
+                ++i;
+            }
+            continue;
+        }
+
+        const int start = i;
+        while (i < length && (chars[i].isLetterOrNumber() || chars[i] == '_'))
+            ++i;
+        if (i - start < MinLength)
+            continue;
+
+        const int node = findNode(QString::fromRawData(chars + start, i - start), true);
+        if (nodes.at(node).wordId < 0) {
+            nodes[node].wordId = words.size();
+            words.append(text.mid(start, i - start));
+            wordNodes.append(node);
+            // Слово без вхождений считается исчезнувшим до первого учета.
+            ++deadWordCount;
+        }
+        retainWord(nodes.at(node).wordId);
+        data->identifiers.append(nodes.at(node).wordId);
+    }
+}
+
+int IdentifierIndex::findNode(const QString &word, bool create) {
+    int node = 0;
+    for (const QChar c : word) {
+        int child = nodes.at(node).firstChild;
+        while (child >= 0 && nodes.at(child).c != c.unicode())
+            child = nodes.at(child).next;
+
+        if (child < 0) {
+            if (!create)
+                return -1;
+            child = nodes.size();
+            nodes.append({ c.unicode(), -1, nodes.at(node).firstChild, 0, -1 });
+            nodes[node].firstChild = child;
+        }
+        node = child;
+    }
+    return node;
+}
+
+int IdentifierIndex::findNode(const QString &word) const {
+    return const_cast<IdentifierIndex*>(this)->findNode(word, false);
+}
+
+void IdentifierIndex::releaseWord(int wordId) {
+    if (--nodes[wordNodes.at(wordId)].count == 0)
+        ++deadWordCount;
+}
+
+void IdentifierIndex::retainWord(int wordId) {
+    if (nodes[wordNodes.at(wordId)].count++ == 0)
+        --deadWordCount;
+}
+
+void IdentifierIndex::compact() {
+    QVector<Node> oldNodes;
+    QVector<QString> oldWords;
+    QVector<int> oldWordNodes;
+    oldNodes.swap(nodes);
+    oldWords.swap(words);
+    oldWordNodes.swap(wordNodes);
+
+    nodes.append({ 0, -1, -1, 0, -1 });
+    QVector<int> newIds(oldWords.size(), -1);
+    for (int wordId = 0; wordId < oldWords.size(); ++wordId) {
+        const int count = oldNodes.at(oldWordNodes.at(wordId)).count;
+        if (count == 0)
+            continue;
+        const int node = findNode(oldWords.at(wordId), true);
+        nodes[node].wordId = words.size();
+        nodes[node].count = count;
+        newIds[wordId] = words.size();
+        words.append(oldWords.at(wordId));
+        wordNodes.append(node);
+    }
+    deadWordCount = 0;
+
+    // Исчезнувших слов нет ни в одной строке, поэтому у всех слов строк есть новые номера.
+    for (QTextBlock block = document->firstBlock(); block.isValid(); block = block.next()) {
+        BlockData *data = static_cast<BlockData*>(block.userData());
+        if (!data || data->identifierIndex != this)
+            continue;
+        for (int &wordId : data->identifiers)
+            wordId = newIds.at(wordId);
+    }
+}
+
+void IdentifierIndex::blockDataDestroyed(BlockData *data) {
+    for (int wordId : data->identifiers)
+        releaseWord(wordId);
+}
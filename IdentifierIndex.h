@@ -0,0 +1,97 @@
+#ifndef IDENTIFIERINDEX_H
+#define IDENTIFIERINDEX_H
+
+#include "BlockData.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QStringList>
+#include <QVector>
+#include <QString>
+
+// Префиксное дерево идентификаторов документа для автодополнения.
+// Идентификаторы каждой строки хранятся в BlockData, при изменении документа
+// пересчитываются только затронутые строки: их старые идентификаторы вычитаются из счетчиков,
+// новые - добавляются. Поиск по префиксу не зависит от размера документа.
+// Узлы слов, которых больше нет в документе, не удаляются по одному: дерево перестраивается,
+// когда таких слов становится больше, чем живых.
+class IdentifierIndex : public QObject {
+    Q_OBJECT
+
+public:
+    // Индекс документа; создается при первом обращении и принадлежит документу.
+    static IdentifierIndex* forDocument(QTextDocument *document);
+
+    // Идентификаторы, начинающиеся с prefix (кроме самого prefix), не более limit.
+    // Порядок - по частоте в документе и близости к строке near.
+    // Если слов с таким префиксом больше MaxCandidates, ранжируются только первые MaxCandidates
+    // в порядке обхода дерева (по сути произвольные) и слова в пределах ProximityLines от near:
+    // частое слово далеко от курсора может не попасть в список, пока префикс не станет длиннее.
+    QStringList complete(const QString &prefix, const QTextBlock &near, int limit) const;
+
+    // Оценка занимаемой памяти, байт.
+    qint64 memoryUsage() const;
+
+    // Идентификаторы короче MinLength не индексируются.
+    static const int MinLength = 2;
+
+    // Сколько строк выше и ниже near учитывается при оценке близости.
+    static const int ProximityLines = 100;
+
+    // Ограничение числа слов поддерева префикса, которые просматриваются для коротких префиксов.
+    static const int MaxCandidates = 20000;
+
+    // Допустимая задержка от нажатия клавиши до показа списка, нс; время complete
+    // на большом документе проверяет CompletionBenchmark.
+    static const qint64 CompletionBudget = 5000000;
+
+    // Дерево перестраивается, когда слов, исчезнувших из документа, больше MinDeadWords
+    // и больше, чем оставшихся.
+    static const int MinDeadWords = 1024;
+
+private slots:
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    // Узел дерева: дети связаны в список через next.
+    struct Node {
+        ushort c;
+        int firstChild;
+        int next;
+        int count;      // сколько раз слово, заканчивающееся в узле, встречается в документе
+        int wordId;
+    };
+
+    IdentifierIndex(QTextDocument *document);
+
+    void indexBlock(QTextBlock block);
+
+    // Узел слова; при create недостающие узлы добавляются.
+    int findNode(const QString &word, bool create);
+
+    int findNode(const QString &word) const;
+
+    // Счетчик слова уменьшился или увеличился; учитываются слова, исчезнувшие из документа.
+    void releaseWord(int wordId);
+
+    void retainWord(int wordId);
+
+    // Перестроение дерева только из слов, встречающихся в документе; номера слов в строках обновляются.
+    void compact();
+
+    void blockDataDestroyed(BlockData *data);
+
+private:
+    friend class BlockData;
+
+    QTextDocument *document;
+    int revision;
+
+    QVector<Node> nodes;
+    QVector<QString> words;
+    QVector<int> wordNodes;
+    int deadWordCount;
+};
+
+#endif // IDENTIFIERINDEX_H
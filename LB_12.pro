@@ -1,33 +1,23 @@
-QT       += core gui
+TEMPLATE = subdirs
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+# Highlighting engine (tokenizer and style model), the editor that links it,
+# the completion benchmark (make check fails when completion is over budget),
+# the bracket matching test and the startup benchmark (time to the first paint).
+SUBDIRS += \
+    engine \
+    app \
+    benchmark \
+    brackettest \
+    startup
 
-CONFIG += c++11
+engine.file = HighlightEngine.pro
 
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+app.file = TextEditor.pro
+app.depends = engine
 
-SOURCES += \
-    ColorListEditor.cpp \
-    HighLighter.cpp \
-    TextEdit.cpp \
-    main.cpp \
-    mainwindow.cpp
+benchmark.file = CompletionBenchmark.pro
 
-HEADERS += \
-    ColorListEditor.h \
-    HighLighter.h \
-    TextEdit.h \
-    mainwindow.h
+brackettest.file = BracketIndexTest.pro
 
-FORMS += \
-    mainwindow.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
-
-RESOURCES += \
-    Styles.qrc
+startup.file = StartupBenchmark.pro
+startup.depends = engine
@@ -0,0 +1,156 @@
+#include "LayoutBudget.h"
+#include "MemoryUsage.h"
+
+#include <QTextLayout>
+#include <QElapsedTimer>
+
+LayoutBudget::LayoutBudget(QTextDocument *document)
+    : QObject(document), budget(0), residentSize(0), trimRemaining(0)
+{
+    trimTimer.setInterval(0);
+    connect(&trimTimer, &QTimer::timeout, this, &LayoutBudget::trimStep);
+}
+
+LayoutBudget* LayoutBudget::forDocument(QTextDocument *document) {
+    LayoutBudget *layoutBudget = document->findChild<LayoutBudget*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!layoutBudget)
+        layoutBudget = new LayoutBudget(document);
+    return layoutBudget;
+}
+
+void LayoutBudget::setBudget(qint64 bytes) {
+    budget = qMax(qint64(0), bytes);
+    if (budget > 0) {
+        if (residentSize > budget && !trimTimer.isActive()) {
+            trimRemaining = entries.size();
+            trimTimer.start();
+        }
+        return;
+    }
+
+    // Без ограничения учет не нужен; уже выгруженные строки остаются неподсвеченными до показа.
+    trimTimer.stop();
+    for (const Entry &entry : entries) {
+        if (entry.block.userData() != entry.data)
+            continue;
+        entry.data->isLayoutResident = false;
+        entry.data->isRecentlyShown = false;
+        entry.data->residentBytes = 0;
+        entry.data->layoutBudget = nullptr;
+    }
+    entries.clear();
+    residentSize = 0;
+}
+
+bool LayoutBudget::isEnabled() const {
+    return budget > 0;
+}
+
+void LayoutBudget::blockShown(const QTextBlock &block) {
+    if (budget == 0)
+        return;
+
+    BlockData *data = BlockData::get(block);
+    data->isRecentlyShown = true;
+    track(block, data, MemoryUsage::layoutSize(block)
+                       + MemoryUsage::formatSize(block.layout()->formats().size()));
+}
+
+void LayoutBudget::blockHighlighted(const QTextBlock &block, int formatCount) {
+    if (budget == 0)
+        return;
+
+    // Строки без форматов и разметки (первый проход подсветки) не учитываются,
+    // иначе очередь учета содержала бы все строки документа.
+    BlockData *data = BlockData::get(block);
+    const qint64 bytes = MemoryUsage::layoutSize(block) + MemoryUsage::formatSize(formatCount);
+    if (bytes == 0 && !data->isLayoutResident)
+        return;
+    track(block, data, bytes);
+}
+
+void LayoutBudget::blockLaidOut(const QTextBlock &block) {
+    if (budget == 0)
+        return;
+    track(block, BlockData::get(block), MemoryUsage::layoutSize(block)
+                                        + MemoryUsage::formatSize(block.layout()->formats().size()));
+}
+
+void LayoutBudget::setShownRange(const QObject *view, int firstBlock, int lastBlock) {
+    shownRanges.insert(view, qMakePair(firstBlock, lastBlock));
+}
+
+void LayoutBudget::removeView(const QObject *view) {
+    shownRanges.remove(view);
+}
+
+bool LayoutBudget::isShown(int blockNumber) const {
+    for (const QPair<int, int> &range : shownRanges) {
+        if (blockNumber >= range.first && blockNumber <= range.second)
+            return true;
+    }
+    return false;
+}
+
+qint64 LayoutBudget::getResidentSize() const {
+    return residentSize;
+}
+
+void LayoutBudget::track(const QTextBlock &block, BlockData *data, qint64 bytes) {
+    if (!data->isLayoutResident) {
+        data->isLayoutResident = true;
+        data->layoutBudget = this;
+        entries.push_back({ data, block });
+    }
+    residentSize += bytes - data->residentBytes;
+    data->residentBytes = int(bytes);
+
+    if (residentSize > budget && !trimTimer.isActive()) {
+        trimRemaining = entries.size();
+        trimTimer.start();
+    }
+}
+
+void LayoutBudget::trimStep() {
+    QElapsedTimer timer;
+    timer.start();
+
+    while (residentSize > budget && trimRemaining > 0 && !entries.empty() && timer.elapsed() < TrimSlice) {
+        const Entry entry = entries.front();
+        entries.pop_front();
+        --trimRemaining;
+
+        // Строка удалена или уже выгружена по более ранней записи.
+        if (entry.block.userData() != entry.data || !entry.data->isLayoutResident)
+            continue;
+
+        if (entry.data->isRecentlyShown || isShown(entry.block.blockNumber())) {
+            entry.data->isRecentlyShown = false;
+            entries.push_back(entry);
+            continue;
+        }
+        release(entry.block, entry.data);
+    }
+
+    if (residentSize <= budget || trimRemaining == 0 || entries.empty())
+        trimTimer.stop();
+}
+
+void LayoutBudget::release(QTextBlock block, BlockData *data) {
+    // Число строк блока хранится в документе отдельно от разметки, поэтому высота документа
+    // и полоса прокрутки не меняются.
+    block.layout()->clearFormats();
+    block.clearLayout();
+    data->isHighlightSkipped = true;
+
+    residentSize -= data->residentBytes;
+    data->residentBytes = 0;
+    data->isLayoutResident = false;
+    data->isRecentlyShown = false;
+    data->layoutBudget = nullptr;
+}
+
+void LayoutBudget::blockDataDestroyed(BlockData *data) {
+    // Запись в очереди остается и отбрасывается при обходе.
+    residentSize -= data->residentBytes;
+}
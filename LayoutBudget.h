@@ -0,0 +1,93 @@
+#ifndef LAYOUTBUDGET_H
+#define LAYOUTBUDGET_H
+
+#include "BlockData.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTimer>
+#include <QHash>
+#include <QPair>
+
+#include <deque>
+
+// Режим малой памяти: разметка строк (QTextLayout) и форматы подсветки держатся только
+// для строк в пределах бюджета. Строки учитываются при отрисовке и при подсветке; когда оценка
+// их разметки и форматов превышает бюджет, у давно не показанных строк они удаляются, а строка
+// помечается неподсвеченной. При следующем показе строка размечается заново, а подсветка
+// восстанавливается по сохраненному состоянию предыдущей строки за время, пропорциональное ее длине.
+// Выбор строки для выгрузки - "второй шанс": строка, показанная после прошлого обхода, остается.
+// Строки на экране какого-либо представления не выгружаются никогда: иначе выгрузка и
+// восстановление видимых строк чередовались бы после каждой отрисовки.
+class LayoutBudget : public QObject {
+    Q_OBJECT
+
+public:
+    // Бюджет документа; создается при первом обращении и принадлежит документу.
+    static LayoutBudget* forDocument(QTextDocument *document);
+
+    // Бюджет в байтах; 0 - без ограничения, строки не учитываются.
+    void setBudget(qint64 bytes);
+
+    bool isEnabled() const;
+
+    // Строка нарисована редактором.
+    void blockShown(const QTextBlock &block);
+
+    // Подсветка задала строке formatCount диапазонов форматов.
+    void blockHighlighted(const QTextBlock &block, int formatCount);
+
+    // Строка размечена фоновым уточнением высот редактора.
+    void blockLaidOut(const QTextBlock &block);
+
+    // Строки с номерами firstBlock..lastBlock на экране представления view.
+    void setShownRange(const QObject *view, int firstBlock, int lastBlock);
+
+    void removeView(const QObject *view);
+
+    // Оценка разметки и форматов учтенных строк, байт.
+    qint64 getResidentSize() const;
+
+    static const int TrimSlice = 8;
+
+private slots:
+    // Выгрузка строк, не дольше TrimSlice мс за вызов; за один обход каждая строка
+    // рассматривается не больше одного раза.
+    void trimStep();
+
+private:
+    LayoutBudget(QTextDocument *document);
+
+    // Учет строки; оценка уже учтенной строки уточняется.
+    void track(const QTextBlock &block, BlockData *data, qint64 bytes);
+
+    void release(QTextBlock block, BlockData *data);
+
+    void blockDataDestroyed(BlockData *data);
+
+    bool isShown(int blockNumber) const;
+
+private:
+    friend class BlockData;
+
+    struct Entry {
+        BlockData *data;
+        QTextBlock block;
+    };
+
+    qint64 budget;
+    qint64 residentSize;
+
+    // Учтенные строки в порядке учета. Строка проверяется при выгрузке:
+    // у удаленной строки пользовательские данные уже другие.
+    std::deque<Entry> entries;
+
+    // Номера первой и последней строки на экране каждого представления.
+    QHash<const QObject*, QPair<int, int>> shownRanges;
+
+    QTimer trimTimer;
+    size_t trimRemaining;
+};
+
+#endif // LAYOUTBUDGET_H
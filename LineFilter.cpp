@@ -0,0 +1,115 @@
+#include "LineFilter.h"
+
+#include <QStringMatcher>
+
+LineFilter::LineFilter(QObject *parent) : QObject(parent) {
+    revision = 0;
+    pendingRanges = 0;
+    generation = 0;
+}
+
+LineFilter::~LineFilter() {
+    cancel();
+    pool.waitForDone();
+}
+
+void LineFilter::start(QTextDocument *document, const QString &pattern) {
+    cancel();
+    pool.waitForDone();
+    canceled.storeRelease(0);
+
+    this->document = document;
+    this->pattern = pattern;
+    revision = document->revision();
+    nextBlock = document->firstBlock();
+    matches = QBitArray(document->blockCount());
+    pendingRanges = 0;
+    startRanges();
+}
+
+void LineFilter::cancel() {
+    // Результаты уже запущенных задач отбрасываются по номеру запуска.
+    canceled.storeRelease(1);
+    ++generation;
+    nextBlock = QTextBlock();
+    pendingRanges = 0;
+}
+
+void LineFilter::startRanges() {
+    const int threadCount = qMax(1, pool.maxThreadCount());
+    while (pendingRanges < threadCount && nextBlock.isValid()) {
+        const int firstLine = nextBlock.blockNumber();
+        QString text;
+        int lineCount = 0;
+        for (; nextBlock.isValid() && text.size() < RangeSize; nextBlock = nextBlock.next()) {
+            if (lineCount > 0)
+                text.append(QLatin1Char('\n'));
+            text.append(nextBlock.text());
+            ++lineCount;
+        }
+
+        ++pendingRanges;
+        pool.start(new LineFilterTask(this, generation, firstLine, text, lineCount, pattern));
+    }
+}
+
+void LineFilter::rangeFinished(int taskGeneration, int firstLine, const QBitArray &lines) {
+    if (taskGeneration != generation)
+        return;
+
+    // Документ изменился между чтениями диапазонов - отбор начинается заново.
+    if (!document || document->revision() != revision) {
+        if (document)
+            start(document, pattern);
+        return;
+    }
+
+    for (int i = 0; i < lines.size(); ++i) {
+        if (lines.testBit(i))
+            matches.setBit(firstLine + i);
+    }
+
+    --pendingRanges;
+    startRanges();
+    if (pendingRanges > 0)
+        return;
+
+    const QBitArray result = matches;
+    matches = QBitArray();
+    emit finished(result);
+}
+
+
+LineFilterTask::LineFilterTask(LineFilter *filter, int generation, int firstLine,
+                               const QString &text, int lineCount, const QString &pattern)
+    : filter(filter), generation(generation), firstLine(firstLine),
+      text(text), lineCount(lineCount), pattern(pattern)
+{}
+
+void LineFilterTask::run() {
+    QStringMatcher matcher(pattern, Qt::CaseSensitive);
+    const QChar *data = text.constData();
+    const int end = text.size();
+
+    QBitArray lines(lineCount);
+    int lineStart = 0;
+    for (int line = 0; line < lineCount; ++line) {
+        if ((line & 0xfff) == 0 && filter->canceled.loadAcquire())
+            return;
+
+        int lineEnd = lineStart;
+        while (lineEnd < end && data[lineEnd] != QLatin1Char('\n'))
+            ++lineEnd;
+
+        if (matcher.indexIn(data + lineStart, lineEnd - lineStart) >= 0)
+            lines.setBit(line);
+        lineStart = lineEnd + 1;
+    }
+
+    LineFilter *receiver = filter;
+    const int taskGeneration = generation;
+    const int taskFirstLine = firstLine;
+    QMetaObject::invokeMethod(receiver, [receiver, taskGeneration, taskFirstLine, lines]() {
+        receiver->rangeFinished(taskGeneration, taskFirstLine, lines);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,77 @@
+#ifndef LINEFILTER_H
+#define LINEFILTER_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QPointer>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QString>
+
+// Фоновый отбор строк, содержащих заданную строку.
+// Документ делится на диапазоны строк, диапазоны обрабатываются параллельно,
+// результат - по одному биту на строку документа.
+// Документ нельзя читать из другого потока, пока редактор может его менять, поэтому текст
+// диапазона читается из строк в главном потоке перед запуском задачи. Одновременно в работе
+// не больше диапазонов, чем потоков, так что копия всего текста документа не создается.
+class LineFilter : public QObject {
+    Q_OBJECT
+
+public:
+    LineFilter(QObject *parent = nullptr);
+
+    ~LineFilter();
+
+    void start(QTextDocument *document, const QString &pattern);
+
+    void cancel();
+
+    // Размер диапазона, символов: диапазон заканчивается на строке, после которой он не меньше.
+    static const int RangeSize = 256 * 1024;
+
+signals:
+    // matches.testBit(i) - содержит ли строка i искомую строку.
+    void finished(const QBitArray &matches);
+
+private:
+    // Запуск задач для следующих диапазонов, пока заняты не все потоки.
+    void startRanges();
+
+    void rangeFinished(int generation, int firstLine, const QBitArray &lines);
+
+private:
+    friend class LineFilterTask;
+
+    QThreadPool pool;
+    QAtomicInt canceled;
+
+    QPointer<QTextDocument> document;
+    QString pattern;
+    int revision;
+    QTextBlock nextBlock;
+    QBitArray matches;
+    int pendingRanges;
+    int generation;
+};
+
+// Отбор строк диапазона, начинающегося со строки firstLine; text - строки диапазона через '\n'.
+class LineFilterTask : public QRunnable {
+public:
+    LineFilterTask(LineFilter *filter, int generation, int firstLine,
+                   const QString &text, int lineCount, const QString &pattern);
+
+    void run() override;
+
+private:
+    LineFilter *filter;
+    int generation;
+    int firstLine;
+    QString text;
+    int lineCount;
+    QString pattern;
+};
+
+#endif // LINEFILTER_H
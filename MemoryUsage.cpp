@@ -0,0 +1,136 @@
+#include "MemoryUsage.h"
+#include "BlockData.h"
+#include "SymbolIndex.h"
+#include "IdentifierIndex.h"
+#include "BracketIndex.h"
+
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+qint64 MemoryUsage::Report::total() const {
+    qint64 sum = 0;
+    for (int component = 0; component < ComponentCount; ++component)
+        sum += bytes[component];
+    return sum;
+}
+
+void MemoryUsage::Report::add(const Report &other) {
+    for (int component = 0; component < ComponentCount; ++component)
+        bytes[component] += other.bytes[component];
+}
+
+MemoryUsage::MemoryUsage(QTextDocument *document)
+    : QObject(document), document(document), removedCharacters(0)
+{
+    revision = document->revision();
+    connect(document, &QTextDocument::contentsChange, this, &MemoryUsage::contentsChange);
+}
+
+MemoryUsage* MemoryUsage::forDocument(QTextDocument *document) {
+    MemoryUsage *usage = document->findChild<MemoryUsage*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!usage)
+        usage = new MemoryUsage(document);
+    return usage;
+}
+
+void MemoryUsage::contentsChange(int position, int charsRemoved, int charsAdded) {
+    Q_UNUSED(position)
+    // Изменение только форматов (подсветка) не меняет ревизию документа.
+    if (charsRemoved == charsAdded && document->revision() == revision)
+        return;
+    revision = document->revision();
+
+    // Без истории отмены (загрузка через setPlainText) буфер документа создается заново.
+    if (!document->isUndoRedoEnabled()) {
+        removedCharacters = 0;
+        return;
+    }
+    removedCharacters += charsRemoved;
+}
+
+qint64 MemoryUsage::textSize() const {
+    return 2 * qint64(document->characterCount()) + qint64(document->blockCount()) * BlockBytes;
+}
+
+MemoryUsage::Report MemoryUsage::estimate() const {
+    Report report;
+    report.bytes[Text] = textSize();
+
+    const int undoSteps = document->availableUndoSteps() + document->availableRedoSteps();
+    if (undoSteps > 0)
+        report.bytes[UndoStack] = 2 * removedCharacters + qint64(undoSteps) * UndoStepBytes;
+
+    // QTextLayout строки создает подсветка при первом проходе по документу, поэтому
+    // обращение к разметке здесь не создает новых объектов.
+    for (QTextBlock block = document->firstBlock(); block.isValid(); block = block.next()) {
+        report.bytes[Layouts] += LayoutBytes + layoutSize(block);
+        report.bytes[Formats] += formatSize(block.layout()->formats().size());
+
+        if (const BlockData *data = static_cast<const BlockData*>(block.userData())) {
+            report.bytes[Indexes] += sizeof(BlockData) + data->tokenRuns.capacity()
+                                     + data->symbols.capacity() * sizeof(BlockData::Symbol)
+                                     + data->identifiers.capacity() * sizeof(int);
+        }
+    }
+
+    // Индексы, которые еще не построены, не создаются.
+    if (const SymbolIndex *index = document->findChild<SymbolIndex*>(QString(), Qt::FindDirectChildrenOnly))
+        report.bytes[Indexes] += index->memoryUsage();
+    if (const IdentifierIndex *index = document->findChild<IdentifierIndex*>(QString(), Qt::FindDirectChildrenOnly))
+        report.bytes[Indexes] += index->memoryUsage();
+    if (const BracketIndex *index = document->findChild<BracketIndex*>(QString(), Qt::FindDirectChildrenOnly))
+        report.bytes[Indexes] += index->memoryUsage();
+
+    return report;
+}
+
+QString MemoryUsage::componentName(Component component) {
+    switch (component) {
+    case Text:
+        return tr("Text");
+    case Layouts:
+        return tr("Block layouts");
+    case Formats:
+        return tr("Highlighting formats");
+    case UndoStack:
+        return tr("Undo stack");
+    case Indexes:
+        return tr("Indexes");
+    case Caches:
+        return tr("Caches");
+    default:
+        return QString();
+    }
+}
+
+qint64 MemoryUsage::layoutSize(const QTextBlock &block) {
+    const int lines = block.layout()->lineCount();
+    if (lines == 0)
+        return 0;
+    return qint64(lines) * LineBytes + qint64(block.length()) * GlyphBytes;
+}
+
+qint64 MemoryUsage::formatSize(int formatCount) {
+    // Для каждого диапазона движок разметки хранит еще и разрешенный формат.
+    return formatCount * qint64(sizeof(QTextLayout::FormatRange) + sizeof(QTextCharFormat));
+}
+
+qint64 MemoryUsage::residentSize() {
+#ifdef Q_OS_LINUX
+    // Второе поле statm - резидентные страницы.
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QFile::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
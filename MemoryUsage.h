@@ -0,0 +1,76 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QString>
+
+// Оценка памяти документа по составляющим: текст, разметка строк, форматы подсветки,
+// история отмены и индексы. Размеры внутренних структур Qt недоступны, поэтому они
+// оцениваются по числу строк, символов и диапазонов форматов с постоянными на элемент.
+// Полная оценка перебирает все строки и выполняется только по запросу; textSize - O(1).
+class MemoryUsage : public QObject {
+    Q_OBJECT
+
+public:
+    enum Component {
+        Text,
+        Layouts,
+        Formats,
+        UndoStack,
+        Indexes,
+        Caches,
+        ComponentCount
+    };
+
+    struct Report {
+        qint64 bytes[ComponentCount] = {};
+
+        qint64 total() const;
+
+        void add(const Report &other);
+    };
+
+    // Учет документа; создается при первом обращении и принадлежит документу.
+    static MemoryUsage* forDocument(QTextDocument *document);
+
+    // Оценка по всем строкам документа; кэши редакторов (Caches) добавляет вызывающий.
+    Report estimate() const;
+
+    // Оценка хранения текста без перебора строк.
+    qint64 textSize() const;
+
+    static QString componentName(Component component);
+
+    // Оценка размеченных строк блока без самого объекта QTextLayout, байт; 0 - блок не размечен.
+    static qint64 layoutSize(const QTextBlock &block);
+
+    // Оценка formatCount диапазонов форматов подсветки строки, байт.
+    static qint64 formatSize(int formatCount);
+
+    // Резидентная память процесса по данным системы, -1 - недоступно.
+    static qint64 residentSize();
+
+    // Оценки внутренних структур Qt, байт.
+    static const int BlockBytes = 96;       // узлы блока и фрагмента текста в дереве документа
+    static const int LayoutBytes = 320;     // QTextLayout с QTextEngine
+    static const int LineBytes = 64;        // строка разметки QScriptLine
+    static const int GlyphBytes = 24;       // глиф, его смещение, ширина и атрибуты символа
+    static const int UndoStepBytes = 64;    // команда истории отмены
+
+private slots:
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    MemoryUsage(QTextDocument *document);
+
+private:
+    QTextDocument *document;
+    int revision;
+
+    // Удаленный текст остается в буфере документа, пока история отмены не очищена.
+    qint64 removedCharacters;
+};
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,208 @@
+#include "Minimap.h"
+
+#include <QPainter>
+#include <QTextBlock>
+
+Minimap::Minimap(QWidget *parent) : QWidget(parent) {
+    firstVisibleLine = 0;
+    lastVisibleLine = 0;
+    background = qRgb(255, 255, 255);
+    generation = 0;
+
+    // Плитки рисуются по одной: новая плитка нужна только при прокрутке или изменении текста.
+    pool.setMaxThreadCount(1);
+    setCursor(Qt::PointingHandCursor);
+}
+
+Minimap::~Minimap() {
+    // Задачи ссылаются на миникарту, поэтому дожидаемся их завершения.
+    pool.clear();
+    pool.waitForDone();
+}
+
+void Minimap::setDocument(QTextDocument *newDocument) {
+    if (document)
+        disconnect(document, nullptr, this, nullptr);
+    document = newDocument;
+
+    // Правка текста и подсветка меняют номера изменений строк; какие плитки устарели,
+    // выясняется при отрисовке.
+    if (document)
+        connect(document, &QTextDocument::contentsChange, this, [this]() { update(); });
+    tiles.clear();
+    pending.clear();
+    ++generation;
+    update();
+}
+
+void Minimap::setVisibleRange(int firstLine, int lastLine) {
+    if (firstLine == firstVisibleLine && lastLine == lastVisibleLine)
+        return;
+    firstVisibleLine = firstLine;
+    lastVisibleLine = lastLine;
+    update();
+}
+
+void Minimap::setColors(const QVector<QRgb> &newColors, QRgb newBackground) {
+    if (newColors == colors && newBackground == background)
+        return;
+
+    colors = newColors;
+    background = newBackground;
+    tiles.clear();
+    pending.clear();
+    ++generation;
+    update();
+}
+
+QSize Minimap::sizeHint() const {
+    return QSize(BlockData::TokenColumns, 0);
+}
+
+qint64 Minimap::memoryUsage() const {
+    qint64 bytes = 0;
+    for (const Tile &tile : tiles)
+        bytes += tile.image.sizeInBytes();
+    return bytes;
+}
+
+void Minimap::paintEvent(QPaintEvent *event) {
+    TraceScope trace("Minimap::paintEvent");
+    QPainter painter(this);
+    painter.fillRect(event->rect(), QColor(background));
+    if (!document)
+        return;
+
+    const int lineCount = document->blockCount();
+    const int top = topLine();
+    const int firstTile = top / TileLines;
+    const int lastTile = qMin((top + height() - 1) / TileLines, (lineCount - 1) / TileLines);
+
+    // При быстрой прокрутке плитки, ушедшие с экрана, не рисуются.
+    for (QHash<int, quint64>::const_iterator it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        if (it.key() < firstTile || it.key() > lastTile) {
+            pool.clear();
+            pending.clear();
+            break;
+        }
+    }
+
+    // Устаревшая плитка показывается, пока в фоне рисуется новая.
+    for (int tile = firstTile; tile <= lastTile; ++tile) {
+        const quint64 key = tileKey(tile);
+        QHash<int, Tile>::const_iterator it = tiles.constFind(tile);
+        if (it != tiles.constEnd())
+            painter.drawImage(QPoint(0, tile * TileLines - top), it.value().image);
+        if (it == tiles.constEnd() || it.value().key != key)
+            requestTile(tile, key);
+    }
+
+    // Область, видимая в редакторе.
+    painter.fillRect(QRect(0, firstVisibleLine - top, width(), lastVisibleLine - firstVisibleLine + 1),
+                     QColor(0, 0, 0, 40));
+
+    // Кэш ограничен плитками вокруг видимых.
+    if (tiles.size() > MaxTiles) {
+        for (QHash<int, Tile>::iterator it = tiles.begin(); it != tiles.end(); ) {
+            if (it.key() < firstTile - MaxTiles / 2 || it.key() > lastTile + MaxTiles / 2)
+                it = tiles.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void Minimap::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton && document)
+        emit lineActivated(qBound(0, topLine() + event->y(), document->blockCount() - 1));
+}
+
+void Minimap::mouseMoveEvent(QMouseEvent *event) {
+    if ((event->buttons() & Qt::LeftButton) && document)
+        emit lineActivated(qBound(0, topLine() + event->y(), document->blockCount() - 1));
+}
+
+int Minimap::topLine() const {
+    if (!document)
+        return 0;
+
+    // Если документ не помещается, миникарта прокручивается пропорционально редактору.
+    const int lineCount = document->blockCount();
+    if (lineCount <= height())
+        return 0;
+
+    const int visible = lastVisibleLine - firstVisibleLine + 1;
+    const int scrollable = qMax(1, lineCount - visible);
+    return int(qint64(qMin(firstVisibleLine, scrollable)) * (lineCount - height()) / scrollable);
+}
+
+quint64 Minimap::tileKey(int tile) const {
+    quint64 key = 1469598103934665603ULL;
+    QTextBlock block = document->findBlockByNumber(tile * TileLines);
+    for (int i = 0; i < TileLines && block.isValid(); ++i, block = block.next()) {
+        const BlockData *data = static_cast<const BlockData*>(block.userData());
+        key = (key ^ quint64(data ? data->tokenRevision : 0)) * 1099511628211ULL;
+    }
+    return key;
+}
+
+void Minimap::requestTile(int tile, quint64 key) {
+    if (pending.value(tile) == key)
+        return;
+    pending.insert(tile, key);
+
+    // Снимок строк: массивы неизменяемы и разделяются с BlockData без копирования.
+    QVector<QByteArray> rows;
+    rows.reserve(TileLines);
+    QTextBlock block = document->findBlockByNumber(tile * TileLines);
+    for (int i = 0; i < TileLines && block.isValid(); ++i, block = block.next()) {
+        const BlockData *data = static_cast<const BlockData*>(block.userData());
+        rows.append(data ? data->tokenRuns : QByteArray());
+    }
+
+    pool.start(new MinimapTileTask(this, generation, tile, key, rows, colors, background));
+}
+
+void Minimap::tileRendered(int tileGeneration, int tile, quint64 key, const QImage &image) {
+    if (tileGeneration != generation)
+        return;
+    if (pending.value(tile) == key)
+        pending.remove(tile);
+
+    tiles.insert(tile, { key, image });
+    const int y = tile * TileLines - topLine();
+    update(QRect(0, y, width(), TileLines));
+}
+
+MinimapTileTask::MinimapTileTask(Minimap *minimap, int generation, int tile, quint64 key,
+                                 const QVector<QByteArray> &rows, const QVector<QRgb> &colors, QRgb background)
+    : minimap(minimap), generation(generation), tile(tile), key(key),
+      rows(rows), colors(colors), background(background)
+{}
+
+void MinimapTileTask::run() {
+    TraceScope trace("MinimapTileTask::run");
+    QImage image(BlockData::TokenColumns, Minimap::TileLines, QImage::Format_RGB32);
+    image.fill(background);
+
+    for (int row = 0; row < rows.size(); ++row) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(row));
+        const QByteArray &runs = rows.at(row);
+        for (int i = 0; i + 2 < runs.size(); i += 3) {
+            const int start = quint8(runs.at(i));
+            const int length = quint8(runs.at(i + 1));
+            const int tokenClass = quint8(runs.at(i + 2));
+            const QRgb color = colors.value(tokenClass, colors.value(BlockData::PlainToken));
+            for (int x = start; x < start + length && x < BlockData::TokenColumns; ++x)
+                line[x] = color;
+        }
+    }
+
+    Minimap *receiver = minimap;
+    const int tileGeneration = generation;
+    const int tileNumber = tile;
+    const quint64 tileKey = key;
+    QMetaObject::invokeMethod(minimap, [receiver, tileGeneration, tileNumber, tileKey, image]() {
+        receiver->tileRendered(tileGeneration, tileNumber, tileKey, image);
+    }, Qt::QueuedConnection);
+}
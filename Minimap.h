@@ -0,0 +1,110 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "BlockData.h"
+#include "Trace.h"
+
+#include <QWidget>
+#include <QImage>
+#include <QHash>
+#include <QVector>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTextDocument>
+#include <QPaintEvent>
+#include <QMouseEvent>
+
+// Миникарта документа: одна строка пикселей на строку текста, цвет - по классу лексемы.
+// Изображение состоит из плиток по TileLines строк. Плитки рисуются в фоновом потоке
+// по снимку классов лексем из BlockData; плитка перерисовывается, только если изменились
+// ее строки (ключ плитки - номера изменений tokenRevision ее строк). На экране одновременно
+// несколько плиток, поэтому стоимость отрисовки не зависит от размера документа.
+class Minimap : public QWidget {
+    Q_OBJECT
+
+public:
+    Minimap(QWidget *parent = nullptr);
+
+    ~Minimap();
+
+    void setDocument(QTextDocument *document);
+
+    // Строки, видимые в редакторе (номера блоков).
+    void setVisibleRange(int firstLine, int lastLine);
+
+    // Цвета классов лексем BlockData::TokenClass; при смене цветов плитки рисуются заново.
+    void setColors(const QVector<QRgb> &colors, QRgb background);
+
+    QSize sizeHint() const override;
+
+    // Размер плиток в кэше, байт.
+    qint64 memoryUsage() const;
+
+    static const int TileLines = 256;
+
+    // Плитки дальше MaxTiles от видимых удаляются из кэша.
+    static const int MaxTiles = 64;
+
+signals:
+    // Щелчок или перетаскивание по миникарте.
+    void lineActivated(int line);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+    void mousePressEvent(QMouseEvent *event) override;
+
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    struct Tile {
+        quint64 key;
+        QImage image;
+    };
+
+    // Строка документа, показанная в верхней строке миникарты.
+    int topLine() const;
+
+    quint64 tileKey(int tile) const;
+
+    void requestTile(int tile, quint64 key);
+
+    void tileRendered(int generation, int tile, quint64 key, const QImage &image);
+
+private:
+    friend class MinimapTileTask;
+
+    QPointer<QTextDocument> document;
+    int firstVisibleLine;
+    int lastVisibleLine;
+
+    QVector<QRgb> colors;
+    QRgb background;
+
+    QHash<int, Tile> tiles;
+    QHash<int, quint64> pending;
+    int generation;
+
+    QThreadPool pool;
+};
+
+// Отрисовка одной плитки по снимку классов лексем ее строк.
+class MinimapTileTask : public QRunnable {
+public:
+    MinimapTileTask(Minimap *minimap, int generation, int tile, quint64 key,
+                    const QVector<QByteArray> &rows, const QVector<QRgb> &colors, QRgb background);
+
+    void run() override;
+
+private:
+    Minimap *minimap;
+    int generation;
+    int tile;
+    quint64 key;
+    QVector<QByteArray> rows;
+    QVector<QRgb> colors;
+    QRgb background;
+};
+
+#endif // MINIMAP_H
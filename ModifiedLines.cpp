@@ -0,0 +1,119 @@
+#include "ModifiedLines.h"
+#include "ScrollBarMarkers.h"
+
+#include <QElapsedTimer>
+
+ModifiedLines::ModifiedLines(QTextDocument *document)
+    : QObject(document), document(document)
+{
+    revision = document->revision();
+    blockCount = document->blockCount();
+    epoch = 1;
+    hasModified = false;
+    bins.fill(0, ScrollBarMarkers::Bins);
+    recountLine = 0;
+
+    recountTimer.setInterval(0);
+    connect(&recountTimer, &QTimer::timeout, this, &ModifiedLines::recountStep);
+    connect(document, &QTextDocument::contentsChange, this, &ModifiedLines::contentsChange);
+    connect(document, &QTextDocument::modificationChanged, this, &ModifiedLines::modificationChanged);
+}
+
+ModifiedLines* ModifiedLines::forDocument(QTextDocument *document) {
+    ModifiedLines *lines = document->findChild<ModifiedLines*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!lines)
+        lines = new ModifiedLines(document);
+    return lines;
+}
+
+bool ModifiedLines::isModified(const QTextBlock &block) const {
+    const BlockData *data = static_cast<const BlockData*>(block.userData());
+    return data && data->modifiedEpoch == epoch;
+}
+
+const QVector<quint32>& ModifiedLines::getBins() const {
+    return bins;
+}
+
+void ModifiedLines::contentsChange(int position, int charsRemoved, int charsAdded) {
+    // Изменение только форматов (подсветка) не меняет ревизию документа.
+    if (charsRemoved == charsAdded && document->revision() == revision)
+        return;
+    revision = document->revision();
+    const int previousCount = blockCount;
+    blockCount = document->blockCount();
+
+    // setPlainText загружает текст с выключенной отменой: загрузка не считается изменением.
+    if (!document->isUndoRedoEnabled()) {
+        if (hasModified && blockCount != previousCount)
+            startRecount();
+        return;
+    }
+
+    QTextBlock block = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid())
+        last = document->lastBlock();
+
+    // Номера строк остальных отметок не изменились: к корзинам добавляются только новые отметки.
+    const bool isIncremental = blockCount == previousCount && !recountTimer.isActive();
+    for (int line = block.blockNumber(); block.isValid(); block = block.next(), ++line) {
+        BlockData *data = BlockData::get(block);
+        if (data->modifiedEpoch != epoch) {
+            data->modifiedEpoch = epoch;
+            if (isIncremental)
+                ++bins[bin(line)];
+        }
+        if (block == last)
+            break;
+    }
+    hasModified = true;
+
+    if (isIncremental)
+        emit binsChanged();
+    else
+        startRecount();
+}
+
+void ModifiedLines::modificationChanged(bool changed) {
+    if (changed)
+        return;
+
+    ++epoch;
+    hasModified = false;
+    recountTimer.stop();
+    recountBlock = QTextBlock();
+    bins.fill(0);
+    emit binsChanged();
+}
+
+void ModifiedLines::startRecount() {
+    recountBlock = document->firstBlock();
+    recountLine = 0;
+    recountBins.fill(0, ScrollBarMarkers::Bins);
+    recountTimer.start();
+}
+
+void ModifiedLines::recountStep() {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Правка во время обхода начинает его заново, поэтому номера строк не сбиваются.
+    int count = 0;
+    for (; recountBlock.isValid(); recountBlock = recountBlock.next(), ++recountLine) {
+        if ((++count & 0xff) == 0 && timer.elapsed() >= RecountSlice)
+            return;
+        const BlockData *data = static_cast<const BlockData*>(recountBlock.userData());
+        if (data && data->modifiedEpoch == epoch)
+            ++recountBins[bin(recountLine)];
+    }
+
+    recountTimer.stop();
+    bins = recountBins;
+    recountBins.clear();
+    emit binsChanged();
+}
+
+int ModifiedLines::bin(int line) const {
+    return qMin(ScrollBarMarkers::Bins - 1, int(qint64(line) * ScrollBarMarkers::Bins / qMax(1, blockCount)));
+}
@@ -0,0 +1,65 @@
+#ifndef MODIFIEDLINES_H
+#define MODIFIEDLINES_H
+
+#include "BlockData.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTimer>
+#include <QVector>
+
+// Измененные строки документа для отметок на полосе прокрутки.
+// Отметка хранится в самой строке (BlockData::modifiedEpoch), поэтому вставка и удаление строк
+// ее не сдвигают. Корзины отметок (ScrollBarMarkers::Bins) пересчитываются по текущим номерам строк:
+// если число строк не изменилось, добавляются только новые отметки, иначе документ обходится
+// заново в фоне порциями. Отметки общие для всех представлений документа.
+class ModifiedLines : public QObject {
+    Q_OBJECT
+
+public:
+    // Отметки документа; создаются при первом обращении и принадлежат документу.
+    static ModifiedLines* forDocument(QTextDocument *document);
+
+    bool isModified(const QTextBlock &block) const;
+
+    // Число измененных строк в каждой корзине полосы прокрутки.
+    const QVector<quint32>& getBins() const;
+
+    static const int RecountSlice = 8;
+
+signals:
+    void binsChanged();
+
+private slots:
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+    // После открытия, сохранения или отмены всех правок измененных строк нет.
+    void modificationChanged(bool changed);
+
+    void recountStep();
+
+private:
+    ModifiedLines(QTextDocument *document);
+
+    void startRecount();
+
+    int bin(int line) const;
+
+private:
+    QTextDocument *document;
+    int revision;
+    int blockCount;
+
+    // Строка изменена, если ее modifiedEpoch совпадает с текущим; сброс всех отметок - новый номер.
+    int epoch;
+    bool hasModified;
+    QVector<quint32> bins;
+
+    QTimer recountTimer;
+    QTextBlock recountBlock;
+    int recountLine;
+    QVector<quint32> recountBins;
+};
+
+#endif // MODIFIEDLINES_H
@@ -0,0 +1,270 @@
+#include "MonospacePainter.h"
+#include "BlockData.h"
+
+#include <QFontInfo>
+#include <QGlyphRun>
+#include <QVarLengthArray>
+
+MonospacePainter::MonospacePainter() {
+    isFixedPitch = false;
+    enabled = true;
+    advance = 0;
+    fastBlocks = 0;
+    slowBlocks = 0;
+    for (int i = 0; i < 4; ++i)
+        variantsReady[i] = false;
+}
+
+void MonospacePainter::setFont(const QFont &newFont) {
+    if (newFont == font && variantsReady[0])
+        return;
+
+    font = newFont;
+    isFixedPitch = QFontInfo(font).fixedPitch();
+    for (int i = 0; i < 4; ++i)
+        variantsReady[i] = false;
+
+    // Ширина символа основного начертания - эталон для остальных начертаний.
+    FontVariant &regular = variant(0);
+    advance = 0;
+    if (regular.isUsable) {
+        QVector<quint32> glyph(1, regular.glyphs['M']);
+        advance = regular.rawFont.advancesForGlyphIndexes(glyph).value(0).x();
+    }
+}
+
+bool MonospacePainter::isEnabled() const {
+    return enabled && isFixedPitch && variantsReady[0] && variants[0].isUsable;
+}
+
+void MonospacePainter::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool MonospacePainter::drawBlock(QPainter *painter, const QTextBlock &block, const QPointF &offset,
+                                 const QVector<QTextLayout::FormatRange> &selections,
+                                 const QRect &clip, const QColor &textColor) {
+    if (!isEnabled()) {
+        ++slowBlocks;
+        return false;
+    }
+
+    QTextLayout *layout = block.layout();
+    if (layout->lineCount() != 1 || !layout->preeditAreaText().isEmpty()) {
+        ++slowBlocks;
+        return false;
+    }
+
+    // Поддерживается только выделение строки на всю ширину без смены цвета текста.
+    for (const QTextLayout::FormatRange &range : selections) {
+        if (!range.format.hasProperty(QTextFormat::FullWidthSelection)
+            || range.format.hasProperty(QTextFormat::ForegroundBrush)) {
+            ++slowBlocks;
+            return false;
+        }
+    }
+
+    // Проверка текста кэшируется до следующего изменения блока.
+    const QString text = layout->text();
+    BlockData *data = BlockData::get(block);
+    if (data->textRevision != block.revision()) {
+        data->isAsciiText = isFastText(text);
+        data->textRevision = block.revision();
+    }
+    if (!data->isAsciiText) {
+        ++slowBlocks;
+        return false;
+    }
+
+    const QVector<QTextLayout::FormatRange> formats = layout->formats();
+    for (const QTextLayout::FormatRange &range : formats) {
+        if (!isSimpleFormat(range.format)) {
+            ++slowBlocks;
+            return false;
+        }
+    }
+
+    const int length = text.length();
+    QTextLine line = layout->lineAt(0);
+    const QPointF position = offset + layout->position();
+    const qreal lineTop = position.y() + line.y();
+    const qreal lineHeight = line.height();
+    const qreal baseline = lineTop + line.ascent();
+    const qreal x0 = position.x() + line.cursorToX(0);
+
+    // Шаг берется из разметки строки, поэтому позиции совпадают с позициями курсора.
+    qreal step = advance;
+    if (length > 0) {
+        step = (line.cursorToX(length) - line.cursorToX(0)) / length;
+        if (qAbs(step - advance) > 0.01) {
+            ++slowBlocks;
+            return false;
+        }
+    }
+
+    for (const QTextLayout::FormatRange &range : selections) {
+        QBrush background = range.format.background();
+        if (background.style() != Qt::NoBrush) {
+            const qreal left = position.x() + line.x();
+            painter->fillRect(QRectF(left, lineTop, qMax(qreal(0), clip.right() + 1 - left), lineHeight),
+                              background);
+        }
+    }
+
+    // Рисуются только символы, попадающие в область отрисовки.
+    int first = 0;
+    int last = length;
+    if (step > 0) {
+        first = qBound(0, int((clip.left() - x0) / step), length);
+        last = qBound(first, int((clip.right() + 1 - x0) / step) + 1, length);
+    }
+
+    QVarLengthArray<int, 512> formatOf(last - first);
+    for (int i = 0; i < formatOf.size(); ++i)
+        formatOf[i] = -1;
+    for (int f = 0; f < formats.size(); ++f) {
+        const QTextLayout::FormatRange &range = formats.at(f);
+        const int from = qMax(first, range.start);
+        const int to = qMin(last, range.start + range.length);
+        for (int i = from; i < to; ++i)
+            formatOf[i - first] = f;
+
+        QBrush background = range.format.background();
+        if (from < to && background.style() != Qt::NoBrush)
+            painter->fillRect(QRectF(x0 + from * step, lineTop, (to - from) * step, lineHeight), background);
+    }
+
+    QVector<quint32> glyphs;
+    QVector<QPointF> positions;
+    int runStart = first;
+    while (runStart < last) {
+        const int f = formatOf[runStart - first];
+        int runEnd = runStart + 1;
+        while (runEnd < last && formatOf[runEnd - first] == f)
+            ++runEnd;
+
+        QColor color = textColor;
+        int variantIndex = 0;
+        bool underline = false;
+        if (f >= 0) {
+            const QTextCharFormat &format = formats.at(f).format;
+            if (format.hasProperty(QTextFormat::ForegroundBrush))
+                color = format.foreground().color();
+            if (format.hasProperty(QTextFormat::FontWeight) && format.fontWeight() > QFont::Normal)
+                variantIndex |= 1;
+            if (format.fontItalic())
+                variantIndex |= 2;
+            underline = format.fontUnderline();
+        }
+
+        FontVariant &fontVariant = variant(variantIndex);
+        if (!fontVariant.isUsable) {
+            // Начертание с другой шириной символов: блок целиком рисуется обычным способом.
+            ++slowBlocks;
+            return false;
+        }
+
+        glyphs.clear();
+        positions.clear();
+        for (int i = runStart; i < runEnd; ++i) {
+            const ushort c = text.at(i).unicode();
+            if (c == ' ')
+                continue;
+            glyphs.append(fontVariant.glyphs[c]);
+            positions.append(QPointF((i - runStart) * step, 0));
+        }
+
+        const qreal runX = x0 + runStart * step;
+        if (!glyphs.isEmpty()) {
+            QGlyphRun glyphRun;
+            glyphRun.setRawFont(fontVariant.rawFont);
+            glyphRun.setGlyphIndexes(glyphs);
+            glyphRun.setPositions(positions);
+            painter->setPen(color);
+            painter->drawGlyphRun(QPointF(runX, baseline), glyphRun);
+        }
+
+        if (underline) {
+            const qreal y = baseline + fontVariant.rawFont.underlinePosition();
+            painter->fillRect(QRectF(runX, y, (runEnd - runStart) * step,
+                                     qMax(qreal(1), fontVariant.rawFont.lineThickness())), color);
+        }
+
+        runStart = runEnd;
+    }
+
+    painter->setPen(textColor);
+    ++fastBlocks;
+    return true;
+}
+
+qint64 MonospacePainter::getFastBlockCount() const {
+    return fastBlocks;
+}
+
+qint64 MonospacePainter::getSlowBlockCount() const {
+    return slowBlocks;
+}
+
+MonospacePainter::FontVariant& MonospacePainter::variant(int index) {
+    FontVariant &fontVariant = variants[index];
+    if (variantsReady[index])
+        return fontVariant;
+    variantsReady[index] = true;
+
+    QFont variantFont(font);
+    if (index & 1)
+        variantFont.setWeight(QFont::Bold);
+    if (index & 2)
+        variantFont.setItalic(true);
+
+    // Индексы глифов для всех символов ASCII; управляющие символы заменяются пробелом.
+    QString ascii;
+    for (int c = 0; c < 128; ++c)
+        ascii.append(QLatin1Char(char(c < 32 || c == 127 ? ' ' : c)));
+
+    fontVariant.rawFont = QRawFont::fromFont(variantFont);
+    const QVector<quint32> indexes = fontVariant.rawFont.glyphIndexesForString(ascii);
+    fontVariant.isUsable = fontVariant.rawFont.isValid() && indexes.size() == 128;
+    if (!fontVariant.isUsable)
+        return fontVariant;
+
+    for (int c = 0; c < 128; ++c)
+        fontVariant.glyphs[c] = indexes.at(c);
+
+    if (index != 0) {
+        QVector<quint32> glyph(1, fontVariant.glyphs['M']);
+        qreal variantAdvance = fontVariant.rawFont.advancesForGlyphIndexes(glyph).value(0).x();
+        fontVariant.isUsable = qAbs(variantAdvance - advance) < 0.01;
+    }
+    return fontVariant;
+}
+
+bool MonospacePainter::isFastText(const QString &text) {
+    const QChar *data = text.constData();
+    for (int i = 0, size = text.size(); i < size; ++i) {
+        const ushort c = data[i].unicode();
+        if (c < 0x20 || c > 0x7e)
+            return false;
+    }
+    return true;
+}
+
+bool MonospacePainter::isSimpleFormat(const QTextCharFormat &format) {
+    // Подсветка меняет только цвет, фон, насыщенность, курсив и подчеркивание.
+    const QMap<int, QVariant> properties = format.properties();
+    for (QMap<int, QVariant>::const_iterator it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        switch (it.key()) {
+        case QTextFormat::ForegroundBrush:
+        case QTextFormat::BackgroundBrush:
+        case QTextFormat::FontWeight:
+        case QTextFormat::FontItalic:
+        case QTextFormat::FontUnderline:
+        case QTextFormat::TextUnderlineStyle:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
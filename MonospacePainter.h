@@ -0,0 +1,68 @@
+#ifndef MONOSPACEPAINTER_H
+#define MONOSPACEPAINTER_H
+
+#include <QPainter>
+#include <QRawFont>
+#include <QFont>
+#include <QColor>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QVector>
+
+// Быстрая отрисовка однострочных блоков из печатных символов ASCII моноширинным шрифтом.
+// Разметку строки по-прежнему строит документ (по ней работают курсор и высота блока);
+// обходится только QTextLayout::draw, который при каждой отрисовке заново делит строку
+// на участки по форматам и формирует глифы. Здесь позиции символов вычисляются арифметически,
+// глифы берутся из таблицы индексов, построенной один раз на шрифт, и рисуются через drawGlyphRun.
+// Все остальные блоки (табуляция, не-ASCII, перенос, частичное выделение) рисуются через QTextLayout.
+// Доля блоков, нарисованных быстрым способом, показывается на наложении замеров редактора.
+class MonospacePainter {
+public:
+    MonospacePainter();
+
+    // Таблицы глифов перестраиваются только при смене шрифта.
+    void setFont(const QFont &font);
+
+    bool isEnabled() const;
+
+    void setEnabled(bool enabled);
+
+    // Рисует блок и возвращает true, либо возвращает false, если блок нужно рисовать через QTextLayout.
+    bool drawBlock(QPainter *painter, const QTextBlock &block, const QPointF &offset,
+                   const QVector<QTextLayout::FormatRange> &selections,
+                   const QRect &clip, const QColor &textColor);
+
+    // Число блоков, нарисованных быстрым способом и через QTextLayout (в том числе при отключенной
+    // быстрой отрисовке), с создания.
+    qint64 getFastBlockCount() const;
+
+    qint64 getSlowBlockCount() const;
+
+private:
+    // Вариант начертания: 0 - обычный, 1 - полужирный, 2 - курсив, 3 - полужирный курсив.
+    struct FontVariant {
+        QRawFont rawFont;
+        quint32 glyphs[128];
+        bool isUsable;
+    };
+
+    FontVariant& variant(int index);
+
+    static bool isFastText(const QString &text);
+
+    static bool isSimpleFormat(const QTextCharFormat &format);
+
+private:
+    QFont font;
+    bool isFixedPitch;
+    bool enabled;
+
+    FontVariant variants[4];
+    bool variantsReady[4];
+    qreal advance;
+
+    qint64 fastBlocks;
+    qint64 slowBlocks;
+};
+
+#endif // MONOSPACEPAINTER_H
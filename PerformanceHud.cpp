@@ -0,0 +1,175 @@
+#include "PerformanceHud.h"
+#include "UpdateScheduler.h"
+
+#include <QFontDatabase>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QPainter>
+
+#include <algorithm>
+
+PerformanceHud::PerformanceHud(QWidget *parent) : QWidget(parent) {
+    frames.resize(MaxFrames);
+    frameCount = 0;
+    keyLatencies.resize(MaxFrames);
+    keyCount = 0;
+    shownFrameCount = 0;
+    for (int stage = 0; stage < StageCount; ++stage)
+        stageTimes[stage] = 0;
+    fastBlocks = 0;
+    slowBlocks = 0;
+    clock.start();
+
+    // Непрозрачное наложение перерисовывается само, не вызывая отрисовку текста под собой.
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    const QFontMetrics metrics(font());
+    resize(metrics.horizontalAdvance("Key to paint  p50 0000.00  p99 0000.00 ms") + 2 * metrics.averageCharWidth(),
+           8 * metrics.height());
+
+    refreshTimer.setInterval(500);
+    connect(&refreshTimer, &QTimer::timeout, this, [this]() {
+        if (shownFrameCount != frameCount)
+            update();
+    });
+    refreshTimer.start();
+}
+
+void PerformanceHud::keyPressed() {
+    pendingKeys.append(clock.nsecsElapsed());
+}
+
+void PerformanceHud::addStageTime(Stage stage, qint64 nsecs) {
+    stageTimes[stage] += qMax(qint64(0), nsecs);
+}
+
+void PerformanceHud::addPaintedBlocks(int fast, int slow) {
+    fastBlocks += fast;
+    slowBlocks += slow;
+}
+
+void PerformanceHud::framePainted(qint64 paintTime) {
+    const qint64 now = clock.nsecsElapsed();
+
+    Frame &frame = frames[frameCount % MaxFrames];
+    frame.time = now;
+    frame.paintTime = paintTime;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        frame.stageTimes[stage] = stageTimes[stage];
+        stageTimes[stage] = 0;
+    }
+    frame.fastBlocks = fastBlocks;
+    frame.slowBlocks = slowBlocks;
+    fastBlocks = 0;
+    slowBlocks = 0;
+    frame.keyCount = pendingKeys.size();
+    frame.maxKeyLatency = 0;
+    for (qint64 keyTime : pendingKeys) {
+        const qint64 latency = now - keyTime;
+        keyLatencies[keyCount % MaxFrames] = latency;
+        ++keyCount;
+        frame.maxKeyLatency = qMax(frame.maxKeyLatency, latency);
+    }
+    pendingKeys.clear();
+    ++frameCount;
+}
+
+bool PerformanceHud::exportCsv(const QString &fileName, QString *errorMessage) const {
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        if (errorMessage)
+            *errorMessage = file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "frame,time_ms,paint_ms,highlight_ms,layout_ms,gutter_ms,fast_blocks,slow_blocks,keys,max_key_latency_ms\n";
+    for (int i = qMax(0, frameCount - MaxFrames); i < frameCount; ++i) {
+        const Frame &frame = frames.at(i % MaxFrames);
+        out << i << ',' << QString::number(frame.time / 1e6, 'f', 3)
+            << ',' << QString::number(frame.paintTime / 1e6, 'f', 3)
+            << ',' << QString::number(frame.stageTimes[Highlight] / 1e6, 'f', 3)
+            << ',' << QString::number(frame.stageTimes[Layout] / 1e6, 'f', 3)
+            << ',' << QString::number(frame.stageTimes[Gutter] / 1e6, 'f', 3)
+            << ',' << frame.fastBlocks << ',' << frame.slowBlocks
+            << ',' << frame.keyCount
+            << ',' << QString::number(frame.maxKeyLatency / 1e6, 'f', 3) << '\n';
+    }
+    out.flush();
+
+    if (!file.commit()) {
+        if (errorMessage)
+            *errorMessage = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void PerformanceHud::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+    shownFrameCount = frameCount;
+
+    QVector<qint64> latencies;
+    for (int i = qMax(0, keyCount - ShownFrames); i < keyCount; ++i)
+        latencies.append(keyLatencies.at(i % MaxFrames));
+
+    QVector<qint64> paintTimes;
+    qint64 stageTotals[StageCount] = {};
+    qint64 paintTotal = 0;
+    qint64 fastTotal = 0;
+    qint64 blockTotal = 0;
+    const int first = qMax(0, frameCount - ShownFrames);
+    for (int i = first; i < frameCount; ++i) {
+        const Frame &frame = frames.at(i % MaxFrames);
+        paintTimes.append(frame.paintTime);
+        paintTotal += frame.paintTime;
+        for (int stage = 0; stage < StageCount; ++stage)
+            stageTotals[stage] += frame.stageTimes[stage];
+        fastTotal += frame.fastBlocks;
+        blockTotal += frame.fastBlocks + frame.slowBlocks;
+    }
+    const int shown = qMax(1, frameCount - first);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(32, 32, 32));
+    painter.setPen(QColor(230, 230, 230));
+
+    const QFontMetrics metrics(font());
+    const int x = metrics.averageCharWidth();
+    int y = metrics.ascent() + metrics.height() / 2;
+    auto line = [&painter, &metrics, x, &y](const QString &text) {
+        painter.drawText(x, y, text);
+        y += metrics.height();
+    };
+    line(QString("Key to paint  p50 %1  p99 %2 ms")
+         .arg(percentile(latencies, 0.5), 7, 'f', 2).arg(percentile(latencies, 0.99), 7, 'f', 2));
+    line(QString("Frame         p50 %1  p99 %2 ms")
+         .arg(percentile(paintTimes, 0.5), 7, 'f', 2).arg(percentile(paintTimes, 0.99), 7, 'f', 2));
+    line(QString("Highlight     %1 ms/frame").arg(stageTotals[Highlight] / 1e6 / shown, 7, 'f', 3));
+    line(QString("Layout        %1 ms/frame").arg(stageTotals[Layout] / 1e6 / shown, 7, 'f', 3));
+    // Доля области нумерации во времени отрисовки области текста и нумерации вместе.
+    const qint64 gutterTotal = stageTotals[Gutter];
+    line(QString("Gutter        %1 ms/frame %2 %").arg(gutterTotal / 1e6 / shown, 7, 'f', 3)
+         .arg(gutterTotal > 0 ? 100.0 * gutterTotal / (gutterTotal + paintTotal) : 0.0, 5, 'f', 1));
+    line(QString("Fast path     %1 %  of %2 lines").arg(blockTotal > 0 ? 100.0 * fastTotal / blockTotal : 0.0, 5, 'f', 1)
+         .arg(blockTotal));
+
+    // Обновления интерфейса, подавленные планировщиком, с начала работы.
+    qint64 requested = 0;
+    qint64 suppressed = 0;
+    for (int part = 0; part < UpdateScheduler::PartCount; ++part) {
+        requested += UpdateScheduler::instance()->getRequestedCount(UpdateScheduler::Part(part));
+        suppressed += UpdateScheduler::instance()->getSuppressedCount(UpdateScheduler::Part(part));
+    }
+    line(QString("Suppressed    %1 %  of %2 updates").arg(requested > 0 ? 100.0 * suppressed / requested : 0.0, 5, 'f', 1)
+         .arg(requested));
+}
+
+double PerformanceHud::percentile(QVector<qint64> values, double fraction) {
+    if (values.isEmpty())
+        return 0;
+    const int index = qMin(values.size() - 1, int(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values.at(index) / 1e6;
+}
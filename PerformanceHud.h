@@ -0,0 +1,83 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QPaintEvent>
+#include <QVector>
+#include <QTimer>
+#include <QString>
+
+// Наложение на область текста редактора: задержка от нажатия клавиши до отрисовки (p50/p99),
+// время отрисовки кадров, время подсветки, разметки и области нумерации на кадр
+// и доля строк, нарисованных быстрым способом для моноширинного текста, а также доля обновлений
+// интерфейса, подавленных UpdateScheduler.
+// Кадр - одна отрисовка области текста; время этапов, накопленное после предыдущего кадра,
+// относится к нему. Последние MaxFrames кадров выгружаются в CSV для сравнения замеров.
+// Наложение перерисовывается по таймеру, а не в каждом кадре, и не перекрашивает текст под собой.
+class PerformanceHud : public QWidget {
+    Q_OBJECT
+
+public:
+    enum Stage {
+        Highlight,
+        Layout,
+        Gutter,
+        StageCount
+    };
+
+    // Положение над областью текста задает редактор-владелец.
+    PerformanceHud(QWidget *parent);
+
+    // Нажатие клавиши; задержка отсчитывается до конца ближайшей отрисовки текста.
+    void keyPressed();
+
+    void addStageTime(Stage stage, qint64 nsecs);
+
+    // Строки, нарисованные в кадре быстрым способом (fast) и через QTextLayout (slow).
+    void addPaintedBlocks(int fast, int slow);
+
+    // Конец отрисовки области текста, paintTime - ее длительность, нс.
+    void framePainted(qint64 paintTime);
+
+    bool exportCsv(const QString &fileName, QString *errorMessage = nullptr) const;
+
+    static const int MaxFrames = 8192;
+
+    // Окно кадров для процентилей и средних на экране.
+    static const int ShownFrames = 256;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    static double percentile(QVector<qint64> values, double fraction);
+
+private:
+    struct Frame {
+        qint64 time;
+        qint64 paintTime;
+        qint64 stageTimes[StageCount];
+        int fastBlocks;
+        int slowBlocks;
+        int keyCount;
+        qint64 maxKeyLatency;
+    };
+
+    // Кольцевые буферы кадров и задержек отдельных нажатий.
+    QVector<Frame> frames;
+    int frameCount;
+    QVector<qint64> keyLatencies;
+    int keyCount;
+
+    QVector<qint64> pendingKeys;
+    qint64 stageTimes[StageCount];
+    int fastBlocks;
+    int slowBlocks;
+
+    QElapsedTimer clock;
+    QTimer refreshTimer;
+    int shownFrameCount;
+};
+
+#endif // PERFORMANCEHUD_H
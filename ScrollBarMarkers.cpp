@@ -0,0 +1,152 @@
+#include "ScrollBarMarkers.h"
+
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionSlider>
+#include <QEvent>
+
+ScrollBarMarkers::ScrollBarMarkers(QScrollBar *scrollBar) : QWidget(scrollBar), scrollBar(scrollBar) {
+    for (int kind = 0; kind < KindCount; ++kind) {
+        bins[kind].fill(0, Bins);
+        generations[kind] = 0;
+    }
+
+    // Порции одного снимка должны обрабатываться по порядку.
+    pool.setMaxThreadCount(1);
+
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    scrollBar->installEventFilter(this);
+    updatePosition();
+}
+
+ScrollBarMarkers::~ScrollBarMarkers() {
+    // Задачи ссылаются на отметки, поэтому дожидаемся их завершения.
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ScrollBarMarkers::clear(Kind kind) {
+    ++generations[kind];
+    scans[kind].reset();
+    bins[kind].fill(0);
+    update();
+}
+
+void ScrollBarMarkers::addOffsets(Kind kind, const QString &text, const QVector<quint32> &offsets) {
+    if (offsets.isEmpty())
+        return;
+    if (!scans[kind])
+        scans[kind].reset(new OffsetScan);
+
+    pool.start(new MarkerBinTask(this, generations[kind], kind, scans[kind], text, offsets));
+}
+
+void ScrollBarMarkers::setBins(Kind kind, const QVector<quint32> &newBins) {
+    if (newBins.size() != Bins || newBins == bins[kind])
+        return;
+    ++generations[kind];
+    scans[kind].reset();
+    bins[kind] = newBins;
+    update();
+}
+
+void ScrollBarMarkers::paintEvent(QPaintEvent *event) {
+    TraceScope trace("ScrollBarMarkers::paintEvent");
+    Q_UNUSED(event)
+    QPainter painter(this);
+
+    const QColor colors[KindCount] = { QColor(240, 160, 0), QColor(80, 160, 220) };
+    const int columns[KindCount] = { width() / 3, 0 };
+    const int columnWidths[KindCount] = { width() - width() / 3, qMax(2, width() / 4) };
+
+    // Строка пикселей отмечается, если непуста хотя бы одна из ее корзин.
+    const int rows = height();
+    for (int kind = 0; kind < KindCount; ++kind) {
+        const quint32 *kindBins = bins[kind].constData();
+        int bin = 0;
+        int markStart = -1;
+        for (int y = 0; y <= rows; ++y) {
+            bool marked = false;
+            if (y < rows) {
+                const int binEnd = qMax(bin + 1, int(qint64(y + 1) * Bins / rows));
+                for (; bin < binEnd && bin < Bins; ++bin)
+                    marked = marked || kindBins[bin] > 0;
+            }
+
+            // Соседние отмеченные строки рисуются одним прямоугольником.
+            if (marked && markStart < 0) {
+                markStart = y;
+            } else if (!marked && markStart >= 0) {
+                painter.fillRect(columns[kind], markStart, columnWidths[kind], qMax(2, y - markStart), colors[kind]);
+                markStart = -1;
+            }
+        }
+    }
+}
+
+bool ScrollBarMarkers::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == scrollBar && (event->type() == QEvent::Resize || event->type() == QEvent::StyleChange))
+        updatePosition();
+    return QWidget::eventFilter(watched, event);
+}
+
+void ScrollBarMarkers::updatePosition() {
+    QStyleOptionSlider option;
+    option.initFrom(scrollBar);
+    option.orientation = scrollBar->orientation();
+    option.minimum = scrollBar->minimum();
+    option.maximum = scrollBar->maximum();
+    option.sliderPosition = scrollBar->sliderPosition();
+    option.sliderValue = scrollBar->value();
+    option.singleStep = scrollBar->singleStep();
+    option.pageStep = scrollBar->pageStep();
+
+    setGeometry(scrollBar->style()->subControlRect(QStyle::CC_ScrollBar, &option,
+                                                   QStyle::SC_ScrollBarGroove, scrollBar));
+    raise();
+}
+
+void ScrollBarMarkers::binsReady(int generation, Kind kind, const QVector<quint32> &batchBins) {
+    if (generation != generations[kind])
+        return;
+
+    quint32 *kindBins = bins[kind].data();
+    for (int bin = 0; bin < Bins; ++bin)
+        kindBins[bin] += batchBins.at(bin);
+    update();
+}
+
+
+MarkerBinTask::MarkerBinTask(ScrollBarMarkers *markers, int generation, ScrollBarMarkers::Kind kind,
+                             const QSharedPointer<ScrollBarMarkers::OffsetScan> &scan,
+                             const QString &text, const QVector<quint32> &offsets)
+    : markers(markers), generation(generation), kind(kind), scan(scan), text(text), offsets(offsets)
+{}
+
+void MarkerBinTask::run() {
+    const QChar *chars = text.constData();
+    const int length = text.length();
+
+    // Число строк снимка считается один раз, первой порцией.
+    if (scan->lineCount < 0)
+        scan->lineCount = text.count(QLatin1Char('\n')) + 1;
+
+    // Смещения идут по возрастанию, поэтому перевод в строки - один проход по тексту
+    // от предыдущей порции до последнего смещения текущей.
+    QVector<quint32> batchBins(ScrollBarMarkers::Bins, 0);
+    for (quint32 offset : offsets) {
+        const int target = qMin(int(offset), length);
+        for (; scan->offset < target; ++scan->offset) {
+            if (chars[scan->offset] == QLatin1Char('\n'))
+                ++scan->line;
+        }
+        ++batchBins[int(qint64(scan->line) * ScrollBarMarkers::Bins / scan->lineCount)];
+    }
+
+    ScrollBarMarkers *receiver = markers;
+    const int taskGeneration = generation;
+    const ScrollBarMarkers::Kind taskKind = kind;
+    QMetaObject::invokeMethod(markers, [receiver, taskGeneration, taskKind, batchBins]() {
+        receiver->binsReady(taskGeneration, taskKind, batchBins);
+    }, Qt::QueuedConnection);
+}
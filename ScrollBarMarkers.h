@@ -0,0 +1,93 @@
+#ifndef SCROLLBARMARKERS_H
+#define SCROLLBARMARKERS_H
+
+#include "Trace.h"
+
+#include <QWidget>
+#include <QScrollBar>
+#include <QSharedPointer>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QPaintEvent>
+#include <QVector>
+#include <QString>
+
+// Отметки на вертикальной полосе прокрутки: совпадения поиска и измененные строки.
+// Отметки не хранятся по одной: положения собираются в Bins корзин по доле строки в документе,
+// поэтому отрисовка проходит только по корзинам и не зависит от числа отметок.
+// Смещения совпадений переводятся в номера строк и раскладываются по корзинам в фоновом потоке
+// порциями, по мере поступления результатов поиска.
+class ScrollBarMarkers : public QWidget {
+    Q_OBJECT
+
+public:
+    enum Kind {
+        SearchHit,
+        Modified,
+        KindCount
+    };
+
+    ScrollBarMarkers(QScrollBar *scrollBar);
+
+    ~ScrollBarMarkers();
+
+    void clear(Kind kind);
+
+    // Смещения в снимке текста text, по возрастанию; порции одного снимка передаются по порядку.
+    void addOffsets(Kind kind, const QString &text, const QVector<quint32> &offsets);
+
+    // Корзины, посчитанные владельцем отметок (например, ModifiedLines), заменяют текущие.
+    void setBins(Kind kind, const QVector<quint32> &newBins);
+
+    static const int Bins = 4096;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    // Положение на полосе совпадает с желобом полосы прокрутки.
+    void updatePosition();
+
+    void binsReady(int generation, Kind kind, const QVector<quint32> &batchBins);
+
+private:
+    friend class MarkerBinTask;
+
+    // Состояние перевода смещений в строки для одного снимка текста.
+    // Используется только фоновым потоком; порции обрабатываются по одной.
+    struct OffsetScan {
+        int offset = 0;
+        int line = 0;
+        int lineCount = -1;
+    };
+
+    QScrollBar *scrollBar;
+
+    QVector<quint32> bins[KindCount];
+    QSharedPointer<OffsetScan> scans[KindCount];
+    int generations[KindCount];
+
+    QThreadPool pool;
+};
+
+// Раскладка порции смещений по корзинам.
+class MarkerBinTask : public QRunnable {
+public:
+    MarkerBinTask(ScrollBarMarkers *markers, int generation, ScrollBarMarkers::Kind kind,
+                  const QSharedPointer<ScrollBarMarkers::OffsetScan> &scan,
+                  const QString &text, const QVector<quint32> &offsets);
+
+    void run() override;
+
+private:
+    ScrollBarMarkers *markers;
+    int generation;
+    ScrollBarMarkers::Kind kind;
+    QSharedPointer<ScrollBarMarkers::OffsetScan> scan;
+    QString text;
+    QVector<quint32> offsets;
+};
+
+#endif // SCROLLBARMARKERS_H
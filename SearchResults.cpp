@@ -0,0 +1,228 @@
+#include "SearchResults.h"
+
+#include <QStringMatcher>
+#include <QElapsedTimer>
+#include <QTextCursor>
+#include <QTextBlock>
+#include <QBoxLayout>
+
+SearchResultsModel::SearchResultsModel(QObject *parent) : QAbstractListModel(parent) {
+    generation = 0;
+    running = false;
+    stale = false;
+}
+
+SearchResultsModel::~SearchResultsModel() {
+    // Задача поиска ссылается на модель, поэтому дожидаемся ее завершения.
+    cancel();
+    pool.waitForDone();
+}
+
+void SearchResultsModel::search(QTextDocument *newDocument, const QString &newSearchString) {
+    cancel();
+    pool.waitForDone();
+    clear();
+
+    if (document)
+        disconnect(document, nullptr, this, nullptr);
+
+    document = newDocument;
+    searchString = newSearchString;
+    if (!document || searchString.isEmpty()) {
+        emit searchFinished(0);
+        return;
+    }
+
+    connect(document, &QTextDocument::contentsChanged, this, &SearchResultsModel::documentChanged);
+
+    canceled.storeRelease(0);
+    running = true;
+    ++generation;
+
+    // Снимок текста нужен на время поиска и освобождается вместе с задачей.
+    // Позиции в toPlainText() совпадают с позициями документа.
+    pool.start(new SearchTask(this, generation, document->toPlainText(), searchString));
+}
+
+void SearchResultsModel::cancel() {
+    // Порции отмененного поиска, уже поставленные в очередь, отбрасываются по номеру поиска.
+    canceled.storeRelease(1);
+    ++generation;
+    running = false;
+}
+
+void SearchResultsModel::clear() {
+    beginResetModel();
+    offsets.clear();
+    offsets.squeeze();
+    stale = false;
+    endResetModel();
+    emit countChanged(0);
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid())
+        return 0;
+    return offsets.size();
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= offsets.size() || !document)
+        return QVariant();
+
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole)
+        return QVariant();
+
+    const int offset = position(index.row());
+    if (offset >= document->characterCount())
+        return QVariant();
+
+    // Контекст берется только в пределах строки совпадения и ограничен по длине.
+    QTextBlock block = document->findBlock(offset);
+    const int blockStart = block.position();
+    const int blockEnd = blockStart + block.length() - 1;
+    const int contextStart = qMax(blockStart, offset - ContextLength / 4);
+    const int contextEnd = qMin(blockEnd, contextStart + ContextLength);
+
+    QTextCursor cursor(document);
+    cursor.setPosition(contextStart);
+    cursor.setPosition(contextEnd, QTextCursor::KeepAnchor);
+
+    QString context = cursor.selectedText().trimmed();
+    if (contextStart > blockStart)
+        context.prepend("...");
+    if (contextEnd < blockEnd)
+        context.append("...");
+
+    return QString::number(block.blockNumber() + 1) + ": " + context;
+}
+
+int SearchResultsModel::position(int row) const {
+    return int(offsets.at(row));
+}
+
+int SearchResultsModel::matchLength() const {
+    return searchString.length();
+}
+
+bool SearchResultsModel::isRunning() const {
+    return running;
+}
+
+bool SearchResultsModel::isStale() const {
+    return stale;
+}
+
+void SearchResultsModel::documentChanged() {
+    // Смещения относятся к версии документа, в которой выполнялся поиск.
+    if (!stale && !offsets.isEmpty()) {
+        stale = true;
+        emit countChanged(offsets.size());
+    }
+}
+
+void SearchResultsModel::appendOffsets(int taskGeneration, const QString &text, const QVector<quint32> &batch,
+                                       bool last) {
+    if (taskGeneration != generation)
+        return;
+
+    if (!batch.isEmpty()) {
+        beginInsertRows(QModelIndex(), offsets.size(), offsets.size() + batch.size() - 1);
+        offsets += batch;
+        endInsertRows();
+        emit countChanged(offsets.size());
+        emit offsetsAppended(text, batch);
+    }
+
+    if (last) {
+        running = false;
+        offsets.squeeze();
+        emit searchFinished(offsets.size());
+    }
+}
+
+
+SearchTask::SearchTask(SearchResultsModel *model, int generation, const QString &text, const QString &searchString)
+    : model(model), generation(generation), text(text), searchString(searchString)
+{}
+
+void SearchTask::run() {
+    QStringMatcher matcher(searchString, Qt::CaseSensitive);
+    QVector<quint32> batch;
+    batch.reserve(BatchSize);
+
+    SearchResultsModel *receiver = model;
+    const int taskGeneration = generation;
+    const QString snapshot = text;
+
+    // Порции отправляются по заполнении или по времени, чтобы список рос во время поиска.
+    QElapsedTimer timer;
+    timer.start();
+
+    int index = matcher.indexIn(text, 0);
+    while (index >= 0 && !model->canceled.loadAcquire()) {
+        batch.append(quint32(index));
+
+        if (batch.size() >= BatchSize || timer.elapsed() > 100) {
+            QVector<quint32> ready;
+            ready.swap(batch);
+            batch.reserve(BatchSize);
+            QMetaObject::invokeMethod(receiver, [receiver, taskGeneration, snapshot, ready]() {
+                receiver->appendOffsets(taskGeneration, snapshot, ready, false);
+            }, Qt::QueuedConnection);
+            timer.restart();
+        }
+
+        index = matcher.indexIn(text, index + searchString.length());
+    }
+
+    QMetaObject::invokeMethod(receiver, [receiver, taskGeneration, snapshot, batch]() {
+        receiver->appendOffsets(taskGeneration, snapshot, batch, true);
+    }, Qt::QueuedConnection);
+}
+
+
+SearchResultsPanel::SearchResultsPanel(QWidget *parent) : QDockWidget(tr("Search results"), parent) {
+    setObjectName("SearchResultsPanel");
+
+    model = new SearchResultsModel(this);
+
+    // Одинаковая высота строк позволяет представлению не опрашивать каждую строку модели.
+    view = new QListView;
+    view->setModel(model);
+    view->setUniformItemSizes(true);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setSelectionMode(QAbstractItemView::SingleSelection);
+
+    summary = new QLabel;
+
+    QWidget *widget = new QWidget;
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(summary);
+    layout->addWidget(view);
+    widget->setLayout(layout);
+    setWidget(widget);
+
+    connect(view, &QListView::activated, this, &SearchResultsPanel::rowActivated);
+    connect(model, &SearchResultsModel::countChanged, this, &SearchResultsPanel::updateSummary);
+    connect(model, &SearchResultsModel::searchFinished, this, &SearchResultsPanel::updateSummary);
+}
+
+SearchResultsModel* SearchResultsPanel::getModel() {
+    return model;
+}
+
+void SearchResultsPanel::rowActivated(const QModelIndex &index) {
+    if (index.isValid())
+        emit resultActivated(model->position(index.row()), model->matchLength());
+}
+
+void SearchResultsPanel::updateSummary() {
+    QString text = QString::number(model->rowCount()) + " matches";
+    if (model->isRunning())
+        text += " (searching...)";
+    if (model->isStale())
+        text += " (document changed)";
+    summary->setText(text);
+}
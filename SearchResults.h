@@ -0,0 +1,117 @@
+#ifndef SEARCHRESULTS_H
+#define SEARCHRESULTS_H
+
+#include <QAbstractListModel>
+#include <QDockWidget>
+#include <QListView>
+#include <QLabel>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QTextDocument>
+#include <QVector>
+#include <QString>
+
+// Модель результатов поиска.
+// Хранит только смещения совпадений в документе (4 байта на совпадение),
+// строка контекста извлекается из документа лишь для отображаемых строк списка.
+class SearchResultsModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    SearchResultsModel(QObject *parent = nullptr);
+
+    ~SearchResultsModel();
+
+    // Запуск поиска в фоновом потоке, результаты добавляются порциями.
+    void search(QTextDocument *document, const QString &searchString);
+
+    void cancel();
+
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    int position(int row) const;
+
+    int matchLength() const;
+
+    bool isRunning() const;
+
+    bool isStale() const;
+
+    // Размер ограничен, чтобы не копировать строки журнала целиком.
+    static const int ContextLength = 160;
+
+signals:
+    void countChanged(int count);
+
+    void searchFinished(int count);
+
+    // Очередная порция смещений и снимок текста, в котором они найдены.
+    void offsetsAppended(const QString &text, const QVector<quint32> &batch);
+
+private slots:
+    void documentChanged();
+
+private:
+    void appendOffsets(int generation, const QString &text, const QVector<quint32> &batch, bool last);
+
+private:
+    friend class SearchTask;
+
+    QPointer<QTextDocument> document;
+    QVector<quint32> offsets;
+    QString searchString;
+
+    QThreadPool pool;
+    QAtomicInt canceled;
+    int generation;
+    bool running;
+    bool stale;
+};
+
+// Поиск всех вхождений в снимке текста документа.
+class SearchTask : public QRunnable {
+public:
+    SearchTask(SearchResultsModel *model, int generation, const QString &text, const QString &searchString);
+
+    void run() override;
+
+    // Количество совпадений в одной порции, передаваемой в модель.
+    static const int BatchSize = 64 * 1024;
+
+private:
+    SearchResultsModel *model;
+    int generation;
+    QString text;
+    QString searchString;
+};
+
+// Панель результатов поиска. Выбор строки переводит курсор редактора к совпадению.
+class SearchResultsPanel : public QDockWidget {
+    Q_OBJECT
+
+public:
+    SearchResultsPanel(QWidget *parent = nullptr);
+
+    SearchResultsModel* getModel();
+
+signals:
+    void resultActivated(int position, int length);
+
+private slots:
+    void rowActivated(const QModelIndex &index);
+
+    void updateSummary();
+
+private:
+    SearchResultsModel *model;
+    QListView *view;
+    QLabel *summary;
+};
+
+#endif // SEARCHRESULTS_H
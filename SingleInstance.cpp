@@ -0,0 +1,79 @@
+#include "SingleInstance.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+
+SingleInstance::SingleInstance(QObject *parent) : QObject(parent) {
+    connect(&server, &QLocalServer::newConnection, this, &SingleInstance::newConnection);
+}
+
+bool SingleInstance::sendToRunning(const QStringList &files) {
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(ConnectTimeout))
+        return false;
+
+    QByteArray message;
+    QDataStream out(&message, QIODevice::WriteOnly);
+    out << files;
+    socket.write(message);
+    if (!socket.waitForBytesWritten(ConnectTimeout))
+        return false;
+
+    // Подтверждение приходит после того, как список файлов прочитан целиком.
+    return socket.waitForReadyRead(ConnectTimeout) && socket.read(1) == "1";
+}
+
+bool SingleInstance::listen() {
+    // Сокет доступен только владельцу: файлы для открытия принимаются только от своего пользователя.
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    if (server.listen(serverName()))
+        return true;
+
+    // После аварийного завершения в Unix остается файл сокета, мешающий занять имя. Файл удаляется,
+    // только если к нему нельзя подключиться: сокет другого экземпляра, запущенного одновременно, остается.
+    QLocalSocket probe;
+    probe.connectToServer(serverName());
+    if (probe.waitForConnected(ConnectTimeout))
+        return false;
+    if (probe.error() != QLocalSocket::ServerNotFoundError && probe.error() != QLocalSocket::ConnectionRefusedError)
+        return false;
+
+    QLocalServer::removeServer(serverName());
+    return server.listen(serverName());
+}
+
+void SingleInstance::newConnection() {
+    while (QLocalSocket *socket = server.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            readFiles(socket);
+        });
+        if (socket->bytesAvailable() > 0)
+            readFiles(socket);
+    }
+}
+
+void SingleInstance::readFiles(QLocalSocket *socket) {
+    // Список может прийти по частям; чтение повторяется, пока он не придет целиком.
+    QDataStream in(socket);
+    in.startTransaction();
+    QStringList files;
+    in >> files;
+    if (!in.commitTransaction())
+        return;
+
+    socket->write("1");
+    socket->flush();
+    emit filesReceived(files);
+}
+
+QString SingleInstance::serverName() {
+    QString user = QString::fromLocal8Bit(qgetenv("USER"));
+    if (user.isEmpty())
+        user = QString::fromLocal8Bit(qgetenv("USERNAME"));
+    const QByteArray hash = QCryptographicHash::hash((user + QDir::homePath()).toUtf8(), QCryptographicHash::Sha1);
+    return QCoreApplication::applicationName() + "-" + QString::fromLatin1(hash.toHex().left(12));
+}
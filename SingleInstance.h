@@ -0,0 +1,44 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QString>
+
+// Единственный экземпляр редактора для пользователя.
+// Запущенный экземпляр слушает локальный сокет; новый запуск передает ему пути файлов
+// и завершается, не создавая главное окно.
+class SingleInstance : public QObject {
+    Q_OBJECT
+
+public:
+    SingleInstance(QObject *parent = nullptr);
+
+    // Передача файлов запущенному экземпляру; false, если экземпляр не запущен.
+    static bool sendToRunning(const QStringList &files);
+
+    // Прием файлов от следующих запусков.
+    bool listen();
+
+    // Время ожидания ответа запущенного экземпляра, мс.
+    static const int ConnectTimeout = 200;
+
+signals:
+    void filesReceived(const QStringList &files);
+
+private slots:
+    void newConnection();
+
+private:
+    // У каждого пользователя свое имя сокета.
+    static QString serverName();
+
+    void readFiles(QLocalSocket *socket);
+
+private:
+    QLocalServer server;
+};
+
+#endif // SINGLEINSTANCE_H
@@ -0,0 +1,56 @@
+#include "mainwindow.h"
+#include "StartupProfiler.h"
+
+#include <QtTest>
+#include <QApplication>
+
+// Время запуска окна редактора: от создания MainWindow до первой отрисовки текста
+// и до конца отложенной инициализации, по этапам StartupProfiler. Время выводится
+// как результат замера; тест падает, если первая отрисовка не уложилась в FirstPaintBudget.
+class StartupBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void firstPaint();
+
+private:
+    // Бюджет до первой отрисовки, мс; с запасом на медленные машины сборки.
+    static const int FirstPaintBudget = 1000;
+};
+
+void StartupBenchmark::initTestCase() {
+    QCoreApplication::setApplicationName("TextEditorStartupBenchmark");
+}
+
+void StartupBenchmark::firstPaint() {
+    StartupProfiler *profiler = StartupProfiler::instance();
+    profiler->mark("test start");
+    const qint64 start = profiler->phaseTime("test start");
+
+    MainWindow window;
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+    QTRY_VERIFY_WITH_TIMEOUT(profiler->phaseTime("deferred initialization") >= 0, 10000);
+
+    const double firstPaint = (profiler->phaseTime("first paint") - start) / 1e6;
+    const double deferred = (profiler->phaseTime("deferred initialization") - start) / 1e6;
+    qInfo("First paint %.2f ms, deferred initialization done at %.2f ms", firstPaint, deferred);
+
+    QTest::setBenchmarkResult(firstPaint, QTest::WalltimeMilliseconds);
+    QVERIFY2(firstPaint <= FirstPaintBudget,
+             qPrintable(QString("first paint took %1 ms").arg(firstPaint, 0, 'f', 2)));
+}
+
+int main(int argc, char *argv[]) {
+    // Как и пакетная подсветка, замер не требует дисплея, если платформа не задана явно.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication application(argc, argv);
+    StartupBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "StartupBenchmark.moc"
@@ -0,0 +1,87 @@
+QT       += core gui network widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = StartupBenchmark
+
+# The benchmark shares the build directory with the editor; keep its objects apart.
+OBJECTS_DIR = .obj/StartupBenchmark
+MOC_DIR = .moc/StartupBenchmark
+UI_DIR = .ui/StartupBenchmark
+RCC_DIR = .rcc/StartupBenchmark
+
+# The whole editor except main.cpp, linked against the highlighting engine like the editor.
+LIBS += -L$$OUT_PWD -lHighlightEngine
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/HighlightEngine.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/libHighlightEngine.a
+
+SOURCES += \
+    BatchHighlighter.cpp \
+    BlockData.cpp \
+    BracketIndex.cpp \
+    CodeFolding.cpp \
+    ColorListEditor.cpp \
+    DocumentStatistics.cpp \
+    DocumentTabs.cpp \
+    FileReplacer.cpp \
+    FoldRanges.cpp \
+    GutterRenderer.cpp \
+    HighLighter.cpp \
+    IdentifierIndex.cpp \
+    LayoutBudget.cpp \
+    LineFilter.cpp \
+    MemoryUsage.cpp \
+    Minimap.cpp \
+    ModifiedLines.cpp \
+    MonospacePainter.cpp \
+    PerformanceHud.cpp \
+    ScrollBarMarkers.cpp \
+    SearchResults.cpp \
+    SingleInstance.cpp \
+    StartupBenchmark.cpp \
+    StartupProfiler.cpp \
+    StyleCache.cpp \
+    SymbolIndex.cpp \
+    SymbolOutline.cpp \
+    TextEdit.cpp \
+    Trace.cpp \
+    UpdateScheduler.cpp \
+    mainwindow.cpp
+
+HEADERS += \
+    BatchHighlighter.h \
+    BlockData.h \
+    BracketIndex.h \
+    CodeFolding.h \
+    ColorListEditor.h \
+    DocumentStatistics.h \
+    DocumentTabs.h \
+    FileReplacer.h \
+    FoldRanges.h \
+    GutterRenderer.h \
+    HighLighter.h \
+    IdentifierIndex.h \
+    LayoutBudget.h \
+    LineFilter.h \
+    MemoryUsage.h \
+    Minimap.h \
+    ModifiedLines.h \
+    MonospacePainter.h \
+    PerformanceHud.h \
+    ScrollBarMarkers.h \
+    SearchResults.h \
+    SingleInstance.h \
+    StartupProfiler.h \
+    StyleCache.h \
+    SymbolIndex.h \
+    SymbolOutline.h \
+    TextEdit.h \
+    Trace.h \
+    UpdateScheduler.h \
+    mainwindow.h
+
+FORMS += \
+    mainwindow.ui
+
+RESOURCES += \
+    Styles.qrc
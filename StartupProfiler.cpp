@@ -0,0 +1,53 @@
+#include "StartupProfiler.h"
+
+#include <cstdio>
+
+StartupProfiler::StartupProfiler() {
+    enabled = qgetenv("TEXTEDITOR_STARTUP_PROFILE") == "1";
+    reported = false;
+    phases.reserve(16);
+    timer.start();
+}
+
+StartupProfiler* StartupProfiler::instance() {
+    static StartupProfiler profiler;
+    return &profiler;
+}
+
+void StartupProfiler::setEnabled(bool isEnabled) {
+    enabled = isEnabled;
+}
+
+bool StartupProfiler::isEnabled() const {
+    return enabled;
+}
+
+void StartupProfiler::mark(const char *name) {
+    if (!reported)
+        phases.append(qMakePair(QByteArray(name), timer.nsecsElapsed()));
+}
+
+void StartupProfiler::report() {
+    if (reported)
+        return;
+    reported = true;
+    if (!enabled)
+        return;
+
+    qint64 previous = 0;
+    for (const QPair<QByteArray, qint64> &phase : phases) {
+        fprintf(stderr, "Startup: %-24s %8.2f ms (at %8.2f ms)\n", phase.first.constData(),
+                (phase.second - previous) / 1e6, phase.second / 1e6);
+        previous = phase.second;
+    }
+    fprintf(stderr, "Startup: total %.2f ms\n", previous / 1e6);
+    fflush(stderr);
+}
+
+qint64 StartupProfiler::phaseTime(const char *name) const {
+    for (const QPair<QByteArray, qint64> &phase : phases) {
+        if (phase.first == name)
+            return phase.second;
+    }
+    return -1;
+}
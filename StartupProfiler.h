@@ -0,0 +1,39 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QVector>
+#include <QPair>
+
+// Замер этапов запуска: от начала main до первой отрисовки окна и отложенной инициализации.
+// Этапы отмечаются всегда (это только чтение таймера), отчет выводится, если замер включен
+// ключом --profile-startup или переменной окружения TEXTEDITOR_STARTUP_PROFILE=1.
+class StartupProfiler {
+public:
+    static StartupProfiler* instance();
+
+    void setEnabled(bool enabled);
+
+    bool isEnabled() const;
+
+    // Конец этапа name; длительность этапа - время от конца предыдущего.
+    void mark(const char *name);
+
+    // Вывод этапов и общего времени в stderr (один раз); не зависит от QT_NO_DEBUG_OUTPUT.
+    void report();
+
+    // Время конца этапа name от первого обращения к замеру, нс; -1, если этап еще не отмечен.
+    qint64 phaseTime(const char *name) const;
+
+private:
+    StartupProfiler();
+
+private:
+    QElapsedTimer timer;
+    QVector<QPair<QByteArray, qint64>> phases;
+    bool enabled;
+    bool reported;
+};
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,164 @@
+#include "StyleCache.h"
+
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+
+namespace {
+
+const quint32 CacheMagic = 0x53545943;   // "STYC"
+const quint16 CacheVersion = 1;
+
+// Признаки заданных свойств формата: отсутствующее свойство не равно свойству со значением по умолчанию.
+enum FormatFlag {
+    HasForeground = 0x01,
+    HasWeight = 0x02,
+    HasItalic = 0x04,
+    Italic = 0x08,
+    HasUnderline = 0x10,
+    Underline = 0x20
+};
+
+QTextCharFormat* styleFormats(Style &style, int index) {
+    QTextCharFormat *formats[] = {
+        &style.keywordFormat, &style.classFormat, &style.quotationFormat, &style.functionFormat,
+        &style.includeFormat, &style.singleLineCommentFormat, &style.multiLineCommentFormat,
+        &style.searchFormat
+    };
+    return formats[index];
+}
+
+const int StyleFormatCount = 8;
+
+} // namespace
+
+StyleCache::StyleCache() {
+    isRead = false;
+    cacheFileName = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/styles.cache";
+}
+
+StyleCache* StyleCache::instance() {
+    static StyleCache cache;
+    return &cache;
+}
+
+bool StyleCache::load(const QString &fileName, Style *style, QString *errorMessage) {
+    if (!isRead)
+        read();
+
+    const QFileInfo info(fileName);
+    const QString key = info.absoluteFilePath();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+
+    QHash<QString, Entry>::const_iterator it = entries.constFind(key);
+    if (it != entries.constEnd() && it->modified == modified && it->size == size) {
+        *style = it->style;
+        return true;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = file.errorString();
+        return false;
+    }
+    Style parsed;
+    if (!StyleJson::read(file.readAll(), &parsed, errorMessage))
+        return false;
+
+    entries.insert(key, { modified, size, parsed });
+    write();
+    *style = parsed;
+    return true;
+}
+
+void StyleCache::read() {
+    isRead = true;
+
+    QFile file(cacheFileName);
+    if (!file.open(QFile::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic;
+    quint16 version;
+    quint32 count;
+    in >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheVersion)
+        return;
+
+    // Поврежденный кэш отбрасывается целиком: стили просто будут разобраны заново.
+    QHash<QString, Entry> cached;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.modified >> entry.size;
+        for (int format = 0; format < StyleFormatCount; ++format)
+            *styleFormats(entry.style, format) = readFormat(in);
+        cached.insert(key, entry);
+    }
+    if (in.status() == QDataStream::Ok)
+        entries = cached;
+}
+
+void StyleCache::write() const {
+    QDir().mkpath(QFileInfo(cacheFileName).path());
+    QSaveFile file(cacheFileName);
+    if (!file.open(QFile::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << CacheMagic << CacheVersion << quint32(entries.size());
+    for (QHash<QString, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        out << it.key() << it->modified << it->size;
+        Style style = it->style;
+        for (int format = 0; format < StyleFormatCount; ++format)
+            writeFormat(out, *styleFormats(style, format));
+    }
+    file.commit();
+}
+
+void StyleCache::writeFormat(QDataStream &out, const QTextCharFormat &format) {
+    quint8 flags = 0;
+    if (format.hasProperty(QTextFormat::ForegroundBrush))
+        flags |= HasForeground;
+    if (format.hasProperty(QTextFormat::FontWeight))
+        flags |= HasWeight;
+    if (format.hasProperty(QTextFormat::FontItalic))
+        flags |= HasItalic | (format.fontItalic() ? Italic : 0);
+    if (format.hasProperty(QTextFormat::TextUnderlineStyle))
+        flags |= HasUnderline | (format.fontUnderline() ? Underline : 0);
+
+    out << flags;
+    if (flags & HasForeground)
+        out << quint32(format.foreground().color().rgba());
+    if (flags & HasWeight)
+        out << qint16(format.fontWeight());
+}
+
+QTextCharFormat StyleCache::readFormat(QDataStream &in) {
+    QTextCharFormat format;
+    quint8 flags;
+    in >> flags;
+    if (flags & HasForeground) {
+        quint32 rgba;
+        in >> rgba;
+        format.setForeground(QBrush(QColor::fromRgba(rgba)));
+    }
+    if (flags & HasWeight) {
+        qint16 weight;
+        in >> weight;
+        format.setFontWeight(weight);
+    }
+    if (flags & HasItalic)
+        format.setFontItalic(flags & Italic);
+    if (flags & HasUnderline)
+        format.setFontUnderline(flags & Underline);
+    return format;
+}
@@ -0,0 +1,42 @@
+#ifndef STYLECACHE_H
+#define STYLECACHE_H
+
+#include "SyntaxStyle.h"
+
+#include <QDataStream>
+#include <QHash>
+#include <QString>
+
+// Двоичный кэш разобранных файлов стилей. Запись кэша - путь к файлу, время его изменения
+// и размер; пока файл не меняется, стиль читается из кэша без разбора JSON. Кэш хранится
+// в одном файле в каталоге кэша приложения и читается при первом обращении.
+class StyleCache {
+public:
+    static StyleCache* instance();
+
+    // Стиль из файла fileName: из кэша, если файл не менялся, иначе разбором JSON с записью в кэш.
+    bool load(const QString &fileName, Style *style, QString *errorMessage = nullptr);
+
+private:
+    StyleCache();
+
+    void read();
+
+    void write() const;
+
+    static void writeFormat(QDataStream &out, const QTextCharFormat &format);
+
+    static QTextCharFormat readFormat(QDataStream &in);
+
+private:
+    struct Entry {
+        qint64 modified;
+        qint64 size;
+        Style style;
+    };
+    QHash<QString, Entry> entries;
+    QString cacheFileName;
+    bool isRead;
+};
+
+#endif // STYLECACHE_H
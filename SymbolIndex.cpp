@@ -0,0 +1,165 @@
+#include "SymbolIndex.h"
+
+#include <algorithm>
+
+SymbolIndex::SymbolIndex(QTextDocument *document) : QObject(document), document(document) {
+    isDirty = false;
+
+    // Номера строк символов меняются при добавлении и удалении строк выше них.
+    connect(document, &QTextDocument::blockCountChanged, this, &SymbolIndex::markDirty);
+}
+
+SymbolIndex* SymbolIndex::forDocument(QTextDocument *document) {
+    SymbolIndex *index = document->findChild<SymbolIndex*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!index)
+        index = new SymbolIndex(document);
+    return index;
+}
+
+int SymbolIndex::nameId(const QString &name) {
+    QHash<QString, int>::const_iterator it = nameIds.constFind(name);
+    if (it != nameIds.constEnd())
+        return it.value();
+
+    const int id = names.size();
+    names.append(name);
+    nameIds.insert(name, id);
+    return id;
+}
+
+QString SymbolIndex::name(int nameId) const {
+    return names.value(nameId);
+}
+
+void SymbolIndex::setBlockSymbols(const QTextBlock &block, BlockData *data,
+                                  const QVector<BlockData::Symbol> &symbols) {
+    if (data->symbols == symbols)
+        return;
+
+    data->symbols = symbols;
+    if (symbols.isEmpty()) {
+        blocks.remove(data);
+    } else {
+        blocks.insert(data, block);
+        data->symbolIndex = this;
+    }
+    markDirty();
+}
+
+const QVector<SymbolIndex::Entry>& SymbolIndex::getEntries() {
+    if (isDirty)
+        rebuild();
+    return entries;
+}
+
+QVector<SymbolIndex::Entry> SymbolIndex::find(const QString &query, int limit) {
+    if (isDirty)
+        rebuild();
+
+    // Оценка вычисляется один раз для каждого имени, а не для каждого вхождения.
+    QVector<QPair<int, int>> scored;
+    for (int i = 0; i < byName.size(); ) {
+        const int id = entries.at(byName.at(i)).nameId;
+        int end = i + 1;
+        while (end < byName.size() && entries.at(byName.at(end)).nameId == id)
+            ++end;
+
+        const int score = fuzzyScore(names.at(id), query);
+        if (score >= 0) {
+            for (int j = i; j < end; ++j)
+                scored.append(qMakePair(-score, byName.at(j)));
+        }
+        i = end;
+    }
+
+    const int count = qMin(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end());
+
+    QVector<Entry> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i)
+        result.append(entries.at(scored.at(i).second));
+    return result;
+}
+
+qint64 SymbolIndex::memoryUsage() const {
+    // Имя хранится один раз: строки таблицы имен и ключи nameIds общие.
+    // Узел QHash - указатель на следующий узел и хеш перед ключом и значением.
+    const qint64 nodeBytes = sizeof(void*) + sizeof(uint);
+    qint64 bytes = sizeof(SymbolIndex);
+    for (const QString &name : names)
+        bytes += 2 * name.capacity() + nodeBytes + sizeof(QString) + sizeof(int);
+    bytes += names.capacity() * sizeof(QString);
+    bytes += blocks.size() * (nodeBytes + sizeof(BlockData*) + sizeof(QTextBlock));
+    bytes += entries.capacity() * sizeof(Entry) + byName.capacity() * sizeof(int);
+    return bytes;
+}
+
+void SymbolIndex::markDirty() {
+    if (!isDirty) {
+        isDirty = true;
+        emit changed();
+    }
+}
+
+void SymbolIndex::blockDataDestroyed(BlockData *data) {
+    if (blocks.remove(data))
+        markDirty();
+}
+
+void SymbolIndex::rebuild() {
+    isDirty = false;
+    entries.clear();
+
+    for (QHash<BlockData*, QTextBlock>::iterator it = blocks.begin(); it != blocks.end(); ) {
+        const QTextBlock &block = it.value();
+        if (!block.isValid() || block.userData() != it.key()) {
+            it = blocks.erase(it);
+            continue;
+        }
+
+        const int line = block.blockNumber();
+        for (const BlockData::Symbol &symbol : it.key()->symbols)
+            entries.append({ symbol.nameId, symbol.kind, line, symbol.column });
+        ++it;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.line < b.line || (a.line == b.line && a.column < b.column);
+    });
+
+    byName.resize(entries.size());
+    for (int i = 0; i < byName.size(); ++i)
+        byName[i] = i;
+    std::stable_sort(byName.begin(), byName.end(), [this](int a, int b) {
+        return entries.at(a).nameId < entries.at(b).nameId;
+    });
+}
+
+int SymbolIndex::fuzzyScore(const QString &name, const QString &query) {
+    int score = 0;
+    int position = 0;
+    int previous = -2;
+    for (const QChar c : query) {
+        const QChar lower = c.toLower();
+        while (position < name.size() && name.at(position).toLower() != lower)
+            ++position;
+        if (position == name.size())
+            return -1;
+
+        score += 1;
+        if (position == previous + 1)
+            score += 5;
+        if (position == 0 || name.at(position - 1) == '_'
+            || (name.at(position).isUpper() && name.at(position - 1).isLower()))
+            score += 10;
+        if (name.at(position) == c)
+            score += 1;
+
+        previous = position;
+        ++position;
+    }
+
+    // При равных совпадениях выше короткие имена.
+    return score * 64 + qMax(0, 63 - name.size());
+}
@@ -0,0 +1,88 @@
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include "BlockData.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QHash>
+#include <QVector>
+#include <QString>
+
+// Таблица символов документа (функции и классы), заполняемая подсветкой.
+// Символы каждой строки хранятся в BlockData и меняются только при подсветке этой строки,
+// имена хранятся один раз (номер имени вместо строки). Общий список в порядке строк
+// и порядок по именам строятся заново только после изменений и только по запросу.
+class SymbolIndex : public QObject {
+    Q_OBJECT
+
+public:
+    enum Kind {
+        Function,
+        Class
+    };
+
+    struct Entry {
+        int nameId;
+        int kind;
+        int line;       // номер блока
+        int column;
+    };
+
+    // Индекс документа; создается при первом обращении и принадлежит документу.
+    static SymbolIndex* forDocument(QTextDocument *document);
+
+    // Номер имени; новое имя добавляется в таблицу имен.
+    int nameId(const QString &name);
+
+    QString name(int nameId) const;
+
+    // Символы строки после ее подсветки.
+    void setBlockSymbols(const QTextBlock &block, BlockData *data, const QVector<BlockData::Symbol> &symbols);
+
+    // Все символы в порядке строк.
+    const QVector<Entry>& getEntries();
+
+    // Символы, имена которых содержат символы query в том же порядке (без учета регистра),
+    // лучшие совпадения первыми; не более limit.
+    QVector<Entry> find(const QString &query, int limit);
+
+    // Оценка занимаемой памяти, байт.
+    qint64 memoryUsage() const;
+
+signals:
+    // Символы изменились после последнего запроса.
+    void changed();
+
+private slots:
+    void markDirty();
+
+private:
+    SymbolIndex(QTextDocument *document);
+
+    void blockDataDestroyed(BlockData *data);
+
+    void rebuild();
+
+    // Оценка совпадения: -1 - не совпадает; выше за подряд идущие символы и начала слов.
+    static int fuzzyScore(const QString &name, const QString &query);
+
+private:
+    friend class BlockData;
+
+    QTextDocument *document;
+
+    QHash<QString, int> nameIds;
+    QVector<QString> names;
+
+    // Строки, в которых есть символы. Блок проверяется при перестроении:
+    // у удаленного блока пользовательские данные уже другие.
+    QHash<BlockData*, QTextBlock> blocks;
+
+    QVector<Entry> entries;
+    QVector<int> byName;
+    bool isDirty;
+};
+
+#endif // SYMBOLINDEX_H
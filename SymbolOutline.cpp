@@ -0,0 +1,159 @@
+#include "SymbolOutline.h"
+
+#include <QBoxLayout>
+#include <QElapsedTimer>
+
+static QString symbolText(const SymbolIndex *index, const SymbolIndex::Entry &entry) {
+    QString text = index->name(entry.nameId);
+    if (entry.kind == SymbolIndex::Function)
+        text += "()";
+    return text + "  :" + QString::number(entry.line + 1);
+}
+
+SymbolOutlineModel::SymbolOutlineModel(QObject *parent) : QAbstractListModel(parent) {
+}
+
+void SymbolOutlineModel::setIndex(SymbolIndex *newIndex) {
+    index = newIndex;
+    refresh();
+}
+
+void SymbolOutlineModel::refresh() {
+    beginResetModel();
+    if (index)
+        entries = index->getEntries();
+    else
+        entries.clear();
+    endResetModel();
+}
+
+int SymbolOutlineModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : entries.size();
+}
+
+QVariant SymbolOutlineModel::data(const QModelIndex &modelIndex, int role) const {
+    if (!modelIndex.isValid() || modelIndex.row() >= entries.size() || !index)
+        return QVariant();
+
+    if (role == Qt::DisplayRole)
+        return symbolText(index, entries.at(modelIndex.row()));
+    return QVariant();
+}
+
+SymbolIndex::Entry SymbolOutlineModel::entry(int row) const {
+    return entries.at(row);
+}
+
+SymbolOutlinePanel::SymbolOutlinePanel(QWidget *parent) : QDockWidget(tr("Outline"), parent) {
+    setObjectName("SymbolOutlinePanel");
+
+    model = new SymbolOutlineModel(this);
+
+    view = new QListView;
+    view->setModel(model);
+    view->setUniformItemSizes(true);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setSelectionMode(QAbstractItemView::SingleSelection);
+
+    summary = new QLabel;
+
+    QWidget *widget = new QWidget;
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(summary);
+    layout->addWidget(view);
+    widget->setLayout(layout);
+    setWidget(widget);
+
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(RefreshDelay);
+    connect(&refreshTimer, &QTimer::timeout, this, &SymbolOutlinePanel::refresh);
+
+    connect(view, &QListView::activated, this, &SymbolOutlinePanel::rowActivated);
+    connect(view, &QListView::clicked, this, &SymbolOutlinePanel::rowActivated);
+    connect(this, &QDockWidget::visibilityChanged, this, &SymbolOutlinePanel::scheduleRefresh);
+}
+
+void SymbolOutlinePanel::setDocument(QTextDocument *document) {
+    if (index)
+        disconnect(index, nullptr, this, nullptr);
+
+    index = SymbolIndex::forDocument(document);
+    connect(index, &SymbolIndex::changed, this, &SymbolOutlinePanel::scheduleRefresh);
+    model->setIndex(index);
+    scheduleRefresh();
+}
+
+void SymbolOutlinePanel::scheduleRefresh() {
+    if (isVisible() && !refreshTimer.isActive())
+        refreshTimer.start();
+}
+
+void SymbolOutlinePanel::refresh() {
+    if (!isVisible())
+        return;
+
+    model->refresh();
+    summary->setText(QString::number(model->rowCount()) + " symbols");
+}
+
+void SymbolOutlinePanel::rowActivated(const QModelIndex &modelIndex) {
+    if (modelIndex.isValid()) {
+        SymbolIndex::Entry entry = model->entry(modelIndex.row());
+        emit symbolActivated(entry.line, entry.column);
+    }
+}
+
+GoToSymbolDialog::GoToSymbolDialog(SymbolIndex *index, QWidget *parent) : QDialog(parent), index(index) {
+    setWindowTitle(tr("Go to symbol"));
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    queryEdit = new QLineEdit;
+    results = new QListWidget;
+    results->setUniformItemSizes(true);
+    summary = new QLabel;
+
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    layout->addWidget(queryEdit);
+    layout->addWidget(results);
+    layout->addWidget(summary);
+    setLayout(layout);
+    resize(480, 360);
+
+    connect(queryEdit, &QLineEdit::textChanged, this, &GoToSymbolDialog::search);
+    connect(queryEdit, &QLineEdit::returnPressed, this, &GoToSymbolDialog::acceptCurrent);
+    connect(results, &QListWidget::itemActivated, this, &GoToSymbolDialog::itemActivated);
+
+    search(QString());
+}
+
+void GoToSymbolDialog::search(const QString &query) {
+    results->clear();
+    if (!index)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<SymbolIndex::Entry> found = index->find(query, MaxResults);
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    for (const SymbolIndex::Entry &entry : found) {
+        QListWidgetItem *item = new QListWidgetItem(symbolText(index, entry), results);
+        item->setData(Qt::UserRole, entry.line);
+        item->setData(Qt::UserRole + 1, entry.column);
+    }
+    if (results->count() > 0)
+        results->setCurrentRow(0);
+
+    summary->setText(QString("%1 symbols, %2 ms").arg(found.size()).arg(elapsed / 1e6, 0, 'f', 2));
+}
+
+void GoToSymbolDialog::itemActivated(QListWidgetItem *item) {
+    emit symbolActivated(item->data(Qt::UserRole).toInt(), item->data(Qt::UserRole + 1).toInt());
+    accept();
+}
+
+void GoToSymbolDialog::acceptCurrent() {
+    if (results->currentItem())
+        itemActivated(results->currentItem());
+}
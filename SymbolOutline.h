@@ -0,0 +1,97 @@
+#ifndef SYMBOLOUTLINE_H
+#define SYMBOLOUTLINE_H
+
+#include "SymbolIndex.h"
+
+#include <QAbstractListModel>
+#include <QDockWidget>
+#include <QDialog>
+#include <QListView>
+#include <QListWidget>
+#include <QLineEdit>
+#include <QLabel>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+// Модель структуры документа: символы в порядке строк.
+// Хранит копию списка индекса, текст строки списка формируется только для отображаемых строк.
+class SymbolOutlineModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    SymbolOutlineModel(QObject *parent = nullptr);
+
+    void setIndex(SymbolIndex *index);
+
+    // Перечитывание списка символов из индекса.
+    void refresh();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    SymbolIndex::Entry entry(int row) const;
+
+private:
+    QPointer<SymbolIndex> index;
+    QVector<SymbolIndex::Entry> entries;
+};
+
+// Панель структуры документа. Список обновляется не чаще RefreshDelay мс и только когда панель видна.
+class SymbolOutlinePanel : public QDockWidget {
+    Q_OBJECT
+
+public:
+    SymbolOutlinePanel(QWidget *parent = nullptr);
+
+    void setDocument(QTextDocument *document);
+
+    static const int RefreshDelay = 300;
+
+signals:
+    // line - номер блока.
+    void symbolActivated(int line, int column);
+
+private slots:
+    void scheduleRefresh();
+
+    void refresh();
+
+    void rowActivated(const QModelIndex &index);
+
+private:
+    SymbolOutlineModel *model;
+    QListView *view;
+    QLabel *summary;
+    QPointer<SymbolIndex> index;
+    QTimer refreshTimer;
+};
+
+// Переход к символу по неточному совпадению имени (буквы запроса в том же порядке).
+class GoToSymbolDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    GoToSymbolDialog(SymbolIndex *index, QWidget *parent = nullptr);
+
+    static const int MaxResults = 200;
+
+signals:
+    void symbolActivated(int line, int column);
+
+private slots:
+    void search(const QString &query);
+
+    void itemActivated(QListWidgetItem *item);
+
+    void acceptCurrent();
+
+private:
+    QPointer<SymbolIndex> index;
+    QLineEdit *queryEdit;
+    QListWidget *results;
+    QLabel *summary;
+};
+
+#endif // SYMBOLOUTLINE_H
@@ -0,0 +1,272 @@
+#include "SyntaxStyle.h"
+
+#include <QTextStream>
+#include <QLatin1String>
+#include <QBrush>
+#include <QColor>
+
+#include <cctype>
+
+namespace {
+
+// Разбор стиля за один проход по байтам файла без промежуточных строк. Пробелы и порядок
+// ключей не важны; неизвестные ключи пропускаются вместе со значениями.
+class StyleReader {
+public:
+    StyleReader(const QByteArray &json) : begin(json.constData()), p(begin), end(begin + json.size()) {}
+
+    bool readStyle(Style *style) {
+        return readObject([this, style](QLatin1String key) -> bool {
+            QTextCharFormat *format = formatByName(style, key);
+            return format ? readFormat(*format) : skipValue();
+        }) && atEnd();
+    }
+
+    QString errorMessage() const {
+        return QString("Данный формат стиля не поддерживается системой (позиция %1).").arg(p - begin);
+    }
+
+private:
+    static QTextCharFormat* formatByName(Style *style, QLatin1String name) {
+        if (name == QLatin1String("keywordFormat"))
+            return &style->keywordFormat;
+        if (name == QLatin1String("classFormat"))
+            return &style->classFormat;
+        if (name == QLatin1String("quotationFormat"))
+            return &style->quotationFormat;
+        if (name == QLatin1String("functionFormat"))
+            return &style->functionFormat;
+        if (name == QLatin1String("includeFormat"))
+            return &style->includeFormat;
+        if (name == QLatin1String("singleLineCommentFormat"))
+            return &style->singleLineCommentFormat;
+        if (name == QLatin1String("multiLineCommentFormat"))
+            return &style->multiLineCommentFormat;
+        if (name == QLatin1String("searchFormat"))
+            return &style->searchFormat;
+        return nullptr;
+    }
+
+    bool readFormat(QTextCharFormat &format) {
+        return readObject([this, &format](QLatin1String key) -> bool {
+            if (key == QLatin1String("Foreground")) {
+                QLatin1String name;
+                if (!readString(&name))
+                    return false;
+                QColor color;
+                color.setNamedColor(name);
+                if (!color.isValid())
+                    return false;
+                format.setForeground(QBrush(color));
+                return true;
+            }
+            if (key == QLatin1String("FontWeight")) {
+                int weight;
+                if (!readNumber(&weight))
+                    return false;
+                format.setFontWeight(weight);
+                return true;
+            }
+            if (key == QLatin1String("FontItalic") || key == QLatin1String("FontUnderline")) {
+                bool value;
+                if (!readBool(&value))
+                    return false;
+                if (key == QLatin1String("FontItalic"))
+                    format.setFontItalic(value);
+                else
+                    format.setFontUnderline(value);
+                return true;
+            }
+            return skipValue();
+        });
+    }
+
+    // Объект { "ключ": значение, ... }; значение читает readMember.
+    template <typename ReadMember>
+    bool readObject(ReadMember readMember) {
+        if (!consume('{'))
+            return false;
+        if (consume('}'))
+            return true;
+        do {
+            QLatin1String key;
+            if (!readString(&key) || !consume(':') || !readMember(key))
+                return false;
+        } while (consume(','));
+        return consume('}');
+    }
+
+    // Строка без разбора экранирования: в ключах и цветах стиля его не бывает.
+    bool readString(QLatin1String *value) {
+        if (!consume('"'))
+            return false;
+        const char *start = p;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end)
+                ++p;
+            ++p;
+        }
+        if (p == end)
+            return false;
+        *value = QLatin1String(start, int(p - start));
+        ++p;
+        return true;
+    }
+
+    bool readNumber(int *value) {
+        skipSpace();
+        const bool isNegative = p < end && *p == '-';
+        if (isNegative)
+            ++p;
+        if (p == end || *p < '0' || *p > '9')
+            return false;
+        int number = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+            number = number * 10 + (*p++ - '0');
+        *value = isNegative ? -number : number;
+        return true;
+    }
+
+    // true/false; числа 1/0 тоже допускаются, их записывает сохранение стиля.
+    bool readBool(bool *value) {
+        if (consumeWord("true") || consumeWord("1")) {
+            *value = true;
+            return true;
+        }
+        if (consumeWord("false") || consumeWord("0")) {
+            *value = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool skipValue() {
+        skipSpace();
+        if (p == end)
+            return false;
+        if (*p == '"') {
+            QLatin1String value;
+            return readString(&value);
+        }
+        if (*p == '{')
+            return readObject([this](QLatin1String) -> bool { return skipValue(); });
+        if (*p == '[') {
+            ++p;
+            if (consume(']'))
+                return true;
+            do {
+                if (!skipValue())
+                    return false;
+            } while (consume(','));
+            return consume(']');
+        }
+        // Число, true, false или null.
+        const char *start = p;
+        while (p < end && (isalnum(uchar(*p)) || *p == '-' || *p == '+' || *p == '.'))
+            ++p;
+        return p != start;
+    }
+
+    bool consumeWord(const char *word) {
+        skipSpace();
+        const int length = int(qstrlen(word));
+        if (end - p < length || qstrncmp(p, word, uint(length)) != 0)
+            return false;
+        p += length;
+        return true;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (p == end || *p != c)
+            return false;
+        ++p;
+        return true;
+    }
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+            ++p;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return p == end;
+    }
+
+private:
+    const char *begin;
+    const char *p;
+    const char *end;
+};
+
+} // namespace
+
+bool StyleJson::read(const QByteArray &json, Style *style, QString *errorMessage) {
+    Style parsed;
+    StyleReader reader(json);
+    if (!reader.readStyle(&parsed)) {
+        if (errorMessage)
+            *errorMessage = reader.errorMessage();
+        return false;
+    }
+    *style = parsed;
+    return true;
+}
+
+QByteArray StyleJson::write(const Style &style) {
+    QByteArray json;
+    QTextStream out(&json, QIODevice::WriteOnly);
+    out << "{\n"
+        << "  \"classFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.classFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.classFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.classFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.classFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"functionFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.functionFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.functionFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.functionFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.functionFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"includeFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.includeFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.includeFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.includeFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.includeFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"keywordFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.keywordFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.keywordFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.keywordFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.keywordFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"multiLineCommentFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.multiLineCommentFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.multiLineCommentFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.multiLineCommentFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.multiLineCommentFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"quotationFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.quotationFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.quotationFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.quotationFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.quotationFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"searchFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.searchFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.searchFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.searchFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.searchFormat.foreground().color().name() << "\"\n"
+        << "  },\n"
+        << "  \"singleLineCommentFormat\": {\n"
+        << "    \"FontItalic\": " <<    style.singleLineCommentFormat.fontItalic() << ",\n"
+        << "    \"FontUnderline\": " << style.singleLineCommentFormat.fontUnderline() << ",\n"
+        << "    \"FontWeight\": " <<    style.singleLineCommentFormat.fontWeight() << ",\n"
+        << "    \"Foreground\": \"" <<  style.singleLineCommentFormat.foreground().color().name() << "\"\n"
+        << "  }\n"
+        << "}";
+    out.flush();
+    return json;
+}
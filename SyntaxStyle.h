@@ -0,0 +1,30 @@
+#ifndef SYNTAXSTYLE_H
+#define SYNTAXSTYLE_H
+
+#include <QTextCharFormat>
+#include <QByteArray>
+#include <QString>
+
+struct Style {
+    QTextCharFormat keywordFormat;
+    QTextCharFormat classFormat;
+    QTextCharFormat quotationFormat;
+    QTextCharFormat functionFormat;
+    QTextCharFormat includeFormat;
+    QTextCharFormat singleLineCommentFormat;
+    QTextCharFormat multiLineCommentFormat;
+    QTextCharFormat searchFormat;
+};
+
+// Чтение и запись стиля в JSON. Файлы и окна здесь не используются, поэтому функции
+// можно вызывать из любого потока; сообщения об ошибках показывает вызывающий код.
+class StyleJson {
+public:
+    // Разбор стиля за один проход; пробелы и порядок ключей не важны, отсутствующие форматы
+    // остаются пустыми. false и описание ошибки в errorMessage (если задано) при ошибке разбора.
+    static bool read(const QByteArray &json, Style *style, QString *errorMessage = nullptr);
+
+    static QByteArray write(const Style &style);
+};
+
+#endif // SYNTAXSTYLE_H
@@ -1,11 +1,20 @@
 #include "TextEdit.h"
 
+#include <QScrollBar>
+#include <QTextLayout>
+#include <QAbstractTextDocumentLayout>
+#include <QElapsedTimer>
+#include <QPolygonF>
+#include <QAbstractItemView>
+#include <QMessageBox>
+
 TextEditor::TextEditor(QWidget *parent) : QPlainTextEdit(parent) {
     this->setWordWrapMode(QTextOption::NoWrap);
 
     cursorPos = new QLabel(this->parentWidget());
     isLineNumberingActive = true;
     isSelection = false;
+    minimap = nullptr;
 
     this->setBackgroundVisible(true);
     setCurrentLineColor();
@@ -17,10 +26,54 @@ TextEditor::TextEditor(QWidget *parent) : QPlainTextEdit(parent) {
     // Создание новой области нумерации
     lineNumberArea = new LineNumberArea(this);
 
+    // TEXTEDITOR_GUTTER_CACHE=0 возвращает отрисовку номеров через drawText (для сравнения замеров строки Gutter на PerformanceHud).
+    isGutterCacheEnabled = qgetenv("TEXTEDITOR_GUTTER_CACHE") != "0";
+
+    // TEXTEDITOR_FAST_PAINT=0 отключает быструю отрисовку моноширинного текста.
+    monospacePainter.setEnabled(qgetenv("TEXTEDITOR_FAST_PAINT") != "0");
+
+    lineFilter = new LineFilter(this);
+    connect(lineFilter, &LineFilter::finished, this, &TextEditor::applyLineFilter);
+
+    relayoutBlockNumber = -1;
+    relayoutFirst = 0;
+    relayoutLast = -1;
+    relayoutTimer.setInterval(0);
+    connect(&relayoutTimer, &QTimer::timeout, this, &TextEditor::relayoutStep);
+
+    highlightBlockNumber = -1;
+    highlightTimer.setInterval(0);
+    connect(&highlightTimer, &QTimer::timeout, this, &TextEditor::highlightStep);
+
+    minimap = new Minimap(this);
+    minimap->setDocument(document());
+    isMinimapVisible = true;
+    minimapRevision = -1;
+    updateMinimapColors();
+    connect(minimap, &Minimap::lineActivated, this, &TextEditor::scrollToLine);
+
+    scrollBarMarkers = new ScrollBarMarkers(verticalScrollBar());
+    connectDocument();
+
+    hud = nullptr;
+    hudHighlightTime = 0;
+
+    completionModel = new QStringListModel(this);
+    completer = new QCompleter(completionModel, this);
+    completer->setWidget(this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseSensitive);
+    connect(completer, QOverload<const QString &>::of(&QCompleter::activated),
+            this, &TextEditor::insertCompletion);
+
     // Привязка сигналов к слотам
-    connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(updateLineNumberAreaWidth(int)));
+    connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(scheduleLineNumberAreaWidthUpdate()));
     connect(this, &TextEditor::updateRequest, this, &TextEditor::updateLineNumberArea);
-    connect(this, &TextEditor::cursorPositionChanged, this, &TextEditor::highlightCurrentLine);
+
+    // Строки, прокрученные на экран, подсвечиваются до отрисовки.
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &TextEditor::restoreReleasedBlocks);
+
+    connect(this, &TextEditor::cursorPositionChanged, this, &TextEditor::scheduleCurrentLineUpdate);
     connect(this, SIGNAL(copyAvailable(bool)), this, SLOT(maybeCopy(bool)));
 
     // Рассчет ширины области нумерации и подсветка 1-й строки
@@ -28,16 +81,35 @@ TextEditor::TextEditor(QWidget *parent) : QPlainTextEdit(parent) {
     highlightCurrentLine();
 }
 
+TextEditor::~TextEditor() {
+    // Экран представления больше не удерживает строки документа в бюджете памяти.
+    LayoutBudget::forDocument(document())->removeView(this);
+}
+
 void TextEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
+    TraceScope trace("TextEditor::lineNumberAreaPaintEvent");
     if (isLineNumberingActive) {
+        QElapsedTimer timer;
+        timer.start();
+
         // Задаем фон области нумерации
         QPainter painter(lineNumberArea);
         painter.fillRect(event->rect(), Qt::lightGray);
 
+        // Цифры берутся из атласа, который перестраивается только при смене шрифта.
+        gutterRenderer.setFont(lineNumberArea->font(), Qt::black, lineNumberArea->devicePixelRatioF());
+        const int lineHeight = gutterRenderer.getLineHeight();
+        const int foldWidth = foldAreaWidth();
+        const int right = lineNumberArea->width() - foldWidth;
+        painter.setPen(Qt::black);
+        painter.setBrush(Qt::darkGray);
+
         // Теперь мы пройдемся по всем видимым линиям и нарисуем номера линий в дополнительной области для каждой линии.
         // При редактировании обычного текста один номер прикреплен к одному QTextBlock.
         // Если перенос строк включен, один номер может охватывать несколько строк в видовом окне редактирования текста.
         QTextBlock block = firstVisibleBlock();
+        if (block.isValid() && !block.isVisible())
+            block = nextVisibleBlock(block);
         int blockNumber = block.blockNumber();
         int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
         int bottom = top + qRound(blockBoundingRect(block).height());
@@ -49,20 +121,58 @@ void TextEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
             // Проверяем, виден ли блок, а также проверяем, находится ли он в области просмотра -
             // блок может быть, например, скрыт окном, расположенным над текстовым редактором.
             if (block.isVisible() && bottom >= event->rect().top()) {
-                QString number = QString::number(blockNumber + 1);
-                painter.setPen(Qt::black);
-                painter.drawText(0, top, lineNumberArea->width(), fontMetrics().height(),
-                                 Qt::AlignRight, number);
+                if (isGutterCacheEnabled) {
+                    gutterRenderer.drawNumber(&painter, blockNumber + 1, right, top);
+                } else {
+                    painter.drawText(0, top, right, lineHeight,
+                                     Qt::AlignRight, QString::number(blockNumber + 1));
+                }
+
+                // Маркер сворачивания: вправо - фрагмент свернут, вниз - развернут.
+                const BlockData *data = static_cast<const BlockData*>(block.userData());
+                const bool isFolded = data && data->isFolded;
+                if (isFolded || CodeFolding::isFoldStart(block)) {
+                    const qreal size = foldWidth / 3.0;
+                    const QPointF center(right + foldWidth / 2.0, top + lineHeight / 2.0);
+                    QPolygonF marker;
+                    if (isFolded) {
+                        marker << center + QPointF(-size / 2, -size) << center + QPointF(size / 2, 0)
+                               << center + QPointF(-size / 2, size);
+                    } else {
+                        marker << center + QPointF(-size, -size / 2) << center + QPointF(size, -size / 2)
+                               << center + QPointF(0, size / 2);
+                    }
+                    painter.drawPolygon(marker);
+                }
             }
 
             block = block.next();
+            ++blockNumber;
+
+            // Скрытые фильтром строки пропускаются без разметки, номер берется у следующего видимого блока.
+            if (block.isValid() && !block.isVisible()) {
+                block = nextVisibleBlock(block);
+                blockNumber = block.blockNumber();
+            }
             top = bottom;
             bottom = top + qRound(blockBoundingRect(block).height());
-            ++blockNumber;
         }
+
+        if (hud && hud->isVisible())
+            hud->addStageTime(PerformanceHud::Gutter, timer.nsecsElapsed());
     }
 }
 
+void TextEditor::lineNumberAreaMousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || event->x() < lineNumberArea->width() - foldAreaWidth())
+        return;
+
+    QTextBlock block = cursorForPosition(QPoint(0, event->y())).block();
+    const BlockData *data = static_cast<const BlockData*>(block.userData());
+    if ((data && data->isFolded) || CodeFolding::isFoldStart(block))
+        toggleFold(block);
+}
+
 int TextEditor::lineNumberAreaWidth() {
     int digits = 1;
 
@@ -75,11 +185,12 @@ int TextEditor::lineNumberAreaWidth() {
         ++digits;
     }
 
-    // Умножаем размер символа на количество символов
-    return (2 + fontMetrics().averageCharWidth()) * digits;
+    // Умножаем размер символа на количество символов и добавляем столбец маркеров сворачивания
+    return (2 + fontMetrics().averageCharWidth()) * digits + foldAreaWidth();
 }
 
 void TextEditor::replaceSearch(QString oldString, QString newString) {
+    TraceScope trace("TextEditor::replaceSearch");
     int count = this->toPlainText().count(oldString);
     QString string = this->toPlainText().replace(oldString, newString);
     this->selectAll();
@@ -121,6 +232,127 @@ QLabel* TextEditor::getCursorPos() {
     return cursorPos;
 };
 
+void TextEditor::setLineFilter(const QString &pattern) {
+    lineFilterPattern = pattern;
+    if (pattern.isEmpty()) {
+        lineFilter->cancel();
+        applyLineFilter(QBitArray());
+        return;
+    }
+
+    lineFilter->start(document(), pattern);
+}
+
+bool TextEditor::isLineFilterActive() const {
+    return !lineFilterPattern.isEmpty();
+}
+
+void TextEditor::toggleFold(const QTextBlock &block) {
+    BlockData *data = BlockData::get(block);
+    QVector<QTextBlock> shown;
+
+    if (data->isFolded) {
+        // Скрытые строки свернутого фрагмента идут подряд сразу за его первой строкой.
+        // Вложенные свернутые фрагменты остаются свернутыми.
+        data->isFolded = false;
+        FoldRanges::forDocument(document())->remove(block);
+        QTextBlock current = block.next();
+        while (current.isValid() && BlockData::get(current)->isFoldHidden) {
+            BlockData *currentData = BlockData::get(current);
+            currentData->isFoldHidden = false;
+            if (updateBlockVisible(current))
+                shown.append(current);
+
+            QTextBlock innerEnd = currentData->isFolded ? CodeFolding::foldEnd(current) : QTextBlock();
+            current = innerEnd.isValid() ? innerEnd.next() : current.next();
+        }
+    } else {
+        QTextBlock end = CodeFolding::foldEnd(block);
+        if (!end.isValid())
+            return;
+
+        data->isFolded = true;
+        FoldRanges::forDocument(document())->add(block, end);
+        const int last = end.blockNumber();
+        for (QTextBlock current = block.next(); current.isValid() && current.blockNumber() <= last;
+             current = current.next()) {
+            BlockData::get(current)->isFoldHidden = true;
+            updateBlockVisible(current);
+        }
+
+        // Курсор из свернутого фрагмента переносится в конец его первой строки.
+        if (!textCursor().block().isVisible()) {
+            QTextCursor cursor(block);
+            cursor.movePosition(QTextCursor::EndOfBlock);
+            setTextCursor(cursor);
+        }
+    }
+
+    updateBlockVisibility();
+    rehighlightBlocks(shown);
+    startRelayout(firstVisibleBlock().blockNumber());
+}
+
+void TextEditor::setMinimapVisible(bool visible) {
+    isMinimapVisible = visible;
+    minimap->setVisible(visible);
+    updateLineNumberAreaWidth();
+    if (visible)
+        updateMinimap();
+}
+
+void TextEditor::setHudVisible(bool visible) {
+    if (visible && !hud) {
+        hud = new PerformanceHud(this);
+        hud->raise();
+        updateOverlayGeometry();
+        takeHighlightTime();
+    }
+    if (hud)
+        hud->setVisible(visible);
+}
+
+PerformanceHud* TextEditor::getPerformanceHud() {
+    return hud;
+}
+
+qint64 TextEditor::takeHighlightTime() {
+    const Highlighter *highlighter = document()->findChild<Highlighter*>();
+    if (!highlighter)
+        return 0;
+    const qint64 elapsed = highlighter->getHighlightTime() - hudHighlightTime;
+    hudHighlightTime = highlighter->getHighlightTime();
+    return elapsed;
+}
+
+void TextEditor::hudFramePainted(qint64 paintTime) {
+    if (!hud || !hud->isVisible())
+        return;
+    hud->addStageTime(PerformanceHud::Highlight, takeHighlightTime());
+    hud->framePainted(paintTime);
+}
+
+void TextEditor::setWordWrap(bool wrap) {
+    QTextOption::WrapMode mode = wrap ? QTextOption::WrapAtWordBoundaryOrAnywhere : QTextOption::NoWrap;
+    if (wordWrapMode() == mode)
+        return;
+
+    // Смена режима только сбрасывает разметку блоков (каждый считается одной строкой),
+    // видимые блоки размечаются при отрисовке.
+    int top = firstVisibleBlock().blockNumber();
+    setWordWrapMode(mode);
+    startRelayout(top);
+}
+
+void TextEditor::setEditorFont(const QFont &font) {
+    int top = firstVisibleBlock().blockNumber();
+    setFont(font);
+
+    // Табуляция в 4 символа нового шрифта.
+    setTabStopDistance(fontMetrics().averageCharWidth() * 4);
+    startRelayout(top);
+}
+
 // Дополнение стандартного контекстного меню.
 void TextEditor::contextMenuEvent(QContextMenuEvent *event) {
 
@@ -158,6 +390,186 @@ void TextEditor::resizeEvent(QResizeEvent *event) {
 
     QRect cr = contentsRect();
     lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+    updateOverlayGeometry();
+}
+
+void TextEditor::keyPressEvent(QKeyEvent *event) {
+    const bool isHudActive = hud && hud->isVisible();
+    if (isHudActive)
+        hud->keyPressed();
+
+    // Клавиши выбора варианта обрабатывает список вариантов.
+    if (completer->popup()->isVisible()) {
+        switch (event->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+        case Qt::Key_Escape:
+            event->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Подсветка, начатая изменением документа, засчитывается отдельно; остальное время
+    // обработки клавиши редактором - разметка измененных строк.
+    const qint64 highlightTime = isHudActive ? takeHighlightTime() : 0;
+    QPlainTextEdit::keyPressEvent(event);
+    if (isHudActive) {
+        const qint64 keyHighlightTime = takeHighlightTime();
+        hud->addStageTime(PerformanceHud::Highlight, highlightTime + keyHighlightTime);
+        hud->addStageTime(PerformanceHud::Layout, timer.nsecsElapsed() - keyHighlightTime);
+    }
+
+    if (event->text().isEmpty() || (event->modifiers() & (Qt::ControlModifier | Qt::AltModifier))) {
+        completer->popup()->hide();
+        return;
+    }
+
+    updateCompletion();
+}
+
+void TextEditor::paintEvent(QPaintEvent *event) {
+    TraceScope trace("TextEditor::paintEvent");
+    QElapsedTimer timer;
+    timer.start();
+
+    // Заглушка пустого документа и режим замены рисуются стандартным способом.
+    if (overwriteMode() || (document()->isEmpty() && !placeholderText().isEmpty())) {
+        QPlainTextEdit::paintEvent(event);
+        hudFramePainted(timer.nsecsElapsed());
+        return;
+    }
+
+    QPainter painter(viewport());
+
+    QPointF offset(contentOffset());
+    QRect er = event->rect();
+    QRect viewportRect = viewport()->rect();
+    bool editable = !isReadOnly();
+
+    QTextBlock block = firstVisibleBlock();
+    qreal maximumWidth = document()->documentLayout()->documentSize().width();
+
+    painter.setBrushOrigin(offset);
+
+    // Правое поле не закрашивается выделением на всю ширину.
+    int maxX = offset.x() + qMax((qreal)viewportRect.width(), maximumWidth)
+               - document()->documentMargin();
+    er.setRight(qMin(er.right(), maxX));
+    painter.setClipRect(er);
+
+    QAbstractTextDocumentLayout::PaintContext context = getPaintContext();
+    painter.setPen(context.palette.text().color());
+    monospacePainter.setFont(font());
+    const qint64 fastBlocks = monospacePainter.getFastBlockCount();
+    const qint64 slowBlocks = monospacePainter.getSlowBlockCount();
+
+    // В режиме малой памяти строки на экране учитываются в бюджете разметки, а строки
+    // с выгруженными форматами подсвечиваются заново после отрисовки.
+    LayoutBudget *layoutBudget = LayoutBudget::forDocument(document());
+    const bool isBudgetEnabled = layoutBudget->isEnabled();
+    bool hasReleasedBlocks = false;
+    const int firstShown = block.blockNumber();
+    int lastShown = firstShown;
+
+    while (block.isValid()) {
+        if (!block.isVisible()) {
+            block = nextVisibleBlock(block);
+            continue;
+        }
+
+        QRectF r = blockBoundingRect(block).translated(offset);
+        QTextLayout *layout = block.layout();
+        if (isBudgetEnabled) {
+            lastShown = block.blockNumber();
+            layoutBudget->blockShown(block);
+            const BlockData *data = static_cast<const BlockData*>(block.userData());
+            hasReleasedBlocks = hasReleasedBlocks || (data && data->isHighlightSkipped);
+        }
+
+        if (r.bottom() >= er.top() && r.top() <= er.bottom()) {
+            QBrush bg = block.blockFormat().background();
+            if (bg != Qt::NoBrush) {
+                QRectF contentsRect = r;
+                contentsRect.setWidth(qMax(r.width(), maximumWidth));
+                painter.fillRect(contentsRect, bg);
+            }
+
+            // Выделения (в том числе дополнительные) в координатах блока.
+            QVector<QTextLayout::FormatRange> selections;
+            int blpos = block.position();
+            int bllen = block.length();
+            for (int i = 0; i < context.selections.size(); ++i) {
+                const QAbstractTextDocumentLayout::Selection &range = context.selections.at(i);
+                const int selStart = range.cursor.selectionStart() - blpos;
+                const int selEnd = range.cursor.selectionEnd() - blpos;
+                if (selStart < bllen && selEnd > 0 && selEnd > selStart) {
+                    QTextLayout::FormatRange o;
+                    o.start = selStart;
+                    o.length = selEnd - selStart;
+                    o.format = range.format;
+                    selections.append(o);
+                } else if (!range.cursor.hasSelection()
+                           && range.format.hasProperty(QTextFormat::FullWidthSelection)
+                           && block.contains(range.cursor.position())) {
+                    // Для выделения на всю ширину достаточно позиции курсора в строке.
+                    QTextLayout::FormatRange o;
+                    QTextLine l = layout->lineForTextPosition(range.cursor.position() - blpos);
+                    o.start = l.textStart();
+                    o.length = l.textLength();
+                    if (o.start + o.length == bllen - 1)
+                        ++o.length;
+                    o.format = range.format;
+                    selections.append(o);
+                }
+            }
+
+            bool drawCursor = ((editable || (textInteractionFlags() & Qt::TextSelectableByKeyboard))
+                               && context.cursorPosition >= blpos
+                               && context.cursorPosition < blpos + bllen);
+
+            if (!monospacePainter.drawBlock(&painter, block, offset, selections, er,
+                                            context.palette.text().color()))
+                layout->draw(&painter, offset, selections, er);
+
+            if (drawCursor
+                || (editable && context.cursorPosition < -1
+                    && !layout->preeditAreaText().isEmpty())) {
+                int cpos = context.cursorPosition;
+                if (cpos < -1)
+                    cpos = layout->preeditAreaPosition() - (cpos + 2);
+                else
+                    cpos -= blpos;
+                layout->drawCursor(&painter, offset, cpos, cursorWidth());
+            }
+        }
+
+        offset.ry() += r.height();
+        if (offset.y() > viewportRect.height())
+            break;
+        block = block.next();
+    }
+
+    if (backgroundVisible() && !block.isValid() && offset.y() <= er.bottom()
+        && (centerOnScroll() || verticalScrollBar()->maximum() == verticalScrollBar()->minimum())) {
+        painter.fillRect(QRect(QPoint((int)er.left(), (int)offset.y()), er.bottomRight()), palette().window());
+    }
+
+    if (isBudgetEnabled)
+        layoutBudget->setShownRange(this, firstShown, lastShown);
+    if (hasReleasedBlocks)
+        QTimer::singleShot(0, this, &TextEditor::restoreReleasedBlocks);
+
+    if (hud && hud->isVisible())
+        hud->addPaintedBlocks(int(monospacePainter.getFastBlockCount() - fastBlocks),
+                              int(monospacePainter.getSlowBlockCount() - slowBlocks));
+    hudFramePainted(timer.nsecsElapsed());
 }
 
 void TextEditor::maybeCopy(bool yes) {
@@ -185,11 +597,28 @@ void TextEditor::selectString() {
 // Обновление ширины области нумерации.
 void TextEditor::updateLineNumberAreaWidth(int newBlockCount) {
     Q_UNUSED(newBlockCount)
+    const int right = isMinimapVisible ? minimap->sizeHint().width() : 0;
     if (isLineNumberingActive) {
-        setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+        setViewportMargins(lineNumberAreaWidth(), 0, right, 0);
     } else {
-        setViewportMargins(0, 0, 0, 0);
+        setViewportMargins(0, 0, right, 0);
     }
+    updateOverlayGeometry();
+}
+
+// При вставке многострочного текста количество блоков меняется много раз подряд,
+// ширина области нумерации пересчитывается один раз за кадр.
+void TextEditor::scheduleLineNumberAreaWidthUpdate() {
+    UpdateScheduler::instance()->markDirty(UpdateScheduler::Gutter, this, [this]() {
+        updateLineNumberAreaWidth();
+    });
+}
+
+// При быстром наборе и автоповторе курсор перемещается чаще, чем обновляется экран.
+void TextEditor::scheduleCurrentLineUpdate() {
+    UpdateScheduler::instance()->markDirty(UpdateScheduler::Cursor, this, [this]() {
+        highlightCurrentLine();
+    });
 }
 
 // При изменении положения курсора мы выделяем текущую строку, то есть строку, содержащую курсор.
@@ -211,6 +640,19 @@ void TextEditor::highlightCurrentLine() {
         extraSelections.append(selection);
     }
 
+    // Подсветка скобки у курсора и парной к ней.
+    int position, match;
+    if (findBracketPair(position, match)) {
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(QColor(Qt::green).lighter(160));
+        for (int bracket : { position, match }) {
+            selection.cursor = QTextCursor(document());
+            selection.cursor.setPosition(bracket);
+            selection.cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+            extraSelections.append(selection);
+        }
+    }
+
     setExtraSelections(extraSelections);
 
     cursorPos->setText(
@@ -229,5 +671,390 @@ void TextEditor::updateLineNumberArea(const QRect &rect, int dy) {
         lineNumberArea->update(0, rect.y(), lineNumberArea->width(), rect.height());
 
     if (rect.contains(viewport()->rect()))
-        updateLineNumberAreaWidth();
+        scheduleLineNumberAreaWidthUpdate();
+
+    // Мигание курсора и перерисовка части строки видимые строки не меняют.
+    if (isMinimapVisible && (dy || rect.contains(viewport()->rect()) || document()->revision() != minimapRevision))
+        updateMinimap();
+}
+
+void TextEditor::applyLineFilter(const QBitArray &matches) {
+    // Пока считался фильтр, документ изменился - отбор повторяется по новому тексту.
+    if (isLineFilterActive() && matches.size() != blockCount()) {
+        setLineFilter(lineFilterPattern);
+        return;
+    }
+
+    QVector<QTextBlock> shown;
+    QTextBlock block = document()->firstBlock();
+    int i = 0;
+    while (block.isValid()) {
+        BlockData::get(block)->isFilteredOut = isLineFilterActive() && !matches.testBit(i);
+        if (updateBlockVisible(block))
+            shown.append(block);
+        block = block.next();
+        ++i;
+    }
+
+    updateBlockVisibility();
+    rehighlightBlocks(shown);
+
+    // Показанные снова строки считаются однострочными, пока не будут размечены.
+    startRelayout(firstVisibleBlock().blockNumber());
+}
+
+QTextBlock TextEditor::nextVisibleBlock(const QTextBlock &block) const {
+    QTextBlock next = document()->findBlockByLineNumber(block.firstLineNumber() + block.lineCount());
+    if (next.isValid() && next.blockNumber() <= block.blockNumber())
+        return block.next();
+    return next;
+}
+
+void TextEditor::updateBlockVisibility() {
+    // Число строк документа уже пересчитано setLineCount, остается обновить полосы прокрутки и экран.
+    QPlainTextDocumentLayout *layout = qobject_cast<QPlainTextDocumentLayout*>(document()->documentLayout());
+    emit layout->documentSizeChanged(layout->documentSize());
+    layout->requestUpdate();
+
+    if (!textCursor().block().isVisible())
+        ensureCursorVisible();
+    viewport()->update();
+    lineNumberArea->update();
+}
+
+bool TextEditor::updateBlockVisible(QTextBlock block) {
+    BlockData *data = BlockData::get(block);
+    bool visible = !data->isFilteredOut && !data->isFoldHidden;
+    if (block.isVisible() == visible)
+        return false;
+
+    block.setVisible(visible);
+    block.setLineCount(visible ? 1 : 0);
+    block.clearLayout();
+    return visible && data->isHighlightSkipped;
+}
+
+void TextEditor::rehighlightBlocks(const QVector<QTextBlock> &blocks) {
+    Highlighter *highlighter = document()->findChild<Highlighter*>();
+    if (!highlighter)
+        return;
+
+    for (const QTextBlock &block : blocks)
+        highlighter->rehighlightBlock(block);
+}
+
+int TextEditor::foldAreaWidth() const {
+    return fontMetrics().height();
+}
+
+bool TextEditor::findBracketPair(int &position, int &match) const {
+    BracketIndex *index = BracketIndex::forDocument(document());
+    position = textCursor().position();
+    match = index->matchingBracket(position);
+    if (match < 0 && position > 0) {
+        --position;
+        match = index->matchingBracket(position);
+    }
+    return match >= 0;
+}
+
+void TextEditor::jumpToMatchingBracket() {
+    int position, match;
+    if (!findBracketPair(position, match))
+        return;
+
+    // Пара внутри свернутого фрагмента или отброшенная фильтром не показывается.
+    if (!document()->findBlock(match).isVisible())
+        return;
+
+    // Курсор встает с той же стороны от скобки, с какой стоял у исходной.
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(position == cursor.position() ? match : match + 1);
+    setTextCursor(cursor);
+}
+
+void TextEditor::updateMinimap() {
+    // Изменения строк миникарта отслеживает сама, здесь обновляется только видимый диапазон.
+    minimapRevision = document()->revision();
+    const int first = firstVisibleBlock().blockNumber();
+    const int last = cursorForPosition(QPoint(0, viewport()->height() - 1)).blockNumber();
+    minimap->setVisibleRange(first, qMax(first, last));
+}
+
+void TextEditor::updateMinimapColors() {
+    // Обычный текст рисуется цветом между цветом текста и фоном, лексемы - цветами стиля.
+    const QColor text = palette().text().color();
+    const QColor plain((text.red() + backgroundColor.red()) / 2, (text.green() + backgroundColor.green()) / 2,
+                       (text.blue() + backgroundColor.blue()) / 2);
+    QVector<QRgb> colors(BlockData::TokenClassCount, plain.rgb());
+    colors[BlockData::NoToken] = backgroundColor.rgb();
+    if (Highlighter *highlighter = document()->findChild<Highlighter*>()) {
+        for (int tokenClass = BlockData::KeywordToken; tokenClass < BlockData::TokenClassCount; ++tokenClass) {
+            const QColor color = highlighter->tokenColor(tokenClass);
+            if (color.isValid())
+                colors[tokenClass] = color.rgb();
+        }
+    }
+    minimap->setColors(colors, backgroundColor.rgb());
+}
+
+void TextEditor::changeEvent(QEvent *event) {
+    QPlainTextEdit::changeEvent(event);
+    // Палитра задается и в конструкторе, до создания миникарты.
+    if (event->type() == QEvent::PaletteChange && minimap)
+        updateMinimapColors();
+}
+
+void TextEditor::updateOverlayGeometry() {
+    const QRect rect = viewport()->geometry();
+    minimap->setGeometry(QRect(rect.right() + 1, rect.top(), minimap->sizeHint().width(), rect.height()));
+
+    // Наложение - потомок редактора, а не области текста: viewport()->scroll() его не сдвигает.
+    if (hud)
+        hud->move(rect.right() + 1 - hud->width(), rect.top());
+}
+
+void TextEditor::setSharedDocument(QTextDocument *shared) {
+    if (shared == document())
+        return;
+
+    disconnect(ModifiedLines::forDocument(document()), nullptr, this, nullptr);
+    disconnect(FoldRanges::forDocument(document()), nullptr, this, nullptr);
+    LayoutBudget::forDocument(document())->removeView(this);
+    relayoutTimer.stop();
+    relayoutBlockNumber = -1;
+    highlightTimer.stop();
+    highlightBlockNumber = -1;
+
+    // Собственный документ представления удаляется QPlainTextEdit, общий остается у владельца.
+    // Шрифт и табуляция хранятся в документе и задаются его владельцем, представление их не меняет.
+    setDocument(shared);
+    minimap->setDocument(shared);
+    minimapRevision = -1;
+    updateMinimapColors();
+    scrollBarMarkers->clear(ScrollBarMarkers::SearchHit);
+    connectDocument();
+
+    updateLineNumberAreaWidth();
+    highlightCurrentLine();
+}
+
+void TextEditor::connectDocument() {
+    connect(ModifiedLines::forDocument(document()), &ModifiedLines::binsChanged,
+            this, &TextEditor::updateModifiedMarkers);
+    updateModifiedMarkers();
+    connect(FoldRanges::forDocument(document()), &FoldRanges::foldsReleased,
+            this, &TextEditor::releaseFolds, Qt::QueuedConnection);
+
+    // Индекс идентификаторов создается заранее, чтобы первый показ списка не строил его.
+    IdentifierIndex::forDocument(document());
+
+    // Удаленный текст для оценки истории отмены учитывается с подключения документа.
+    MemoryUsage::forDocument(document());
+}
+
+ScrollBarMarkers* TextEditor::getScrollBarMarkers() {
+    return scrollBarMarkers;
+}
+
+qint64 TextEditor::cacheMemoryUsage() const {
+    return gutterRenderer.memoryUsage() + minimap->memoryUsage();
+}
+
+void TextEditor::updateModifiedMarkers() {
+    scrollBarMarkers->setBins(ScrollBarMarkers::Modified, ModifiedLines::forDocument(document())->getBins());
+}
+
+void TextEditor::releaseFolds() {
+    // Видимость строк общая для всех представлений документа: строки показывает первое из них.
+    const QVector<QTextBlock> released = FoldRanges::forDocument(document())->takeReleased();
+    if (released.isEmpty())
+        return;
+
+    QVector<QTextBlock> shown;
+    for (const QTextBlock &block : released) {
+        if (updateBlockVisible(block))
+            shown.append(block);
+    }
+
+    updateBlockVisibility();
+    rehighlightBlocks(shown);
+    startRelayout(firstVisibleBlock().blockNumber());
+}
+
+void TextEditor::scrollToLine(int line) {
+    QTextBlock block = document()->findBlockByNumber(line);
+    if (!block.isValid())
+        return;
+    verticalScrollBar()->setValue(block.firstLineNumber() - verticalScrollBar()->pageStep() / 2);
+}
+
+void TextEditor::updateCompletion() {
+    QTextCursor cursor = textCursor();
+    const QString text = cursor.block().text();
+    const int end = cursor.positionInBlock();
+    int start = end;
+    while (start > 0 && (text.at(start - 1).isLetterOrNumber() || text.at(start - 1) == '_'))
+        --start;
+
+    const QString prefix = text.mid(start, end - start);
+    if (prefix.length() < CompletionPrefixLength || prefix.at(0).isDigit() || cursor.hasSelection()) {
+        completer->popup()->hide();
+        return;
+    }
+
+    const QStringList words = IdentifierIndex::forDocument(document())->complete(prefix, cursor.block(), MaxCompletions);
+    if (words.isEmpty()) {
+        completer->popup()->hide();
+        return;
+    }
+
+    completionModel->setStringList(words);
+    completer->setCompletionPrefix(prefix);
+
+    QRect rect = cursorRect();
+    rect.setWidth(completer->popup()->sizeHintForColumn(0)
+                  + completer->popup()->verticalScrollBar()->sizeHint().width());
+    completer->complete(rect);
+    completer->popup()->setCurrentIndex(completionModel->index(0));
+}
+
+void TextEditor::insertCompletion(const QString &word) {
+    if (completer->widget() != this)
+        return;
+
+    QTextCursor cursor = textCursor();
+    cursor.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor, completer->completionPrefix().length());
+    cursor.insertText(word);
+    setTextCursor(cursor);
+}
+
+void TextEditor::highlightSkippedBlocks() {
+    // Видимые строки подсвечиваются сразу, до возврата в цикл событий.
+    highlightVisibleBlocks();
+
+    highlightBlockNumber = 0;
+    highlightTimer.start();
+}
+
+bool TextEditor::isHighlightPending() const {
+    return highlightBlockNumber >= 0;
+}
+
+void TextEditor::highlightVisibleBlocks() {
+    QVector<QTextBlock> shown;
+    const int bottom = viewport()->height();
+    for (QTextBlock block = firstVisibleBlock(); block.isValid(); block = nextVisibleBlock(block)) {
+        const BlockData *data = static_cast<const BlockData*>(block.userData());
+        if (data && data->isHighlightSkipped && block.isVisible())
+            shown.append(block);
+        if (blockBoundingGeometry(block).translated(contentOffset()).top() > bottom)
+            break;
+    }
+    rehighlightBlocks(shown);
+}
+
+void TextEditor::restoreReleasedBlocks() {
+    // Во время первого прохода подсветки видимые строки подсвечиваются по его окончании.
+    const Highlighter *highlighter = document()->findChild<Highlighter*>();
+    if (!highlighter || highlighter->isDeferredPass() || !LayoutBudget::forDocument(document())->isEnabled())
+        return;
+    highlightVisibleBlocks();
+}
+
+void TextEditor::highlightStep() {
+    Highlighter *highlighter = document()->findChild<Highlighter*>();
+    QTextBlock block = document()->findBlockByNumber(highlightBlockNumber);
+    if (!highlighter || !block.isValid()) {
+        highlightTimer.stop();
+        highlightBlockNumber = -1;
+        return;
+    }
+
+    // Скрытые строки остаются пропущенными: они подсвечиваются при показе.
+    QElapsedTimer timer;
+    timer.start();
+    while (block.isValid() && timer.elapsed() < HighlightSlice) {
+        const BlockData *data = static_cast<const BlockData*>(block.userData());
+        if (data && data->isHighlightSkipped && block.isVisible())
+            highlighter->rehighlightBlock(block);
+        block = block.next();
+    }
+
+    if (block.isValid()) {
+        highlightBlockNumber = block.blockNumber();
+    } else {
+        highlightTimer.stop();
+        highlightBlockNumber = -1;
+    }
+}
+
+void TextEditor::startRelayout(int topBlockNumber) {
+    // Возврат к прежней верхней строке: номер строки прокрутки у нее изменился.
+    QTextBlock top = document()->findBlockByNumber(topBlockNumber);
+    if (top.isValid() && top.isVisible())
+        verticalScrollBar()->setValue(top.firstLineNumber());
+
+    // Без переноса каждый блок - ровно одна строка, уточнять нечего.
+    if (wordWrapMode() == QTextOption::NoWrap) {
+        relayoutTimer.stop();
+        relayoutBlockNumber = -1;
+        return;
+    }
+
+    // Размечаются только строки экрана и по экрану выше и ниже него.
+    const int pageBlocks = qMax(1, viewport()->height() / fontMetrics().lineSpacing());
+    relayoutFirst = topBlockNumber - pageBlocks;
+    relayoutLast = topBlockNumber + 2 * pageBlocks;
+    relayoutBlockNumber = 0;
+    relayoutTimer.start();
+}
+
+int TextEditor::estimatedLineCount(const QTextBlock &block, int lineWidth, int charWidth) {
+    // Точное число строк получится при разметке блока, когда он окажется на экране.
+    const int width = (block.length() - 1) * charWidth;
+    return qMax(1, (width + lineWidth - 1) / lineWidth);
+}
+
+void TextEditor::relayoutStep() {
+    QElapsedTimer timer;
+    timer.start();
+
+    QAbstractTextDocumentLayout *layout = document()->documentLayout();
+    QTextBlock block = document()->findBlockByNumber(relayoutBlockNumber);
+    if (block.isValid() && !block.isVisible())
+        block = nextVisibleBlock(block);
+
+    // Блоки рядом с экраном размечаются: blockBoundingRect размечает блок, если его разметка была
+    // сброшена, и сохраняет число строк; созданная разметка учитывается в бюджете режима малой памяти.
+    // Для остальных блоков без разметки число строк оценивается по длине текста без разметки.
+    LayoutBudget *layoutBudget = LayoutBudget::forDocument(document());
+    const bool isBudgetEnabled = layoutBudget->isEnabled();
+    const int lineWidth = qMax(1, viewport()->width() - 2 * int(document()->documentMargin()));
+    const int charWidth = fontMetrics().averageCharWidth();
+    while (block.isValid() && timer.elapsed() < RelayoutSlice) {
+        const int number = block.blockNumber();
+        if (number >= relayoutFirst && number <= relayoutLast) {
+            layout->blockBoundingRect(block);
+            if (isBudgetEnabled)
+                layoutBudget->blockLaidOut(block);
+        } else if (block.layout()->lineCount() == 0) {
+            block.setLineCount(estimatedLineCount(block, lineWidth, charWidth));
+        }
+        block = nextVisibleBlock(block);
+    }
+
+    // Полоса прокрутки пересчитывается по уточненному числу строк,
+    // верхняя видимая строка при этом сохраняется.
+    emit layout->documentSizeChanged(layout->documentSize());
+
+    if (block.isValid()) {
+        relayoutBlockNumber = block.blockNumber();
+    } else {
+        relayoutTimer.stop();
+        relayoutBlockNumber = -1;
+    }
+
+    if (hud && hud->isVisible())
+        hud->addStageTime(PerformanceHud::Layout, timer.nsecsElapsed());
 }
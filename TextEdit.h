@@ -4,6 +4,21 @@
 #endif // TEXTEDIT_H
 
 #include "HighLighter.h"
+#include "LineFilter.h"
+#include "UpdateScheduler.h"
+#include "GutterRenderer.h"
+#include "MonospacePainter.h"
+#include "CodeFolding.h"
+#include "FoldRanges.h"
+#include "BracketIndex.h"
+#include "IdentifierIndex.h"
+#include "Minimap.h"
+#include "ScrollBarMarkers.h"
+#include "ModifiedLines.h"
+#include "MemoryUsage.h"
+#include "LayoutBudget.h"
+#include "PerformanceHud.h"
+#include "Trace.h"
 
 #include <QPlainTextEdit>
 #include <QMouseEvent>
@@ -16,6 +31,11 @@
 #include <QWidget>
 #include <QTextBlock>
 #include <QLabel>
+#include <QBitArray>
+#include <QTimer>
+#include <QCompleter>
+#include <QStringListModel>
+#include <QKeyEvent>
 
 class LineNumberArea;
 
@@ -25,9 +45,14 @@ class TextEditor : public QPlainTextEdit {
 public:
     TextEditor(QWidget *parent = nullptr);
 
+    ~TextEditor();
+
     // Вызывается от LineNumberArea всякий раз, когда тот получает событие paint.
     void lineNumberAreaPaintEvent(QPaintEvent *event);
 
+    // Щелчок по маркеру в области нумерации сворачивает или разворачивает фрагмент.
+    void lineNumberAreaMousePressEvent(QMouseEvent *event);
+
     // Вычисление ширины области нумерации.
     // Количество цифр в последней строке редактора умножается на максимальную ширину цифры.
     int lineNumberAreaWidth();
@@ -46,6 +71,53 @@ public:
 
     QLabel* getCursorPos();
 
+    // Режим фильтра: отображаются только строки, содержащие pattern, с исходными номерами строк.
+    // Пустой pattern выключает фильтр.
+    void setLineFilter(const QString &pattern);
+
+    bool isLineFilterActive() const;
+
+    // Перенос строк и шрифт меняются без синхронной разметки всего документа:
+    // сразу размечаются только видимые строки, высоты остальных уточняются в фоне.
+    void setWordWrap(bool wrap);
+
+    void setEditorFont(const QFont &font);
+
+    // Свернутые строки скрываются целиком: они не размечаются, не рисуются и не подсвечиваются.
+    void toggleFold(const QTextBlock &block);
+
+    // Миникарта справа от текста.
+    void setMinimapVisible(bool visible);
+
+    // Цвета лексем миникарты по стилю подсветки; вызывается при смене стиля.
+    void updateMinimapColors();
+
+    // Отметки совпадений поиска и измененных строк на полосе прокрутки.
+    ScrollBarMarkers* getScrollBarMarkers();
+
+    // Память кэшей редактора (атлас цифр, плитки миникарты), байт.
+    qint64 cacheMemoryUsage() const;
+
+    // Наложение с задержками ввода и временем этапов отрисовки; создается при первом показе.
+    void setHudVisible(bool visible);
+
+    // nullptr, пока наложение не было показано.
+    PerformanceHud* getPerformanceHud();
+
+    // Еще одно представление документа другого редактора: текст, подсветка и индексы общие,
+    // свои у представления только курсор, прокрутка, область нумерации и выделение строки.
+    void setSharedDocument(QTextDocument *shared);
+
+    // Фоновая подсветка пропущенных строк еще не дошла до конца документа.
+    bool isHighlightPending() const;
+
+public slots:
+    // Переход к скобке, парной к скобке у курсора.
+    void jumpToMatchingBracket();
+
+    // Подсветка строк, пропущенных подсветкой: сначала видимых, остальных - в фоне порциями.
+    void highlightSkippedBlocks();
+
 protected:
     // Дополнение стандартного контекстного меню.
     void contextMenuEvent(QContextMenuEvent *event) override;
@@ -53,6 +125,16 @@ protected:
     // Когда размер редактора изменяется, нам также нужно изменить размер области номера строки.
     void resizeEvent(QResizeEvent *event) override;
 
+    // После ввода символа предлагаются идентификаторы документа, начинающиеся с набранного префикса.
+    void keyPressEvent(QKeyEvent *event) override;
+
+    // Повторяет QPlainTextEdit::paintEvent, но скрытые блоки пропускает целиком,
+    // не вычисляя их геометрию (иначе каждый скрытый блок размечался бы при отрисовке).
+    void paintEvent(QPaintEvent *event) override;
+
+    // Смена палитры (цвета фона) меняет цвета миникарты.
+    void changeEvent(QEvent *event) override;
+
 private slots:
     void maybeCopy(bool yes);
 
@@ -67,6 +149,11 @@ private slots:
     // Обновление ширины области нумерации.
     void updateLineNumberAreaWidth(int newBlockCount = 0);
 
+    // Отложенные обновления: выполняются планировщиком один раз за кадр.
+    void scheduleLineNumberAreaWidthUpdate();
+
+    void scheduleCurrentLineUpdate();
+
     // При изменении положения курсора мы выделяем текущую строку, то есть строку, содержащую курсор.
     // QPlainTextEdit дает возможность иметь более одного выбора одновременно.
     // Мы можем установить формат символов (QTextCharFormat) из этих выборок.
@@ -80,6 +167,85 @@ private slots:
     // dy содержит количество пикселей, прокручиваемых видом по вертикали.
     void updateLineNumberArea(const QRect &rect, int dy);
 
+    // Применение результата фонового отбора строк.
+    void applyLineFilter(const QBitArray &matches);
+
+    // Разметка очередной порции блоков, не дольше RelayoutSlice мс за вызов.
+    void relayoutStep();
+
+    // Подсветка очередной порции пропущенных строк, не дольше HighlightSlice мс за вызов.
+    void highlightStep();
+
+    // Подсветка видимых строк, форматы которых выгружены в режиме малой памяти.
+    void restoreReleasedBlocks();
+
+    // Замена набранного префикса выбранным вариантом.
+    void insertCompletion(const QString &word);
+
+    // Прокрутка, при которой строка line оказывается в середине экрана.
+    void scrollToLine(int line);
+
+    // Отметки строк, измененных с момента открытия или сохранения.
+    void updateModifiedMarkers();
+
+    // Показ строк фрагментов, развернутых правкой.
+    void releaseFolds();
+
+private:
+    // Следующий видимый блок за скрытым за O(log n): у скрытых блоков нулевое число строк.
+    QTextBlock nextVisibleBlock(const QTextBlock &block) const;
+
+    // Обновление документа после изменения видимости блоков.
+    void updateBlockVisibility();
+
+    // Видимость блока по фильтру и свернутым фрагментам.
+    // Возвращает true, если блок стал видимым, но был подсвечен не полностью.
+    bool updateBlockVisible(QTextBlock block);
+
+    // Полная подсветка строк, которые были скрыты при подсветке.
+    void rehighlightBlocks(const QVector<QTextBlock> &blocks);
+
+    // Подсветка пропущенных строк на экране.
+    void highlightVisibleBlocks();
+
+    // Ширина столбца маркеров сворачивания.
+    int foldAreaWidth() const;
+
+    // Скобка у курсора (справа, иначе слева) и парная к ней; false, если пары нет.
+    bool findBracketPair(int &position, int &match) const;
+
+    // Подключение к сигналам текущего документа.
+    void connectDocument();
+
+    // Видимые строки для миникарты.
+    void updateMinimap();
+
+    // Миникарта справа от области текста и наложение HUD в ее правом верхнем углу.
+    void updateOverlayGeometry();
+
+    // Показ или скрытие списка вариантов для префикса слева от курсора.
+    void updateCompletion();
+
+    // Время подсветки документа с прошлого вызова, нс.
+    qint64 takeHighlightTime();
+
+    // Кадр наложения: время подсветки с прошлого кадра и длительность отрисовки текста.
+    void hudFramePainted(qint64 paintTime);
+
+    static const int CompletionPrefixLength = 3;
+    static const int MaxCompletions = 20;
+
+    // Запуск фонового уточнения высот строк; верхняя видимая строка остается на месте.
+    // Размечаются только блоки вокруг экрана, высоты остальных оцениваются по длине текста.
+    void startRelayout(int topBlockNumber);
+
+    // Оценка числа строк блока без разметки при ширине строки lineWidth и средней ширине символа charWidth.
+    static int estimatedLineCount(const QTextBlock &block, int lineWidth, int charWidth);
+
+    static const int RelayoutSlice = 8;
+
+    static const int HighlightSlice = 8;
+
 private:
     QLabel *cursorPos;
 
@@ -89,6 +255,36 @@ private:
     QColor backgroundColor;
     QColor currentLineColor;
 
+    GutterRenderer gutterRenderer;
+    bool isGutterCacheEnabled;
+
+    MonospacePainter monospacePainter;
+
+    LineFilter *lineFilter;
+    QString lineFilterPattern;
+
+    QTimer relayoutTimer;
+    int relayoutBlockNumber;
+    // Номера блоков вокруг экрана, которые фоновое уточнение высот размечает.
+    int relayoutFirst;
+    int relayoutLast;
+
+    QTimer highlightTimer;
+    int highlightBlockNumber;
+
+    Minimap *minimap;
+    bool isMinimapVisible;
+    // Ревизия документа при последнем обновлении видимых строк миникарты.
+    int minimapRevision;
+
+    ScrollBarMarkers *scrollBarMarkers;
+
+    PerformanceHud *hud;
+    qint64 hudHighlightTime;
+
+    QCompleter *completer;
+    QStringListModel *completionModel;
+
     bool isLineNumberingActive;
     bool isSelection;
 };
@@ -111,6 +307,10 @@ protected:
         textEditor->lineNumberAreaPaintEvent(event);
     }
 
+    void mousePressEvent(QMouseEvent *event) override {
+        textEditor->lineNumberAreaMousePressEvent(event);
+    }
+
 private:
     TextEditor *textEditor;
 };
@@ -0,0 +1,92 @@
+QT       += core gui network
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11
+
+TARGET = LB_12
+
+# Tokenizer and style model are built as a separate static library (HighlightEngine.pro).
+LIBS += -L$$OUT_PWD -lHighlightEngine
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/HighlightEngine.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/libHighlightEngine.a
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    BatchHighlighter.cpp \
+    BlockData.cpp \
+    BracketIndex.cpp \
+    CodeFolding.cpp \
+    ColorListEditor.cpp \
+    DocumentStatistics.cpp \
+    DocumentTabs.cpp \
+    FileReplacer.cpp \
+    FoldRanges.cpp \
+    GutterRenderer.cpp \
+    HighLighter.cpp \
+    IdentifierIndex.cpp \
+    LayoutBudget.cpp \
+    LineFilter.cpp \
+    MemoryUsage.cpp \
+    Minimap.cpp \
+    ModifiedLines.cpp \
+    MonospacePainter.cpp \
+    PerformanceHud.cpp \
+    ScrollBarMarkers.cpp \
+    SearchResults.cpp \
+    SingleInstance.cpp \
+    StartupProfiler.cpp \
+    StyleCache.cpp \
+    SymbolIndex.cpp \
+    SymbolOutline.cpp \
+    TextEdit.cpp \
+    Trace.cpp \
+    UpdateScheduler.cpp \
+    main.cpp \
+    mainwindow.cpp
+
+HEADERS += \
+    BatchHighlighter.h \
+    BlockData.h \
+    BracketIndex.h \
+    CodeFolding.h \
+    ColorListEditor.h \
+    DocumentStatistics.h \
+    DocumentTabs.h \
+    FileReplacer.h \
+    FoldRanges.h \
+    GutterRenderer.h \
+    HighLighter.h \
+    IdentifierIndex.h \
+    LayoutBudget.h \
+    LineFilter.h \
+    MemoryUsage.h \
+    Minimap.h \
+    ModifiedLines.h \
+    MonospacePainter.h \
+    PerformanceHud.h \
+    ScrollBarMarkers.h \
+    SearchResults.h \
+    SingleInstance.h \
+    StartupProfiler.h \
+    StyleCache.h \
+    SymbolIndex.h \
+    SymbolOutline.h \
+    TextEdit.h \
+    Trace.h \
+    UpdateScheduler.h \
+    mainwindow.h
+
+FORMS += \
+    mainwindow.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+RESOURCES += \
+    Styles.qrc
@@ -0,0 +1,172 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+#include <QMutex>
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    qint64 start;
+    qint64 end;
+};
+
+// Буфер пишет только его поток; экспорт читает число записей head с барьером, поэтому
+// видит все записи до него. Запись, которую поток затирает во время экспорта, может попасть
+// в файл неполной - для диагностики это допустимо.
+struct TraceBuffer {
+    int threadId;
+    QString threadName;
+    QAtomicInteger<quint32> head;
+    TraceEvent events[Trace::BufferSize];
+};
+
+// Буфер потока отдается обратно при завершении потока.
+struct ThreadBufferOwner {
+    TraceBuffer *buffer = nullptr;
+
+    ~ThreadBufferOwner();
+};
+
+const QElapsedTimer& traceClock() {
+    static const QElapsedTimer timer = [] {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer;
+}
+
+QMutex& buffersMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+// Буферы в экспорте: работающих потоков и последних завершившихся.
+QVector<TraceBuffer*>& buffers() {
+    static QVector<TraceBuffer*> list;
+    return list;
+}
+
+// Буферы завершившихся потоков от старых к новым; все они есть и в buffers().
+QVector<TraceBuffer*>& retiredBuffers() {
+    static QVector<TraceBuffer*> list;
+    return list;
+}
+
+thread_local ThreadBufferOwner threadBuffer;
+
+TraceBuffer* createBuffer() {
+    static int threadCount = 0;
+    QMutexLocker locker(&buffersMutex());
+
+    // Новый поток получает буфер самого старого завершившегося, если их набралось больше нормы.
+    TraceBuffer *buffer = nullptr;
+    if (retiredBuffers().size() >= Trace::MaxRetiredBuffers) {
+        buffer = retiredBuffers().takeFirst();
+        buffers().removeOne(buffer);
+    } else {
+        buffer = new TraceBuffer;
+    }
+    buffer->head.storeRelaxed(0);
+
+    buffer->threadId = ++threadCount;
+    QThread *thread = QThread::currentThread();
+    buffer->threadName = thread->objectName();
+    if (buffer->threadName.isEmpty()) {
+        const bool isMain = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+        buffer->threadName = isMain ? QString("Main thread") : QString("Thread %1").arg(buffer->threadId);
+    }
+    buffers().append(buffer);
+    return buffer;
+}
+
+ThreadBufferOwner::~ThreadBufferOwner() {
+    if (!buffer)
+        return;
+
+    QMutexLocker locker(&buffersMutex());
+    retiredBuffers().append(buffer);
+    while (retiredBuffers().size() > Trace::MaxRetiredBuffers) {
+        TraceBuffer *oldest = retiredBuffers().takeFirst();
+        buffers().removeOne(oldest);
+        delete oldest;
+    }
+}
+
+QByteArray escaped(const QString &text) {
+    QByteArray result = text.toUtf8();
+    result.replace('\\', "\\\\").replace('"', "\\\"");
+    return result;
+}
+
+} // namespace
+
+QAtomicInt Trace::enabled(qgetenv("TEXTEDITOR_TRACE") == "1" ? 1 : 0);
+
+void Trace::setEnabled(bool isEnabled) {
+    enabled.storeRelaxed(isEnabled ? 1 : 0);
+}
+
+qint64 Trace::now() {
+    return traceClock().nsecsElapsed();
+}
+
+void Trace::record(const char *name, qint64 start, qint64 end) {
+    TraceBuffer *buffer = threadBuffer.buffer;
+    if (!buffer)
+        buffer = threadBuffer.buffer = createBuffer();
+
+    const quint32 head = buffer->head.loadRelaxed();
+    TraceEvent &event = buffer->events[head % BufferSize];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    buffer->head.storeRelease(head + 1);
+}
+
+bool Trace::exportJson(const QString &fileName, QString *errorMessage) {
+    // Пока собирается JSON, завершившиеся потоки не освобождают и не передают свои буферы.
+    QMutexLocker locker(&buffersMutex());
+    const QVector<TraceBuffer*> list = buffers();
+
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool isFirst = true;
+    auto append = [&json, &isFirst](const QByteArray &event) {
+        if (!isFirst)
+            json += ",\n";
+        json += event;
+        isFirst = false;
+    };
+
+    for (TraceBuffer *buffer : list) {
+        const QByteArray tid = QByteArray::number(buffer->threadId);
+        append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+               + ",\"args\":{\"name\":\"" + escaped(buffer->threadName) + "\"}}");
+
+        const quint32 head = buffer->head.loadAcquire();
+        const quint32 count = qMin(head, quint32(BufferSize));
+        for (quint32 i = head - count; i != head; ++i) {
+            const TraceEvent event = buffer->events[i % BufferSize];
+            if (!event.name || event.end < event.start)
+                continue;
+            append("{\"name\":\"" + QByteArray(event.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid
+                   + ",\"ts\":" + QByteArray::number(event.start / 1e3, 'f', 3)
+                   + ",\"dur\":" + QByteArray::number((event.end - event.start) / 1e3, 'f', 3) + "}");
+        }
+    }
+    json += "\n]}\n";
+    locker.unlock();
+
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        if (errorMessage)
+            *errorMessage = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QAtomicInt>
+#include <QString>
+
+// Трассировка горячих путей редактора в формате Chrome trace-event (chrome://tracing, Perfetto).
+// Каждый поток пишет интервалы в свой кольцевой буфер без блокировок; при переполнении
+// старые записи затираются, поэтому в экспорте остаются последние BufferSize интервалов
+// каждого потока. Буфер завершившегося потока остается в экспорте, но таких буферов хранится
+// не больше MaxRetiredBuffers: самый старый из них отдается новому потоку или освобождается.
+// Когда трассировка выключена, интервал стоит одного чтения флага.
+// Включается в меню View или переменной окружения TEXTEDITOR_TRACE=1.
+class Trace {
+public:
+    static bool isEnabled() {
+        return enabled.loadRelaxed() != 0;
+    }
+
+    static void setEnabled(bool isEnabled);
+
+    // Время от первого обращения к трассировке, нс; общее для всех потоков.
+    static qint64 now();
+
+    // Интервал [start, end) текущего потока; name - строковая константа.
+    static void record(const char *name, qint64 start, qint64 end);
+
+    // Запись буферов всех потоков в JSON; false и описание ошибки в errorMessage при ошибке.
+    static bool exportJson(const QString &fileName, QString *errorMessage = nullptr);
+
+    static const int BufferSize = 1 << 16;
+
+    // Буферы завершившихся потоков (например, потоков пула, простоявших без задач), оставленные для экспорта.
+    static const int MaxRetiredBuffers = 8;
+
+private:
+    static QAtomicInt enabled;
+};
+
+// Интервал от создания до разрушения объекта.
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : name(Trace::isEnabled() ? name : nullptr), start(this->name ? Trace::now() : 0) {}
+
+    ~TraceScope() {
+        if (name)
+            Trace::record(name, start, Trace::now());
+    }
+
+private:
+    TraceScope(const TraceScope &) = delete;
+    TraceScope& operator=(const TraceScope &) = delete;
+
+    const char *name;
+    qint64 start;
+};
+
+#endif // TRACE_H
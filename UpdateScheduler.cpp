@@ -0,0 +1,82 @@
+#include "UpdateScheduler.h"
+
+#include <QGuiApplication>
+#include <QScreen>
+
+UpdateScheduler::UpdateScheduler(QObject *parent) : QObject(parent) {
+    for (int i = 0; i < PartCount; ++i) {
+        requested[i] = 0;
+        flushed[i] = 0;
+    }
+
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &UpdateScheduler::flush);
+}
+
+UpdateScheduler* UpdateScheduler::instance() {
+    // Планировщик живет в главном потоке и удаляется вместе с приложением.
+    static QPointer<UpdateScheduler> scheduler;
+    if (!scheduler)
+        scheduler = new UpdateScheduler(QCoreApplication::instance());
+    return scheduler;
+}
+
+void UpdateScheduler::markDirty(Part part, QObject *receiver, std::function<void()> update) {
+    ++requested[part];
+
+    for (const Request &request : pending) {
+        if (request.part == part && request.receiver == receiver)
+            return;
+    }
+    pending.append({ part, receiver, update });
+
+    if (!timer.isActive()) {
+        // После паузы обновление выполняется сразу на следующей итерации цикла событий,
+        // при частых запросах - не раньше, чем через кадр после предыдущего.
+        int delay = 0;
+        if (lastFlush.isValid())
+            delay = qMax(qint64(0), frameInterval() - lastFlush.elapsed());
+        timer.start(int(delay));
+    }
+}
+
+void UpdateScheduler::discard(Part part, QObject *receiver) {
+    for (int i = 0; i < pending.size(); ++i) {
+        if (pending.at(i).part == part && pending.at(i).receiver == receiver) {
+            pending.remove(i);
+            return;
+        }
+    }
+}
+
+void UpdateScheduler::flush() {
+    timer.stop();
+    lastFlush.start();
+
+    // Обновления могут запросить новые - они попадут в следующий кадр.
+    QVector<Request> requests;
+    requests.swap(pending);
+
+    for (const Request &request : requests) {
+        if (request.receiver) {
+            ++flushed[request.part];
+            request.update();
+        }
+    }
+}
+
+qint64 UpdateScheduler::getRequestedCount(Part part) const {
+    return requested[part];
+}
+
+qint64 UpdateScheduler::getSuppressedCount(Part part) const {
+    return requested[part] - flushed[part];
+}
+
+int UpdateScheduler::frameInterval() const {
+    qreal rate = 60;
+    if (QScreen *screen = QGuiApplication::primaryScreen())
+        rate = qMax(qreal(1), screen->refreshRate());
+    return qMax(1, qRound(1000 / rate));
+}
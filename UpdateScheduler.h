@@ -0,0 +1,64 @@
+#ifndef UPDATESCHEDULER_H
+#define UPDATESCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <functional>
+
+// Общий планировщик обновлений интерфейса.
+// Части интерфейса (курсор, область нумерации, статистика, заголовок) помечаются устаревшими,
+// а обновляются не чаще одного раза за кадр экрана: повторные запросы в пределах кадра подавляются.
+class UpdateScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    enum Part {
+        Cursor,
+        Gutter,
+        Statistics,
+        Title,
+        PartCount
+    };
+
+    static UpdateScheduler* instance();
+
+    // Пометить часть receiver устаревшей; update будет вызван один раз при ближайшем обновлении кадра.
+    void markDirty(Part part, QObject *receiver, std::function<void()> update);
+
+    // Отменить запланированное обновление (значение уже выставлено напрямую).
+    void discard(Part part, QObject *receiver);
+
+    // Выполнить все запланированные обновления немедленно.
+    void flush();
+
+    qint64 getRequestedCount(Part part) const;
+
+    // Количество подавленных (избыточных) обновлений; показывается на наложении PerformanceHud.
+    qint64 getSuppressedCount(Part part) const;
+
+private:
+    UpdateScheduler(QObject *parent = nullptr);
+
+    // Длительность кадра по частоте обновления основного экрана.
+    int frameInterval() const;
+
+private:
+    struct Request {
+        Part part;
+        QPointer<QObject> receiver;
+        std::function<void()> update;
+    };
+    QVector<Request> pending;
+
+    QTimer timer;
+    QElapsedTimer lastFlush;
+
+    qint64 requested[PartCount];
+    qint64 flushed[PartCount];
+};
+
+#endif // UPDATESCHEDULER_H
@@ -1,23 +1,110 @@
 #include "mainwindow.h"
+#include "BatchHighlighter.h"
+#include "SingleInstance.h"
+#include "StartupProfiler.h"
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QFileInfo>
+#include <QThread>
 
 int main(int argc, char *argv[])
 {
+    // Отсчет времени запуска начинается с первого обращения к замеру.
+    StartupProfiler *profiler = StartupProfiler::instance();
+
     QCoreApplication::setApplicationName("TextEditor");
     QCoreApplication::applicationVersion();
 
+    // Пакетной подсветке дисплей не нужен: без явно заданной платформы окна не создаются.
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--batch") == 0 && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     QApplication a(argc, argv);
+    profiler->mark("application");
 
     QCommandLineParser parser;
     parser.setApplicationDescription(QCoreApplication::applicationName());
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addPositionalArgument("file", "The file to open.");
+    QCommandLineOption newInstanceOption(QStringList() << "n" << "new-instance",
+                                         "Start a new instance instead of using the running one.");
+    parser.addOption(newInstanceOption);
+    QCommandLineOption profileStartupOption("profile-startup",
+                                            "Print the duration of startup phases.");
+    parser.addOption(profileStartupOption);
+    QCommandLineOption batchOption("batch", "Highlight the files to HTML or ANSI without opening a window.");
+    parser.addOption(batchOption);
+    QCommandLineOption formatOption("format", "Batch output format: html or ansi.", "format", "html");
+    parser.addOption(formatOption);
+    QCommandLineOption styleOption("style", "Batch style: Default, ATB or a JSON style file.", "style", "Default");
+    parser.addOption(styleOption);
+    QCommandLineOption languageOption("language", "Batch language version: c89, cpp98 or cpp11.",
+                                      "language", "c89");
+    parser.addOption(languageOption);
+    QCommandLineOption outputOption(QStringList() << "o" << "output-dir",
+                                    "Write one batch output file per input file into the directory.",
+                                    "directory");
+    parser.addOption(outputOption);
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Number of batch highlighting threads.",
+                                  "count", QString::number(QThread::idealThreadCount()));
+    parser.addOption(jobsOption);
     parser.process(a);
+    if (parser.isSet(profileStartupOption))
+        profiler->setEnabled(true);
+
+    if (parser.isSet(batchOption)) {
+        BatchHighlighter batch;
+        const QString format = parser.value(formatOption);
+        if (format != "html" && format != "ansi") {
+            qCritical("Unknown format: %s", qPrintable(format));
+            return 2;
+        }
+        batch.setFormat(format == "html" ? BatchHighlighter::Html : BatchHighlighter::Ansi);
+        QString errorMessage;
+        if (!batch.setStyle(parser.value(styleOption), &errorMessage)) {
+            qCritical("Cannot read style %s: %s", qPrintable(parser.value(styleOption)), qPrintable(errorMessage));
+            return 2;
+        }
+        const QString language = parser.value(languageOption);
+        if (language == "cpp98")
+            batch.setLanguageVersion(LanguageVersion::CPP98_03);
+        else if (language == "cpp11")
+            batch.setLanguageVersion(LanguageVersion::CPP11);
+        else if (language != "c89") {
+            qCritical("Unknown language: %s", qPrintable(language));
+            return 2;
+        }
+        batch.setOutputDirectory(parser.value(outputOption));
+        batch.setThreadCount(parser.value(jobsOption).toInt());
+
+        // Выход после вывода последнего файла, уже из цикла событий.
+        QObject::connect(&batch, &BatchHighlighter::finished, &a, &QCoreApplication::exit, Qt::QueuedConnection);
+        batch.start(parser.positionalArguments());
+        return a.exec();
+    }
+
+    // Запущенный экземпляр работает в другом каталоге, поэтому пути передаются полными.
+    QStringList files;
+    for (const QString &file : parser.positionalArguments())
+        files.append(QFileInfo(file).absoluteFilePath());
+
+    // Если редактор уже запущен, файлы открываются в нем, а этот процесс завершается
+    // до создания главного окна.
+    const bool newInstance = parser.isSet(newInstanceOption);
+    if (!newInstance && SingleInstance::sendToRunning(files))
+        return 0;
+    profiler->mark("single instance");
 
     MainWindow mw;
+    profiler->mark("main window");
+
+    SingleInstance instance;
+    if (!newInstance && instance.listen())
+        QObject::connect(&instance, &SingleInstance::filesReceived, &mw, &MainWindow::openFiles);
 
     const QRect availableGeometry = mw.screen()->availableGeometry();
     mw.resize(availableGeometry.width() / 2, (availableGeometry.height() * 2) / 3);
@@ -25,7 +112,10 @@ int main(int argc, char *argv[])
             (availableGeometry.height() - mw.height()) / 2);
 
     mw.fileNew();
+    mw.openFiles(files);
+    profiler->mark("open files");
 
     mw.show();
+    profiler->mark("show");
     return a.exec();
 }
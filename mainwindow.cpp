@@ -3,8 +3,13 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), rsrcPath(":/images")
 {
+    StartupProfiler *profiler = StartupProfiler::instance();
+
     textEdit = new TextEditor(this);
+    // Подсветка собственного документа редактора: с нее берут настройки подсветки документов вкладок.
     highlighter = new Highlighter(textEdit->document());
+    textEdit->updateMinimapColors();
+    profiler->mark("editor");
 
     findEdit = new QLineEdit();
     findEdit->setPlaceholderText("Find");
@@ -12,7 +17,37 @@ MainWindow::MainWindow(QWidget *parent)
     replaceEdit->setPlaceholderText("Replace");
     isFirstChange = true;
 
-    setCentralWidget(textEdit);
+    // Дополнительные представления добавляются в разделитель рядом с основным редактором.
+    splitter = new QSplitter(Qt::Vertical);
+    splitter->addWidget(textEdit);
+
+    tabs = new DocumentTabs;
+
+    QWidget *central = new QWidget;
+    QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    layout->addWidget(tabs);
+    layout->addWidget(splitter);
+    central->setLayout(layout);
+    setCentralWidget(central);
+
+    searchResults = new SearchResultsPanel(this);
+    addDockWidget(Qt::BottomDockWidgetArea, searchResults);
+    searchResults->hide();
+    connect(searchResults, &SearchResultsPanel::resultActivated, this, &MainWindow::goToSearchResult);
+    connect(searchResults->getModel(), &SearchResultsModel::offsetsAppended, this,
+            [this](const QString &text, const QVector<quint32> &batch) {
+        for (TextEditor *editor : editors())
+            editor->getScrollBarMarkers()->addOffsets(ScrollBarMarkers::SearchHit, text, batch);
+    });
+
+    outline = new SymbolOutlinePanel(this);
+    addDockWidget(Qt::LeftDockWidgetArea, outline);
+    outline->hide();
+    outline->setDocument(textEdit->document());
+    connect(outline, &SymbolOutlinePanel::symbolActivated, this, &MainWindow::goToSymbol);
+    profiler->mark("docks");
 
     setToolButtonStyle(Qt::ToolButtonFollowStyle);
     setupFileActions();
@@ -21,17 +56,27 @@ MainWindow::MainWindow(QWidget *parent)
     setupViewActions();
     setupStatusbar();
     setupInfoActions();
+    profiler->mark("menus and toolbars");
+
+    connect(tabs, &DocumentTabs::documentCreated, this, &MainWindow::createHighlighter);
+    connect(tabs, &DocumentTabs::documentCreated, this, &MainWindow::applyEditorFont);
+
+    // Бюджет памяти разметки и форматов подсветки (MEMORY/ в settings.ini) действует для всех документов.
+    QSettings settings("settings.ini", QSettings::IniFormat);
+    isLowMemoryMode = settings.value("MEMORY/LowMemoryMode", false).toBool();
+    layoutBudget = qMax(1, settings.value("MEMORY/LayoutBudget", DefaultLayoutBudget).toInt());
+    connect(tabs, &DocumentTabs::documentCreated, this, &MainWindow::applyLayoutBudget);
+    applyLayoutBudget(textEdit->document());
+    connect(tabs, &QTabBar::currentChanged, this, &MainWindow::activateTab);
+    connect(tabs, &QTabBar::tabCloseRequested, this, &MainWindow::closeTab);
+    tabs->addDocument(QString());
+    profiler->mark("document tabs");
 
-    connect(textEdit->document(), &QTextDocument::modificationChanged,
-            actionSave, &QAction::setEnabled);
-    connect(textEdit->document(), &QTextDocument::modificationChanged,
-            this, &QWidget::setWindowModified);
-    connect(textEdit->document(), &QTextDocument::undoAvailable,
-            actionUndo, &QAction::setEnabled);
-    connect(textEdit->document(), &QTextDocument::redoAvailable,
-            actionRedo, &QAction::setEnabled);
     connect(textEdit, &QPlainTextEdit::textChanged,
             this, &MainWindow::updateStatistics);
+    connect(textEdit, &QPlainTextEdit::selectionChanged,
+            this, &MainWindow::scheduleStatistics);
+    connect(qApp, &QApplication::focusChanged, this, &MainWindow::editorFocusChanged);
 
 #ifndef QT_NO_CLIPBOARD
     actionCut->setEnabled(false);
@@ -41,9 +86,44 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(QApplication::clipboard(), &QClipboard::dataChanged, this, &MainWindow::clipboardDataChanged);
 #endif
+
+    textEdit->viewport()->installEventFilter(this);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event) {
+    if (event->type() == QEvent::Paint && watched == textEdit->viewport()) {
+        // Отложенная работа начинается, когда кадр уже выведен на экран.
+        textEdit->viewport()->removeEventFilter(this);
+        QTimer::singleShot(0, this, &MainWindow::finishStartup);
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::finishStartup() {
+    StartupProfiler *profiler = StartupProfiler::instance();
+    profiler->mark("first paint");
+
+    for (const QPair<QPointer<QObject>, QString> &icon : deferredIcons) {
+        if (icon.first && QIcon::hasThemeIcon(icon.second))
+            icon.first->setProperty("icon", QIcon::fromTheme(icon.second));
+    }
+    deferredIcons.clear();
+
+    // Замеры памяти для строки состояния не нужны до первой отрисовки.
+    connect(&memoryTimer, &QTimer::timeout, this, &MainWindow::sampleMemoryUsage);
+    memoryTimer.start(MemorySampleInterval);
+    sampleMemoryUsage();
+    profiler->mark("deferred initialization");
+
+    profiler->report();
+}
+
+void MainWindow::deferThemeIcon(QObject *target, const QString &themeName) {
+    deferredIcons.append(qMakePair(QPointer<QObject>(target), themeName));
 }
 
 void MainWindow::loadFile(const QString &fileName) {
+    TraceScope trace("MainWindow::loadFile");
     QFile file(fileName);
     if (!file.open(QFile::ReadOnly | QFile::Text)) {
         QMessageBox::warning(this, tr("Application"),
@@ -52,16 +132,48 @@ void MainWindow::loadFile(const QString &fileName) {
         return;
     }
 
+    // Уже открытый файл показывается в своей вкладке; перечитывается с диска
+    // только с подтверждения, иначе несохраненные изменения и история отмены были бы потеряны.
+    int index = tabs->indexOfFile(fileName);
+    if (index >= 0) {
+        tabs->setCurrentIndex(index);
+        if (tabs->currentIndex() != index)
+            return;
+        const QString question = textEdit->document()->isModified()
+                ? tr("%1 is already open and has unsaved changes.\n"
+                     "Reload it from disk and discard the changes?")
+                : tr("%1 is already open.\nReload it from disk?");
+        const QMessageBox::StandardButton answer = QMessageBox::question(
+                    this, tr("Application"), question.arg(QDir::toNativeSeparators(fileName)),
+                    QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+        if (answer != QMessageBox::Yes)
+            return;
+    } else {
+        // Пустая безымянная вкладка используется повторно.
+        const int current = tabs->currentIndex();
+        if (tabs->fileName(current).isEmpty() && !textEdit->document()->isModified()
+                && textEdit->document()->isEmpty())
+            index = current;
+        else
+            index = tabs->addDocument(fileName);
+        tabs->setCurrentIndex(index);
+    }
+
     QTextStream in(&file);
 #ifndef QT_NO_CURSOR
     QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 #endif
+    clearLineFilters();
     textEdit->setPlainText(in.readAll());
 #ifndef QT_NO_CURSOR
     QGuiApplication::restoreOverrideCursor();
 #endif
 
     setCurrentFileName(fileName);
+
+    // Дата изменения берется из файла, отложенная отметка о наборе текста не нужна.
+    UpdateScheduler::instance()->discard(UpdateScheduler::Title, this);
+    isFirstChange = false;
     if(QFileInfo(file).lastModified().date() == QDate::currentDate()){
         changeDate->setText("Changed: " + QFileInfo(file).lastModified().time().toString());
     }
@@ -71,7 +183,7 @@ void MainWindow::loadFile(const QString &fileName) {
 }
 
 void MainWindow::closeEvent(QCloseEvent *e)  {
-    if (maybeSave()) {
+    if (maybeSaveAll()) {
         saveSettings();
         e->accept();
     }
@@ -85,9 +197,12 @@ void MainWindow::saveSettings() {
     settings.setValue("MAIN/BackgroundColor", textEdit->getBackgroundColor());
     settings.setValue("MAIN/CurrentLineColor", textEdit->getCurrentLineColor());
     settings.setValue("DISPLAY/LineNumbering", actionLineNumbering->isChecked());
+    settings.setValue("DISPLAY/Minimap", actionMinimap->isChecked());
     settings.setValue("DISPLAY/Toolbar", actionToolbar->isChecked());
     settings.setValue("DISPLAY/Statusbar", actionStatusbar->isChecked());
     settings.setValue("DISPLAY/Highlighter", actionHighlighter->isChecked());
+    settings.setValue("MEMORY/LowMemoryMode", isLowMemoryMode);
+    settings.setValue("MEMORY/LayoutBudget", layoutBudget);
     if (c89->isChecked()) {
         settings.setValue("DISPLAY/LanguageVersion", "C89");
     }
@@ -107,20 +222,18 @@ void MainWindow::readStyleFromFile() {
 
     const QString f = fileDialog.selectedFiles().first();
 
-    if (!QFile::exists(f))
-        return;
-    QFile file(f);
-    if (!file.open(QFile::ReadOnly))
-        return;
-
-    QByteArray data = file.readAll();
-    QTextCodec *codec = Qt::codecForHtml(data);
-
-    std::istringstream stream(codec->toUnicode(data).toStdString());
     QString shortName = QFileInfo(f).baseName();
 
     if (!styleVersions.contains(shortName)) {
-        highlighter->setStyle(stream, shortName);
+        Style style;
+        QString errorMessage;
+        if (!StyleCache::instance()->load(f, &style, &errorMessage)) {
+            QMessageBox::warning(this, tr("Application"),
+                                 tr("Cannot read style %1:\n%2")
+                                 .arg(QDir::toNativeSeparators(f), errorMessage));
+            return;
+        }
+        highlighter->addStyle(shortName, style);
 
         QAction *a = editStyle->addAction(shortName);
         a->setCheckable(true);
@@ -134,7 +247,7 @@ void MainWindow::readStyleFromFile() {
     styleVersions.value(shortName)->setChecked(true);
     currentStyle = shortName;
 
-    highlighter->setDocument(textEdit->document());
+    updateHighlighters();
 }
 
 QString MainWindow::styleSaveAs() {
@@ -160,18 +273,29 @@ QString MainWindow::styleSaveAs() {
 }
 
 void MainWindow::fileNew() {
-    if (maybeSave()) {
-        textEdit->clear();
-        setCurrentFileName(QString());
-    }
+    // Пустая безымянная вкладка используется повторно.
+    const int current = tabs->currentIndex();
+    if (tabs->fileName(current).isEmpty() && !textEdit->document()->isModified()
+            && textEdit->document()->isEmpty())
+        return;
+
+    tabs->setCurrentIndex(tabs->addDocument(QString()));
+}
+
+void MainWindow::openFiles(const QStringList &files) {
+    for (const QString &file : files)
+        loadFile(file);
+
+    if (isMinimized())
+        showNormal();
+    raise();
+    activateWindow();
 }
 
 void MainWindow::fileOpen() {
-    if (maybeSave()) {
-        QString fileName = QFileDialog::getOpenFileName(this);
-        if (!fileName.isEmpty())
-            loadFile(fileName);
-    }
+    QString fileName = QFileDialog::getOpenFileName(this);
+    if (!fileName.isEmpty())
+        loadFile(fileName);
 }
 
 bool MainWindow::fileSave() {
@@ -197,16 +321,116 @@ void MainWindow::findText() {
     createFindDialog(findButton, false);
 
     highlighter->selectSearch(findEdit->text());
-    highlighter->setDocument(textEdit->document());
+    updateHighlighters();
+
+    for (TextEditor *editor : editors())
+        editor->getScrollBarMarkers()->clear(ScrollBarMarkers::SearchHit);
+    searchResults->getModel()->search(focusedEditor()->document(), findEdit->text());
+    if (!findEdit->text().isEmpty())
+        searchResults->show();
 }
 
 void MainWindow::replaceText() {
     QPushButton *findButton = new QPushButton("Find and replace");
     createFindDialog(findButton, true);
 
-    textEdit->replaceSearch(findEdit->text(), replaceEdit->text());
+    focusedEditor()->replaceSearch(findEdit->text(), replaceEdit->text());
     highlighter->selectSearch("");
-    highlighter->setDocument(textEdit->document());
+    updateHighlighters();
+}
+
+void MainWindow::replaceInFiles() {
+    ReplaceInFilesDialog dialog(findEdit->text(), replaceEdit->text(), this);
+    dialog.exec();
+
+    // Неизмененные вкладки измененных файлов перечитываются без вопроса, иначе их сохранение
+    // вернуло бы старый текст. Вкладки с несохраненными правками не трогаются.
+    QStringList unsaved;
+    for (const QString &changed : dialog.getChangedFiles()) {
+        const int index = tabs->indexOfFile(changed);
+        if (index < 0)
+            continue;
+        if (tabs->isModified(index)) {
+            unsaved.append(QDir::toNativeSeparators(tabs->fileName(index)));
+            continue;
+        }
+
+        // Фильтр строк относится к блокам прежнего текста.
+        if (index == tabs->currentIndex())
+            clearLineFilters();
+        QString errorMessage;
+        if (!tabs->reload(index, &errorMessage))
+            QMessageBox::warning(this, tr("Application"), errorMessage);
+    }
+
+    if (!unsaved.isEmpty()) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("These files were changed on disk but have unsaved changes in the editor.\n"
+                                "Saving them will overwrite the replacement:\n%1")
+                             .arg(unsaved.join('\n')));
+    }
+}
+
+void MainWindow::goToSearchResult(int position, int length) {
+    TextEditor *editor = focusedEditor();
+    const int end = editor->document()->characterCount() - 1;
+
+    QTextCursor cursor(editor->document());
+    cursor.setPosition(qMin(position, end));
+    cursor.setPosition(qMin(position + length, end), QTextCursor::KeepAnchor);
+    editor->setTextCursor(cursor);
+    editor->centerCursor();
+    editor->setFocus();
+}
+
+void MainWindow::goToSymbol(int line, int column) {
+    TextEditor *editor = focusedEditor();
+    QTextBlock block = editor->document()->findBlockByNumber(line);
+    if (!block.isValid())
+        return;
+
+    QTextCursor cursor(block);
+    cursor.setPosition(block.position() + qMin(column, block.length() - 1));
+    editor->setTextCursor(cursor);
+    editor->centerCursor();
+    editor->setFocus();
+}
+
+void MainWindow::showGoToSymbol() {
+    GoToSymbolDialog *dialog = new GoToSymbolDialog(SymbolIndex::forDocument(focusedEditor()->document()), this);
+    connect(dialog, &GoToSymbolDialog::symbolActivated, this, &MainWindow::goToSymbol);
+    dialog->show();
+}
+
+void MainWindow::filterLines() {
+    if (!actionFilterLines->isChecked()) {
+        clearLineFilters();
+        return;
+    }
+
+    bool pressOk;
+    QString pattern = QInputDialog::getText(this, tr("Filter lines"), tr("Show only lines containing:"),
+                                            QLineEdit::Normal, findEdit->text(), &pressOk);
+    if (!pressOk || pattern.isEmpty()) {
+        actionFilterLines->setChecked(false);
+        return;
+    }
+
+    // Фильтр действует в одном представлении - в том, где он включен последним.
+    TextEditor *filtered = focusedEditor();
+    for (TextEditor *editor : editors()) {
+        if (editor != filtered && editor->isLineFilterActive())
+            editor->setLineFilter(QString());
+    }
+    filtered->setLineFilter(pattern);
+}
+
+void MainWindow::clearLineFilters() {
+    actionFilterLines->setChecked(false);
+    for (TextEditor *editor : editors()) {
+        if (editor->isLineFilterActive())
+            editor->setLineFilter(QString());
+    }
 }
 
 void MainWindow::createFindDialog(QPushButton* findButton, bool needReplace) {
@@ -226,19 +450,172 @@ void MainWindow::createFindDialog(QPushButton* findButton, bool needReplace) {
     dialog->exec();
 }
 
-void MainWindow::setWordWrap() {
-    if (actionWordWrap->isChecked()) {
-        textEdit->setWordWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
-    } else {
-        textEdit->setWordWrapMode(QTextOption::NoWrap);
+void MainWindow::activateTab(int index) {
+    if (index < 0)
+        return;
+
+    QTextDocument *previous = textEdit->document();
+    const int previousIndex = tabs->indexOf(previous);
+    if (previousIndex >= 0 && previousIndex != index)
+        tabs->setViewState(previousIndex, textEdit->textCursor().position(), textEdit->verticalScrollBar()->value());
+
+    // Вкладка, файл которой не читается, остается выгруженной; редактор возвращается к прежней вкладке.
+    QString errorMessage;
+    QTextDocument *document = tabs->document(index, &errorMessage);
+    if (!document) {
+        if (previousIndex >= 0)
+            tabs->setCurrentIndex(previousIndex);
+        QMessageBox::warning(this, tr("Application"), errorMessage);
+        return;
     }
+    highlighter = document->findChild<Highlighter*>();
+    fileName = tabs->fileName(index);
+    updateWindowTitle();
+    if (document == previous)
+        return;
+
+    // Фильтр строк относится к блокам покидаемого документа.
+    clearLineFilters();
+    searchResults->getModel()->cancel();
+    searchResults->getModel()->clear();
+
+    // Подсветка строк, прерванная переключением, продолжится при возврате к вкладке.
+    if (previousIndex >= 0 && textEdit->isHighlightPending())
+        pendingHighlight.insert(previous);
+
+    // Собственный документ редактора удаляется при первом переключении, поэтому отключаемся заранее.
+    disconnect(previous, nullptr, this, nullptr);
+    for (TextEditor *editor : editors())
+        editor->setSharedDocument(document);
+    connectDocument(document);
+    outline->setDocument(document);
+    if (pendingHighlight.remove(document))
+        textEdit->highlightSkippedBlocks();
+
+    QTextCursor cursor(document);
+    cursor.setPosition(qMin(tabs->cursorPosition(index), document->characterCount() - 1));
+    textEdit->setTextCursor(cursor);
+    textEdit->verticalScrollBar()->setValue(tabs->scrollValue(index));
+
+    setWindowModified(document->isModified());
+    actionSave->setEnabled(document->isModified());
+    actionUndo->setEnabled(document->isUndoAvailable());
+    actionRedo->setEnabled(document->isRedoAvailable());
+    updateStatistics();
+}
+
+void MainWindow::closeTab(int index) {
+    // Вкладка, которую не удалось загрузить, не изменена (измененный текст хранится сжатым)
+    // и закрывается без вопроса.
+    tabs->setCurrentIndex(index);
+    if (tabs->currentIndex() == index && !maybeSave())
+        return;
+
+    // Документ закрываемой вкладки не должен оставаться в редакторе.
+    if (tabs->count() == 1)
+        tabs->setCurrentIndex(tabs->addDocument(QString()));
+    else if (index == tabs->currentIndex())
+        tabs->setCurrentIndex(index > 0 ? index - 1 : index + 1);
+    tabs->removeDocument(index);
+}
+
+void MainWindow::connectDocument(QTextDocument *document) {
+    connect(document, &QTextDocument::modificationChanged, this, [this](bool changed) {
+        actionSave->setEnabled(changed);
+        setWindowModified(changed);
+    });
+    connect(document, &QTextDocument::undoAvailable, this, [this](bool available) {
+        actionUndo->setEnabled(available);
+    });
+    connect(document, &QTextDocument::redoAvailable, this, [this](bool available) {
+        actionRedo->setEnabled(available);
+    });
+}
+
+void MainWindow::splitView() {
+    // Новое представление показывает тот же документ: копии текста и повторной подсветки нет.
+    TextEditor *view = new TextEditor(this);
+    view->setEditorFont(textEdit->font());
+    view->setSharedDocument(textEdit->document());
+    view->setBackgroundColor(textEdit->getBackgroundColor());
+    view->setCurrentLineColor(textEdit->getCurrentLineColor());
+    view->setLineNumberingActive(actionLineNumbering->isChecked());
+    view->setMinimapVisible(actionMinimap->isChecked());
+    view->setHudVisible(actionHud->isChecked());
+    view->setWordWrap(actionWordWrap->isChecked());
+
+    view->setTextCursor(focusedEditor()->textCursor());
+    connect(view, &QPlainTextEdit::copyAvailable, actionCut, &QAction::setEnabled);
+    connect(view, &QPlainTextEdit::copyAvailable, actionCopy, &QAction::setEnabled);
+    connect(view, &QPlainTextEdit::selectionChanged, this, &MainWindow::scheduleStatistics);
+
+    // Положение курсора в строке состояния показывается для представления с фокусом.
+    view->getCursorPos()->hide();
+    statusBar()->insertWidget(0, view->getCursorPos(), 1);
+
+    splitViews.append(view);
+    splitter->addWidget(view);
+    view->centerCursor();
+    view->setFocus();
+}
+
+void MainWindow::closeSplitView() {
+    if (splitViews.isEmpty())
+        return;
+
+    // Закрывается представление с фокусом, иначе последнее открытое.
+    TextEditor *view = focusedEditor();
+    if (view == textEdit)
+        view = splitViews.last();
+    splitViews.removeOne(view);
+
+    delete view->getCursorPos();
+    delete view;
+    textEdit->getCursorPos()->show();
+    textEdit->setFocus();
+}
+
+QVector<TextEditor*> MainWindow::editors() const {
+    return QVector<TextEditor*>() << textEdit << splitViews;
+}
+
+TextEditor* MainWindow::focusedEditor() const {
+    // Последний редактор с фокусом запоминается, поэтому действия из панелей и диалогов,
+    // забирающих фокус, тоже относятся к нему.
+    if (lastFocusedEditor && splitViews.contains(lastFocusedEditor.data()))
+        return lastFocusedEditor.data();
+    return textEdit;
+}
+
+void MainWindow::editorFocusChanged(QWidget *old, QWidget *now) {
+    Q_UNUSED(old);
+    TextEditor *focused = nullptr;
+    for (TextEditor *editor : editors()) {
+        if (now == editor)
+            focused = editor;
+    }
+    if (!focused || focused == lastFocusedEditor)
+        return;
+
+    lastFocusedEditor = focused;
+    for (TextEditor *editor : editors())
+        editor->getCursorPos()->setVisible(editor == focused);
+    scheduleStatistics();
+}
+
+void MainWindow::setWordWrap() {
+    for (TextEditor *editor : editors())
+        editor->setWordWrap(actionWordWrap->isChecked());
 }
 
 void MainWindow::setNewFont() {
     bool pressOk;
     QFont newFont = QFontDialog::getFont(&pressOk, textEdit->font());
     if(pressOk) {
-        textEdit->setFont(newFont);
+        for (TextEditor *editor : editors())
+            editor->setEditorFont(newFont);
+        for (QTextDocument *document : liveDocuments())
+            applyEditorFont(document);
     }
 }
 
@@ -248,7 +625,8 @@ void MainWindow::editBackgroundStyle() {
     Window *window = new Window(style, WindowType::BackgroundStyle);
 
     if(window->getIsSaved()) {
-        textEdit->setBackgroundColor(window->getNewStyle().keywordFormat.foreground().color());
+        for (TextEditor *editor : editors())
+            editor->setBackgroundColor(window->getNewStyle().keywordFormat.foreground().color());
     }
 }
 
@@ -258,7 +636,8 @@ void MainWindow::editCurrentLineStyle() {
     Window *window = new Window(style, WindowType::CurrentLineStyle);
 
     if(window->getIsSaved()) {
-        textEdit->setCurrentLineColor(window->getNewStyle().keywordFormat.foreground().color());
+        for (TextEditor *editor : editors())
+            editor->setCurrentLineColor(window->getNewStyle().keywordFormat.foreground().color());
     }
 }
 
@@ -279,7 +658,7 @@ void MainWindow::editTextStyle() {
             currentStyle = shortName;
 
             highlighter->setStyle(window->getNewStyle(), fileName);
-            highlighter->setDocument(textEdit->document());
+            updateHighlighters();
         }
     }
 }
@@ -289,18 +668,214 @@ void MainWindow::setNewStyle(QAction *action) {
         styleVersions.value(currentStyle)->setChecked(false);
         currentStyle = action->text();
         highlighter->setStyle(currentStyle);
-        highlighter->setDocument(textEdit->document());
+        updateHighlighters();
     }
 }
 
 void MainWindow::setLineNumberingActive() {
-    if (actionLineNumbering->isChecked()) {
-        textEdit->setLineNumberingActive(true);
-    } else {
-        textEdit->setLineNumberingActive(false);
+    for (TextEditor *editor : editors())
+        editor->setLineNumberingActive(actionLineNumbering->isChecked());
+}
+
+void MainWindow::setMinimapVisible() {
+    for (TextEditor *editor : editors())
+        editor->setMinimapVisible(actionMinimap->isChecked());
+}
+
+void MainWindow::setTraceEnabled() {
+    Trace::setEnabled(actionTrace->isChecked());
+}
+
+void MainWindow::exportTrace() {
+    QFileDialog fileDialog(this, tr("Export trace..."));
+    fileDialog.setAcceptMode(QFileDialog::AcceptSave);
+    fileDialog.setNameFilter(tr("Chrome trace (*.json)"));
+    fileDialog.setDefaultSuffix("json");
+    fileDialog.selectFile("trace.json");
+    if (fileDialog.exec() != QDialog::Accepted)
+        return;
+
+    const QString traceFileName = fileDialog.selectedFiles().first();
+    QString errorMessage;
+    if (!Trace::exportJson(traceFileName, &errorMessage)) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(traceFileName), errorMessage));
     }
 }
 
+void MainWindow::setHudVisible() {
+    for (TextEditor *editor : editors())
+        editor->setHudVisible(actionHud->isChecked());
+}
+
+void MainWindow::exportHudData() {
+    // Выгружаются кадры представления с фокусом ввода, иначе основного редактора.
+    TextEditor *current = textEdit;
+    for (TextEditor *editor : splitViews) {
+        if (editor->hasFocus())
+            current = editor;
+    }
+    PerformanceHud *hud = current->getPerformanceHud();
+    if (!hud) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Performance HUD has not been shown yet, there is no data to export."));
+        return;
+    }
+
+    QFileDialog fileDialog(this, tr("Export HUD data..."));
+    fileDialog.setAcceptMode(QFileDialog::AcceptSave);
+    fileDialog.setNameFilter(tr("CSV files (*.csv)"));
+    fileDialog.setDefaultSuffix("csv");
+    fileDialog.selectFile("hud.csv");
+    if (fileDialog.exec() != QDialog::Accepted)
+        return;
+
+    const QString csvFileName = fileDialog.selectedFiles().first();
+    QString errorMessage;
+    if (!hud->exportCsv(csvFileName, &errorMessage)) {
+        QMessageBox::warning(this, tr("Application"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(csvFileName), errorMessage));
+    }
+}
+
+void MainWindow::applyLayoutBudget(QTextDocument *document) {
+    LayoutBudget::forDocument(document)->setBudget(isLowMemoryMode ? qint64(layoutBudget) * 1024 * 1024 : 0);
+}
+
+void MainWindow::applyEditorFont(QTextDocument *document) {
+    // Шрифт и табуляция хранятся в документе: представления, показывающие документ, их не меняют.
+    const QFont font = textEdit->font();
+    if (document->defaultFont() != font)
+        document->setDefaultFont(font);
+
+    QTextOption option = document->defaultTextOption();
+    if (option.tabStopDistance() != textEdit->tabStopDistance()) {
+        option.setTabStopDistance(textEdit->tabStopDistance());
+        document->setDefaultTextOption(option);
+    }
+}
+
+void MainWindow::createHighlighter(QTextDocument *document) {
+    // У каждого документа своя подсветка, поэтому при переключении вкладок форматы строк сохраняются.
+    // Новый документ подсвечивается отложенно: при загрузке текста строки только размечаются.
+    Highlighter *documentHighlighter = new Highlighter();
+    documentHighlighter->copySettings(highlighter);
+    documentHighlighter->setDocumentDeferred(document);
+
+    // По окончании первого прохода строки подсвечиваются, начиная с видимых; у документа
+    // фоновой вкладки - при ее открытии.
+    connect(documentHighlighter, &Highlighter::deferredPassFinished, this, [this, document] {
+        if (textEdit->document() == document)
+            textEdit->highlightSkippedBlocks();
+        else
+            pendingHighlight.insert(document);
+    }, Qt::QueuedConnection);
+    connect(document, &QObject::destroyed, this, [this, document] {
+        pendingHighlight.remove(document);
+    });
+}
+
+void MainWindow::updateHighlighters() {
+    // Настройки меняются у подсветки текущего документа и переносятся на остальные невыгруженные
+    // документы; выгруженные получат их при создании.
+    for (QTextDocument *document : liveDocuments()) {
+        Highlighter *documentHighlighter = document->findChild<Highlighter*>();
+        if (!documentHighlighter)
+            continue;
+        if (documentHighlighter != highlighter)
+            documentHighlighter->copySettings(highlighter);
+        documentHighlighter->setDocument(document);
+    }
+    for (TextEditor *editor : editors())
+        editor->updateMinimapColors();
+}
+
+QVector<QTextDocument*> MainWindow::liveDocuments() const {
+    QVector<QTextDocument*> documents = tabs->liveDocuments();
+    if (!documents.contains(textEdit->document()))
+        documents.append(textEdit->document());
+    return documents;
+}
+
+void MainWindow::showMemoryUsage() {
+    MemoryUsage::Report report;
+    for (QTextDocument *document : liveDocuments())
+        report.add(MemoryUsage::forDocument(document)->estimate());
+
+    // Сжатый текст выгруженных вкладок - тоже хранение текста.
+    report.bytes[MemoryUsage::Text] += tabs->compressedSize();
+    for (TextEditor *editor : editors())
+        report.bytes[MemoryUsage::Caches] += editor->cacheMemoryUsage();
+
+    const qint64 total = report.total();
+    auto megabytes = [](qint64 bytes) {
+        return QString::number(bytes / 1048576.0, 'f', 1) + " MB";
+    };
+
+    QGridLayout *grid = new QGridLayout;
+    int row = 0;
+    auto addRow = [grid, &row](const QString &name, const QString &size, const QString &share) {
+        grid->addWidget(new QLabel(name), row, 0);
+        QLabel *sizeLabel = new QLabel(size);
+        sizeLabel->setAlignment(Qt::AlignRight);
+        grid->addWidget(sizeLabel, row, 1);
+        QLabel *shareLabel = new QLabel(share);
+        shareLabel->setAlignment(Qt::AlignRight);
+        grid->addWidget(shareLabel, row, 2);
+        ++row;
+    };
+    for (int component = 0; component < MemoryUsage::ComponentCount; ++component) {
+        const qint64 bytes = report.bytes[component];
+        addRow(MemoryUsage::componentName(MemoryUsage::Component(component)), megabytes(bytes),
+               QString::number(total > 0 ? 100.0 * bytes / total : 0, 'f', 1) + "%");
+    }
+    addRow(tr("Estimated total"), megabytes(total), QString());
+
+    // Остаток - Qt, шрифты, накладные расходы кучи и то, что оценкой не учтено.
+    const qint64 resident = MemoryUsage::residentSize();
+    if (resident >= 0) {
+        addRow(tr("Process resident"), megabytes(resident), QString());
+        addRow(tr("Other"), megabytes(qMax(qint64(0), resident - total)), QString());
+    }
+
+    QBoxLayout *boxLayout = new QBoxLayout(QBoxLayout::TopToBottom);
+    boxLayout->addWidget(new QLabel(tr("%1 live documents, %2 unloaded tabs")
+                                    .arg(liveDocuments().size()).arg(tabs->count() - tabs->liveCount())));
+    if (isLowMemoryMode)
+        boxLayout->addWidget(new QLabel(tr("Low memory mode: layouts and formats limited to %1 MB per document")
+                                        .arg(layoutBudget)));
+    boxLayout->addLayout(grid);
+
+    QDialog *dialog = new QDialog(this);
+    dialog->setWindowTitle(tr("Memory usage"));
+    dialog->setModal(true);
+
+    QPushButton *closeButton = new QPushButton(tr("Close"));
+    boxLayout->addWidget(closeButton);
+    connect(closeButton, SIGNAL(clicked()), dialog, SLOT(accept()));
+
+    dialog->setLayout(boxLayout);
+
+    dialog->exec();
+    delete dialog;
+}
+
+void MainWindow::sampleMemoryUsage() {
+    // Полная оценка перебирает все строки, поэтому в строке состояния только дешевые величины.
+    qint64 text = tabs->compressedSize();
+    for (QTextDocument *document : liveDocuments())
+        text += MemoryUsage::forDocument(document)->textSize();
+
+    const qint64 resident = MemoryUsage::residentSize();
+    QString status = "Text: " + QString::number(text / 1048576.0, 'f', 1) + "MB";
+    if (resident >= 0)
+        status = "Memory: " + QString::number(resident / 1048576.0, 'f', 1) + "MB, text: "
+                 + QString::number(text / 1048576.0, 'f', 1) + "MB";
+    memoryStatus->setText(status);
+}
+
 void MainWindow::setToolbarActive() {
     if (actionToolbar->isChecked()) {
         tb1->setVisible(true);
@@ -327,18 +902,26 @@ void MainWindow::setHighlighterActive() {
     } else {
         highlighter->setActive(false);
     }
-    highlighter->setDocument(textEdit->document());
+    updateHighlighters();
 }
 
+// Статистика и дата изменения обновляются планировщиком один раз за кадр,
+// а не на каждое изменение текста.
 void MainWindow::updateStatistics() {
-    int words = textEdit->toPlainText().split(
-            QRegExp("(\\s|\\n|\\r|\\t)+"), Qt::SkipEmptyParts
-        ).count();
-    int symbols = textEdit->toPlainText().length();
-    statistics->setText("Rows: "      + QString::number(textEdit->blockCount()) +
-                        ", words: "   + QString::number(words) +
-                        ", symbols: " + QString::number(symbols) +
-                        ", size: "    + QString::number((symbols*1000/1024)/1000.) + "KB");
+    TraceScope trace("MainWindow::updateStatistics");
+    scheduleStatistics();
+    UpdateScheduler::instance()->markDirty(UpdateScheduler::Title, this, [this]() {
+        showChangeDate();
+    });
+}
+
+void MainWindow::scheduleStatistics() {
+    UpdateScheduler::instance()->markDirty(UpdateScheduler::Statistics, this, [this]() {
+        showStatistics();
+    });
+}
+
+void MainWindow::showChangeDate() {
     if (!isFirstChange) {
         changeDate->setText("Changed: " + QTime::currentTime().toString());
     } else {
@@ -346,12 +929,30 @@ void MainWindow::updateStatistics() {
     }
 }
 
+void MainWindow::showStatistics() {
+    TraceScope trace("MainWindow::showStatistics");
+    // Счетчики поддерживаются инкрементально, текст документа здесь не перебирается.
+    DocumentStatistics *documentStatistics = DocumentStatistics::forDocument(focusedEditor()->document());
+    qint64 symbols = documentStatistics->characterCount();
+
+    QString text = "Rows: "      + QString::number(documentStatistics->lineCount()) +
+                   ", words: "   + QString::number(documentStatistics->wordCount()) +
+                   ", symbols: " + QString::number(symbols) +
+                   ", size: "    + QString::number((symbols*1000/1024)/1000.) + "KB";
+
+    QTextCursor cursor = focusedEditor()->textCursor();
+    if (cursor.hasSelection())
+        text += ", selected words: " + QString::number(DocumentStatistics::selectionWordCount(cursor));
+
+    statistics->setText(text);
+}
+
 void MainWindow::setC89() {
     cpp98_03->setChecked(false);
     cpp11->setChecked(false);
     if (c89->isChecked()) {
         highlighter->setLanguageVersion(LanguageVersion::C89);
-        highlighter->setDocument(textEdit->document());
+        updateHighlighters();
     } else {
         c89->setChecked(true);
     }
@@ -361,7 +962,7 @@ void MainWindow::setCPP98_03() {
     cpp11->setChecked(false);
     if (cpp98_03->isChecked()) {
         highlighter->setLanguageVersion(LanguageVersion::CPP98_03);
-        highlighter->setDocument(textEdit->document());
+        updateHighlighters();
     } else {
         cpp98_03->setChecked(true);
     }
@@ -371,7 +972,7 @@ void MainWindow::setCPP11() {
     cpp98_03->setChecked(false);
     if (cpp11->isChecked()) {
         highlighter->setLanguageVersion(LanguageVersion::CPP11);
-        highlighter->setDocument(textEdit->document());
+        updateHighlighters();
     } else {
         cpp11->setChecked(true);
     }
@@ -408,26 +1009,30 @@ void MainWindow::setupFileActions()
     tb1 = addToolBar(tr("File Actions"));
     QMenu *menu = menuBar()->addMenu(tr("&File"));
 
-    const QIcon newIcon = QIcon::fromTheme("document-new", QIcon(rsrcPath + "/filenew.png"));
+    const QIcon newIcon(rsrcPath + "/filenew.png");
     QAction *a = menu->addAction(newIcon,  tr("&New"), this, &MainWindow::fileNew);
+    deferThemeIcon(a, "document-new");
     tb1->addAction(a);
     a->setShortcut(QKeySequence::New);
 
-    const QIcon openIcon = QIcon::fromTheme("document-open", QIcon(rsrcPath + "/fileopen.png"));
+    const QIcon openIcon(rsrcPath + "/fileopen.png");
     a = menu->addAction(openIcon, tr("&Open..."), this, &MainWindow::fileOpen);
+    deferThemeIcon(a, "document-open");
     a->setShortcut(QKeySequence::Open);
     tb1->addAction(a);
 
     menu->addSeparator();
 
-    const QIcon saveIcon = QIcon::fromTheme("document-save", QIcon(rsrcPath + "/filesave.png"));
+    const QIcon saveIcon(rsrcPath + "/filesave.png");
     actionSave = menu->addAction(saveIcon, tr("&Save"), this, &MainWindow::fileSave);
+    deferThemeIcon(actionSave, "document-save");
     actionSave->setShortcut(QKeySequence::Save);
     actionSave->setEnabled(false);
     tb1->addAction(actionSave);
 
-    const QIcon saveAsIcon = QIcon::fromTheme("document-saveAs", QIcon(rsrcPath + "/filesaveas.png"));
+    const QIcon saveAsIcon(rsrcPath + "/filesaveas.png");
     a = menu->addAction(saveAsIcon, tr("Save &As..."), this, &MainWindow::fileSaveAs);
+    deferThemeIcon(a, "document-saveAs");
     menu->addSeparator();
 
     a = menu->addAction(tr("&Quit"), this, &QWidget::close);
@@ -438,30 +1043,35 @@ void MainWindow::setupEditActions() {
     tb2 = addToolBar(tr("Edit Actions"));
     QMenu *menu = menuBar()->addMenu(tr("&Edit"));
 
-    const QIcon undoIcon = QIcon::fromTheme("edit-undo", QIcon(rsrcPath + "/editundo.png"));
-    actionUndo = menu->addAction(undoIcon, tr("&Undo"), textEdit, &QPlainTextEdit::undo);
+    const QIcon undoIcon(rsrcPath + "/editundo.png");
+    actionUndo = menu->addAction(undoIcon, tr("&Undo"), this, [this] { focusedEditor()->undo(); });
+    deferThemeIcon(actionUndo, "edit-undo");
     actionUndo->setShortcut(QKeySequence::Undo);
     tb2->addAction(actionUndo);
 
-    const QIcon redoIcon = QIcon::fromTheme("edit-redo", QIcon(rsrcPath + "/editredo.png"));
-    actionRedo = menu->addAction(redoIcon, tr("&Redo"), textEdit, &QPlainTextEdit::redo);
+    const QIcon redoIcon(rsrcPath + "/editredo.png");
+    actionRedo = menu->addAction(redoIcon, tr("&Redo"), this, [this] { focusedEditor()->redo(); });
+    deferThemeIcon(actionRedo, "edit-redo");
     actionRedo->setShortcut(QKeySequence::Redo);
     tb2->addAction(actionRedo);
     menu->addSeparator();
 
 #ifndef QT_NO_CLIPBOARD
-    const QIcon cutIcon = QIcon::fromTheme("edit-cut", QIcon(rsrcPath + "/editcut.png"));
-    actionCut = menu->addAction(cutIcon, tr("&Cut"), textEdit, &QPlainTextEdit::cut);
+    const QIcon cutIcon(rsrcPath + "/editcut.png");
+    actionCut = menu->addAction(cutIcon, tr("&Cut"), this, [this] { focusedEditor()->cut(); });
+    deferThemeIcon(actionCut, "edit-cut");
     actionCut->setShortcut(QKeySequence::Cut);
     tb2->addAction(actionCut);
 
-    const QIcon copyIcon = QIcon::fromTheme("edit-copy", QIcon(rsrcPath + "/editcopy.png"));
-    actionCopy = menu->addAction(copyIcon, tr("&Copy"), textEdit, &QPlainTextEdit::copy);
+    const QIcon copyIcon(rsrcPath + "/editcopy.png");
+    actionCopy = menu->addAction(copyIcon, tr("&Copy"), this, [this] { focusedEditor()->copy(); });
+    deferThemeIcon(actionCopy, "edit-copy");
     actionCopy->setShortcut(QKeySequence::Copy);
     tb2->addAction(actionCopy);
 
-    const QIcon pasteIcon = QIcon::fromTheme("edit-paste", QIcon(rsrcPath + "/editpaste.png"));
-    actionPaste = menu->addAction(pasteIcon, tr("&Paste"), textEdit, &QPlainTextEdit::paste);
+    const QIcon pasteIcon(rsrcPath + "/editpaste.png");
+    actionPaste = menu->addAction(pasteIcon, tr("&Paste"), this, [this] { focusedEditor()->paste(); });
+    deferThemeIcon(actionPaste, "edit-paste");
     actionPaste->setShortcut(QKeySequence::Paste);
     tb2->addAction(actionPaste);
     if (const QMimeData *md = QApplication::clipboard()->mimeData())
@@ -472,32 +1082,51 @@ void MainWindow::setupEditActions() {
     QToolButton *findButtons = new QToolButton();
     findButtons->setPopupMode(QToolButton::MenuButtonPopup);
 
-    const QIcon findIcon = QIcon::fromTheme("edit-find", QIcon(rsrcPath + "/editfind.png"));
+    const QIcon findIcon(rsrcPath + "/editfind.png");
     actionFind = new QAction(findIcon, tr("&Find"));
+    deferThemeIcon(actionFind, "edit-find");
     actionFind->setShortcut(QKeySequence::Find);
     connect(actionFind, SIGNAL(triggered()), this, SLOT(findText()));
 
-    const QIcon findAndReplaceIcon = QIcon::fromTheme("edit-findAndReplace", QIcon(rsrcPath + "/editfindandreplace.png"));
+    const QIcon findAndReplaceIcon(rsrcPath + "/editfindandreplace.png");
     actionFindAndReplace = new QAction(findAndReplaceIcon, tr("&Find and replace"));
+    deferThemeIcon(actionFindAndReplace, "edit-findAndReplace");
     actionFindAndReplace->setShortcut(QKeySequence::Replace);
     connect(actionFindAndReplace, SIGNAL(triggered()), this, SLOT(replaceText()));
 
-    const QIcon findMenuIcon = QIcon::fromTheme("edit-findMenu", QIcon(rsrcPath + "/editfindmenu.png"));
+    actionReplaceInFiles = new QAction(findAndReplaceIcon, tr("&Replace in files..."));
+    actionReplaceInFiles->setShortcut(Qt::CTRL + Qt::SHIFT + Qt::Key_H);
+    connect(actionReplaceInFiles, SIGNAL(triggered()), this, SLOT(replaceInFiles()));
+
+    const QIcon findMenuIcon(rsrcPath + "/editfindmenu.png");
     QMenu *findMenu = new QMenu();
 
     findMenu->setIcon(findMenuIcon);
+    deferThemeIcon(findMenu, "edit-findMenu");
     findMenu->setTitle("Find / Find and replace");
     findMenu->addAction(actionFind);
     findMenu->addAction(actionFindAndReplace);
+    findMenu->addAction(actionReplaceInFiles);
 
     findButtons->setMenu(findMenu);
     findButtons->setIcon(findMenuIcon);
     menu->addMenu(findMenu);
     tb3->addWidget(findButtons);
 
-    const QIcon selectAllIcon = QIcon::fromTheme("edit-selectAll", QIcon(rsrcPath + "/editselectall.png"));
-    actionSelectAll = menu->addAction(selectAllIcon, tr("&SelectAll"), textEdit, &QPlainTextEdit::selectAll);
+    const QIcon selectAllIcon(rsrcPath + "/editselectall.png");
+    actionSelectAll = menu->addAction(selectAllIcon, tr("&SelectAll"), this, [this] { focusedEditor()->selectAll(); });
+    deferThemeIcon(actionSelectAll, "edit-selectAll");
     actionSelectAll->setShortcut(QKeySequence::SelectAll);
+
+    actionFilterLines = menu->addAction(tr("F&ilter lines..."), this, &MainWindow::filterLines);
+    actionFilterLines->setCheckable(true);
+    actionFilterLines->setShortcut(Qt::CTRL + Qt::SHIFT + Qt::Key_L);
+
+    QAction *a = menu->addAction(tr("&Jump to matching bracket"), this, [this] { focusedEditor()->jumpToMatchingBracket(); });
+    a->setShortcut(Qt::CTRL + Qt::Key_BracketRight);
+
+    a = menu->addAction(tr("Go to &symbol..."), this, &MainWindow::showGoToSymbol);
+    a->setShortcut(Qt::CTRL + Qt::SHIFT + Qt::Key_O);
 }
 
 void MainWindow::setupFormatActions() {
@@ -530,6 +1159,31 @@ void MainWindow::setupViewActions() {
     actionStatusbar    ->setChecked(true);
     actionHighlighter  ->setChecked(true);
 
+    menu->addAction(searchResults->toggleViewAction());
+    menu->addAction(outline->toggleViewAction());
+
+    actionMinimap = menu->addAction(tr("&Minimap"), this, &MainWindow::setMinimapVisible);
+    actionMinimap->setCheckable(true);
+    actionMinimap->setChecked(true);
+
+    // Трассировка пишет интервалы горячих путей; экспорт открывается в chrome://tracing.
+    actionTrace = menu->addAction(tr("&Trace hot paths"), this, &MainWindow::setTraceEnabled);
+    actionTrace->setCheckable(true);
+    actionTrace->setChecked(Trace::isEnabled());
+    menu->addAction(tr("E&xport trace..."), this, &MainWindow::exportTrace);
+
+    // Наложение с задержкой ввода и временем этапов отрисовки; данные выгружаются в CSV.
+    actionHud = menu->addAction(tr("Performance &HUD"), this, &MainWindow::setHudVisible);
+    actionHud->setCheckable(true);
+    menu->addAction(tr("Export HUD &data..."), this, &MainWindow::exportHudData);
+    menu->addAction(tr("M&emory usage..."), this, &MainWindow::showMemoryUsage);
+
+    QAction *a = menu->addAction(tr("S&plit view"), this, &MainWindow::splitView);
+    a->setShortcut(Qt::CTRL + Qt::Key_Backslash);
+
+    a = menu->addAction(tr("Close split vie&w"), this, &MainWindow::closeSplitView);
+    a->setShortcut(Qt::CTRL + Qt::SHIFT + Qt::Key_Backslash);
+
     languageVersions = new QMenu("Language versions");
 
     c89 = languageVersions->addAction(tr("&C89"), this, &MainWindow::setC89);
@@ -549,7 +1203,7 @@ void MainWindow::setupViewActions() {
     editStyle->addAction(tr("&Edit"), this, &MainWindow::editTextStyle);
     editStyle->addAction(tr("&Load from file"), this, &MainWindow::readStyleFromFile);
 
-    QAction *a = editStyle->addAction("Default");
+    a = editStyle->addAction("Default");
     a->setCheckable(true);
     a->setChecked(true);
     styleVersions.insert(a->text(), a);
@@ -572,6 +1226,7 @@ void MainWindow::setupStatusbar() {
     saveDate   = new QLabel(this);
     changeDate = new QLabel(this);
     statistics = new QLabel(this);
+    memoryStatus = new QLabel(this);
 
     saveDate->setText("Saved: None");
     changeDate->setText("Changed: None");
@@ -580,6 +1235,18 @@ void MainWindow::setupStatusbar() {
     statusBar()->addWidget(saveDate, 2);
     statusBar()->addWidget(changeDate, 2);
     statusBar()->addWidget(statistics, 3);
+    statusBar()->addWidget(memoryStatus, 2);
+}
+
+bool MainWindow::maybeSaveAll() {
+    for (int i = 0; i < tabs->count(); ++i) {
+        if (!tabs->isModified(i))
+            continue;
+        tabs->setCurrentIndex(i);
+        if (!maybeSave())
+            return false;
+    }
+    return true;
 }
 
 bool MainWindow::maybeSave() {
@@ -600,8 +1267,13 @@ bool MainWindow::maybeSave() {
 
 void MainWindow::setCurrentFileName(const QString &newFileName) {
     fileName = newFileName;
+    tabs->setFileName(tabs->currentIndex(), fileName);
     textEdit->document()->setModified(false);
+    updateWindowTitle();
+    setWindowModified(false);
+}
 
+void MainWindow::updateWindowTitle() {
     QString shownName;
     if (fileName.isEmpty())
         shownName = "untitled.txt";
@@ -612,11 +1284,11 @@ void MainWindow::setCurrentFileName(const QString &newFileName) {
         shownName = shownName.left(32) + "...";
     }
     setWindowTitle(tr("[*]%1 - %2").arg(shownName, QCoreApplication::applicationName()));
-    setWindowModified(false);
 }
 
 bool MainWindow::saveFile(const QString &fileName)
 {
+    TraceScope trace("MainWindow::saveFile");
     saveDate->setText("Saved: " + QTime::currentTime().toString());
     changeDate->setText("Changed: None");
     QString errorMessage;
@@ -4,6 +4,15 @@
 #include "TextEdit.h"
 #include "HighLighter.h"
 #include "ColorListEditor.h"
+#include "FileReplacer.h"
+#include "SearchResults.h"
+#include "SymbolOutline.h"
+#include "DocumentStatistics.h"
+#include "DocumentTabs.h"
+#include "StartupProfiler.h"
+#include "StyleCache.h"
+#include "Trace.h"
+#include "MemoryUsage.h"
 
 #include <QClipboard>
 #include <QApplication>
@@ -22,9 +31,13 @@
 #include <QDialog>
 #include <QFileDialog>
 #include <QBoxLayout>
+#include <QGridLayout>
+#include <QTimer>
+#include <QSet>
 #include <QByteArray>
 #include <QMouseEvent>
 #include <QTextCodec>
+#include <QMessageBox>
 #include <QStringList>
 #include <QCloseEvent>
 #include <QMenu>
@@ -32,9 +45,12 @@
 #include <QIcon>
 #include <QLineEdit>
 #include <QToolButton>
+#include <QInputDialog>
+#include <QSplitter>
+#include <QPointer>
+#include <QPair>
 
 #include <QSettings>
-#include <sstream>
 
 class MainWindow : public QMainWindow
 {
@@ -49,6 +65,9 @@ public:
 protected:    
     void closeEvent(QCloseEvent *e) override;
 
+    // Первая отрисовка редактора завершает запуск.
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
     void saveSettings();
 
@@ -59,6 +78,9 @@ private:
 public slots:
     void fileNew();
 
+    // Файлы, переданные при запуске или другим запуском редактора.
+    void openFiles(const QStringList &files);
+
 private slots:
     void fileOpen();
 
@@ -70,6 +92,25 @@ private slots:
 
     void replaceText();
 
+    void replaceInFiles();
+
+    void goToSearchResult(int position, int length);
+
+    void filterLines();
+
+    void goToSymbol(int line, int column);
+
+    void showGoToSymbol();
+
+    // Переключение редактора и панелей на документ вкладки.
+    void activateTab(int index);
+
+    void closeTab(int index);
+
+    void splitView();
+
+    void closeSplitView();
+
     void createFindDialog(QPushButton* findButton, bool needReplace);
 
     void setWordWrap();
@@ -86,6 +127,22 @@ private slots:
 
     void setLineNumberingActive();
 
+    void setMinimapVisible();
+
+    void setTraceEnabled();
+
+    void exportTrace();
+
+    void setHudVisible();
+
+    void exportHudData();
+
+    // Оценка памяти по составляющим для всех невыгруженных документов.
+    void showMemoryUsage();
+
+    // Резидентная память процесса и объем текста в строке состояния.
+    void sampleMemoryUsage();
+
     void setToolbarActive();
 
     void setStatusbarActive();
@@ -94,6 +151,12 @@ private slots:
 
     void updateStatistics();
 
+    void showStatistics();
+
+    void scheduleStatistics();
+
+    void showChangeDate();
+
     void setC89();
     void setCPP98_03();
     void setCPP11();
@@ -115,12 +178,60 @@ private:
 
     bool maybeSave();
 
+    // Вопрос о сохранении для каждой измененной вкладки.
+    bool maybeSaveAll();
+
+    // Подключение действий окна к сигналам документа активной вкладки.
+    void connectDocument(QTextDocument *document);
+
+    void updateWindowTitle();
+
     void setCurrentFileName(const QString &newFileName);
 
     bool saveFile(const QString &fileName);
 
     void clipboardDataChanged();
 
+    // Иконка темы ищется в системных темах медленно, поэтому при запуске ставится
+    // иконка из ресурсов, а иконка темы подменяет ее после первой отрисовки.
+    void deferThemeIcon(QObject *target, const QString &themeName);
+
+    // Инициализация, отложенная до первой отрисовки.
+    void finishStartup();
+
+    // Основной редактор и дополнительные представления того же документа.
+    QVector<TextEditor*> editors() const;
+
+    // Редактор с фокусом, к которому относятся действия меню Edit; без фокуса - основной.
+    TextEditor* focusedEditor() const;
+
+    // Запоминает редактор, получивший фокус, и показывает положение его курсора.
+    void editorFocusChanged(QWidget *old, QWidget *now);
+
+    // Выключение фильтра строк во всех представлениях.
+    void clearLineFilters();
+
+    // Невыгруженные документы вкладок и документ основного редактора.
+    QVector<QTextDocument*> liveDocuments() const;
+
+    // Период обновления памяти в строке состояния, мс.
+    static const int MemorySampleInterval = 2000;
+
+    // Бюджет разметки и форматов документа в режиме малой памяти.
+    void applyLayoutBudget(QTextDocument *document);
+
+    // Шрифт и табуляция основного редактора для документа вкладки.
+    void applyEditorFont(QTextDocument *document);
+
+    // Подсветка нового документа с текущими настройками.
+    void createHighlighter(QTextDocument *document);
+
+    // Перенос настроек подсветки текущего документа на все невыгруженные документы и их подсветка.
+    void updateHighlighters();
+
+    // Бюджет по умолчанию, МБ.
+    static const int DefaultLayoutBudget = 64;
+
 private:
     QAction *actionSave;
     QAction *actionUndo;
@@ -132,8 +243,13 @@ private:
 #endif
     QAction *actionFind;
     QAction *actionFindAndReplace;
+    QAction *actionReplaceInFiles;
     QAction *actionSelectAll;
+    QAction *actionFilterLines;
     QAction *actionWordWrap;
+    QAction *actionMinimap;
+    QAction *actionTrace;
+    QAction *actionHud;
     QAction *actionLineNumbering;
     QAction *actionToolbar;
     QAction *actionStatusbar;
@@ -149,6 +265,10 @@ private:
     QLabel *saveDate;
     QLabel *changeDate;
     QLabel *statistics;
+    QLabel *memoryStatus;
+    QTimer memoryTimer;
+    bool isLowMemoryMode;
+    int layoutBudget;
     bool isFirstChange;
 
     QLineEdit *findEdit;
@@ -162,7 +282,19 @@ private:
     QString fileName;
 
     TextEditor *textEdit;
+    DocumentTabs *tabs;
+    QSplitter *splitter;
+    QVector<TextEditor*> splitViews;
+    // Последний редактор с фокусом; см. focusedEditor().
+    QPointer<TextEditor> lastFocusedEditor;
+
+    // Подсветка текущего документа; у каждого документа своя.
     Highlighter *highlighter;
+    // Документы, подсветка строк которых не закончена и продолжится при открытии вкладки.
+    QSet<QTextDocument*> pendingHighlight;
+    SearchResultsPanel *searchResults;
+    SymbolOutlinePanel *outline;
     const QString rsrcPath;
+    QVector<QPair<QPointer<QObject>, QString>> deferredIcons;
 };
 #endif // MAINWINDOW_H